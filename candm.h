@@ -540,7 +540,8 @@ typedef struct {
 #define RPY_SERVER_STATS3 24
 #define RPY_SERVER_STATS4 25
 #define RPY_NTP_DATA2 26
-#define N_REPLY_TYPES 27
+#define RPY_SERVER_STATS5 27
+#define N_REPLY_TYPES 28
 
 /* Status codes */
 #define STT_SUCCESS 0
@@ -692,6 +693,7 @@ typedef struct {
   Integer64 ntp_kernel_tx_timestamps;
   Integer64 ntp_hw_rx_timestamps;
   Integer64 ntp_hw_tx_timestamps;
+  Integer64 ntp_rx_batches[9];
   Integer64 reserved[4];
   int32_t EOR;
 } RPY_ServerStats;
@@ -2664,7 +2664,7 @@ process_cmd_serverstats(char *line)
   CMD_Reply reply;
 
   request.command = htons(REQ_SERVER_STATS);
-  if (!request_reply(&request, &reply, RPY_SERVER_STATS4, 0))
+  if (!request_reply(&request, &reply, RPY_SERVER_STATS5, 0))
     return 0;
 
   print_report("NTP packets received       : %Q\n"
@@ -2683,7 +2683,16 @@ process_cmd_serverstats(char *line)
                "NTP kernel RX timestamps   : %Q\n"
                "NTP kernel TX timestamps   : %Q\n"
                "NTP hardware RX timestamps : %Q\n"
-               "NTP hardware TX timestamps : %Q\n",
+               "NTP hardware TX timestamps : %Q\n"
+               "NTP RX batches of 1        : %Q\n"
+               "NTP RX batches of 2-3      : %Q\n"
+               "NTP RX batches of 4-7      : %Q\n"
+               "NTP RX batches of 8-15     : %Q\n"
+               "NTP RX batches of 16-31    : %Q\n"
+               "NTP RX batches of 32-63    : %Q\n"
+               "NTP RX batches of 64-127   : %Q\n"
+               "NTP RX batches of 128-255  : %Q\n"
+               "NTP RX batches of 256      : %Q\n",
                UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_hits),
                UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_drops),
                UTI_Integer64NetworkToHost(reply.data.server_stats.cmd_hits),
@@ -2701,6 +2710,15 @@ process_cmd_serverstats(char *line)
                UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_kernel_tx_timestamps),
                UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_hw_rx_timestamps),
                UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_hw_tx_timestamps),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[0]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[1]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[2]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[3]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[4]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[5]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[6]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[7]),
+               UTI_Integer64NetworkToHost(reply.data.server_stats.ntp_rx_batches[8]),
                REPORT_END);
 
   return 1;
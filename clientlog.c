@@ -45,38 +45,69 @@
 #include "util.h"
 #include "logging.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define MAX_SERVICES 3
 
 typedef struct {
   IPAddr ip_addr;
   uint32_t last_hit[MAX_SERVICES];
+} Record;
+
+/* Counters and state of the rate limiting of a record.  They are kept in
+   a separate array indexed like the records to keep the records compared
+   in lookups small (two records per cache line). */
+typedef struct {
   uint32_t hits[MAX_SERVICES];
   uint16_t drops[MAX_SERVICES];
   uint16_t tokens[MAX_SERVICES];
   int8_t rate[MAX_SERVICES];
   int8_t ntp_timeout_rate;
   uint8_t drop_flags;
-} Record;
-
-/* Hash table of records, there is a fixed number of records per slot */
-static ARR_Instance records;
+} Counters;
 
 #define SLOT_BITS 3
 
 /* Number of records in one slot of the hash table */
 #define SLOT_SIZE (1U << SLOT_BITS)
 
+/* Fingerprints of the addresses (zero for an empty record) and times of
+   the last hit of any service of the records in one slot.  They are kept
+   separately from the records in one cache line to not need to access the
+   records when looking for an address, or a record to be replaced. */
+typedef struct {
+  uint32_t fingerprints[SLOT_SIZE];
+  uint32_t last_hits[SLOT_SIZE];
+} Slot;
+
+#define CACHE_LINE_SIZE 64
+
+/* Number of slots of the old tables migrated on each lookup */
+#define MIGRATION_SLOTS 4
+
 /* Minimum number of slots */
 #define MIN_SLOTS 1
 
 /* Maximum number of slots, this is a hard limit */
 #define MAX_SLOTS (1U << (24 - SLOT_BITS))
 
-/* Number of slots in the hash table */
-static unsigned int slots;
+/* Maximum number of old tables, which have 1 to MAX_SLOTS / 2 slots */
+#define MAX_OLD_TABLES (24 - SLOT_BITS)
 
-/* Maximum number of slots given memory allocation limit */
+/* Maximum number of slots in the current tables of all shards given memory
+   allocation limit, and the current number of slots in all shards.  The
+   limit is shared by the shards to not have a full shard while others still
+   have memory.  The old tables are included in the number of allocated slots,
+   which has a separate limit. */
 static unsigned int max_slots;
+static unsigned int total_slots;
+static unsigned int max_allocated_slots;
+static unsigned int allocated_slots;
+static int slots_lock;
 
 /* Times of last hits are saved as 32-bit fixed point values */
 #define TS_FRAC 4
@@ -156,7 +187,6 @@ typedef struct {
   double slew_offset;
 } NtpTimestampMap;
 
-static NtpTimestampMap ntp_ts_map;
 
 /* Maximum interval of NTP timestamps in future after a backward step */
 #define NTPTS_FUTURE_LIMIT (1LL << 32) /* 1 second */
@@ -167,12 +197,70 @@ static NtpTimestampMap ntp_ts_map;
 /* Maximum expected value of the timestamp source */
 #define MAX_NTP_TS NTP_TS_HARDWARE
 
-/* Global statistics */
+/* Hash table which was replaced by an expanded table */
+typedef struct {
+  ARR_Instance records;
+  ARR_Instance counters;
+  Slot *slot_table;
+  void *slot_table_buffer;
+  unsigned int slots;
+} OldTable;
+
+/* The log is divided into shards.  Each shard owns a part of the hash space
+   of the addresses and has its own hash table, timestamps of clients using
+   the interleaved mode, and statistics.  A client always maps to the same
+   shard, i.e. the rate limiting is not affected by the number of shards.
+   The records and statistics of a shard are protected by its lock, which
+   allows the server threads to log their clients.  The timestamps are used
+   only in the main thread. */
+typedef struct {
+  int lock;
+
+  /* Hash table of records, there is a fixed number of records per slot,
+     and their counters */
+  ARR_Instance records;
+  ARR_Instance counters;
+
+  /* Array of slots aligned to the cache line size, and its allocated buffer */
+  Slot *slot_table;
+  void *slot_table_buffer;
+
+  /* Number of slots in the hash table */
+  unsigned int slots;
+
+  /* Previous hash tables (starting with the oldest one), which are migrated
+     to the next table in small steps after expansion to avoid long delays in
+     processing of requests, and the number of slots of the oldest table
+     migrated in order.  There is more than one old table only if the table
+     had to be expanded again before the previous migration was finished. */
+  OldTable old_tables[MAX_OLD_TABLES];
+  unsigned int n_old_tables;
+  unsigned int migrated_slots;
+
+  NtpTimestampMap ntp_ts_map;
+
+  /* Random bits for the rate limiting */
+  uint32_t random_bits;
+  int random_bits_left;
+
+  /* Statistics */
+  uint64_t hits[MAX_SERVICES];
+  uint64_t drops[MAX_SERVICES];
+  uint64_t record_drops;
+  uint64_t slot_migrations;
+} Shard;
+
+/* Maximum number of shards */
+#define MAX_SHARDS 16
+
+static Shard *shards;
+static unsigned int n_shards;
+
+/* Global statistics (hits of clients which are not logged are counted only
+   in the main thread) */
 static uint64_t total_hits[MAX_SERVICES];
-static uint64_t total_drops[MAX_SERVICES];
 static uint64_t total_ntp_auth_hits;
 static uint64_t total_ntp_interleaved_hits;
-static uint64_t total_record_drops;
 static uint64_t total_ntp_rx_timestamps[MAX_NTP_TS + 1];
 static uint64_t total_ntp_tx_timestamps[MAX_NTP_TS + 1];
 
@@ -180,7 +268,7 @@ static uint64_t total_ntp_tx_timestamps[MAX_NTP_TS + 1];
 
 /* ================================================== */
 
-static int expand_hashtable(void);
+static int expand_hashtable(Shard *shard);
 static void handle_slew(struct timespec *raw, struct timespec *cooked, double dfreq,
                         double doffset, LCL_ChangeType change_type, void *anything);
 
@@ -199,7 +287,7 @@ compare_ts(uint32_t x, uint32_t y)
 /* ================================================== */
 
 static int
-compare_total_hits(Record *x, Record *y)
+compare_total_hits(Counters *x, Counters *y)
 {
   uint32_t x_hits, y_hits;
   int i;
@@ -232,70 +320,370 @@ is_ip_equal(const IPAddr *a, const IPAddr *b)
 
 /* ================================================== */
 
-static Record *
-get_record(IPAddr *ip)
+static uint32_t
+get_fingerprint(uint32_t hash)
+{
+  /* Zero is reserved for empty records */
+  return hash ? hash : 1;
+}
+
+/* ================================================== */
+
+static unsigned int
+find_fingerprint(Slot *slot, uint32_t fingerprint)
+{
+  unsigned int mask;
+
+#if defined(__SSE2__) && SLOT_BITS == 3
+  __m128i x, a, b;
+
+  x = _mm_set1_epi32(fingerprint);
+  a = _mm_cmpeq_epi32(_mm_load_si128((__m128i *)slot->fingerprints), x);
+  b = _mm_cmpeq_epi32(_mm_load_si128((__m128i *)slot->fingerprints + 1), x);
+  mask = _mm_movemask_ps(_mm_castsi128_ps(a)) | _mm_movemask_ps(_mm_castsi128_ps(b)) << 4;
+#elif defined(__ARM_NEON) && defined(__aarch64__) && SLOT_BITS == 3
+  static const uint32_t bits[4] = {1, 2, 4, 8};
+  uint32x4_t x, a, b, m;
+
+  x = vdupq_n_u32(fingerprint);
+  m = vld1q_u32(bits);
+  a = vandq_u32(vceqq_u32(vld1q_u32(slot->fingerprints), x), m);
+  b = vandq_u32(vceqq_u32(vld1q_u32(slot->fingerprints + 4), x), m);
+  mask = vaddvq_u32(a) | vaddvq_u32(b) << 4;
+#else
+  unsigned int i;
+
+  for (i = mask = 0; i < SLOT_SIZE; i++) {
+    if (slot->fingerprints[i] == fingerprint)
+      mask |= 1U << i;
+  }
+#endif
+
+  /* Return a bit mask of records with the fingerprint */
+  return mask;
+}
+
+/* ================================================== */
+
+static unsigned int
+get_first_bit(unsigned int mask)
 {
-  uint32_t last_hit = 0, oldest_hit = 0;
-  Record *record, *oldest_record;
-  unsigned int first, i, j;
+  unsigned int i;
+
+  for (i = 0; !(mask & 1U << i); i++)
+    ;
+
+  return i;
+}
+
+/* ================================================== */
+
+static Shard *
+get_shard(uint32_t fingerprint)
+{
+  /* Use the upper bits of the fingerprint, the lower bits select the slot */
+  return &shards[(uint64_t)fingerprint * n_shards >> 32];
+}
+
+/* ================================================== */
+
+static Slot *
+get_slot(Shard *shard, unsigned int index)
+{
+  return &shard->slot_table[index / SLOT_SIZE];
+}
+
+/* ================================================== */
+
+static Counters *
+get_counters(Shard *shard, Record *record)
+{
+  /* The record must be in the current table */
+  return ARR_GetElement(shard->counters, record - (Record *)ARR_GetElements(shard->records));
+}
+
+/* ================================================== */
+
+static void
+update_last_hit(Shard *shard, Record *record, unsigned int index)
+{
+  uint32_t last_hit;
+  int i;
+
+  for (i = 1, last_hit = record->last_hit[0]; i < MAX_SERVICES; i++) {
+    if (compare_ts(last_hit, record->last_hit[i]) < 0)
+      last_hit = record->last_hit[i];
+  }
+
+  get_slot(shard, index)->last_hits[index % SLOT_SIZE] = last_hit;
+}
+
+/* ================================================== */
+
+static unsigned int
+find_oldest_record(Shard *shard, Slot *slot, unsigned int first)
+{
+  unsigned int i, oldest;
+  Counters *slot_counters;
+  int r;
+
+  slot_counters = (Counters *)ARR_GetElements(shard->counters) + first;
+
+  for (i = 1, oldest = 0; i < SLOT_SIZE; i++) {
+    r = compare_ts(slot->last_hits[oldest], slot->last_hits[i]);
+    if (r > 0 || (r == 0 && compare_total_hits(&slot_counters[oldest],
+                                               &slot_counters[i]) > 0))
+      oldest = i;
+  }
+
+  return oldest;
+}
+
+/* ================================================== */
+/* Simple spin lock.  The locked sections are short and the lock is not
+   contended at all if no server threads are running.  If the lock is not
+   released after a number of spins (e.g. the thread holding it was
+   preempted), sleep to not waste the CPU. */
+
+#define LOCK_SPINS 256
+#define LOCK_SLEEP 10000
+
+static void
+relax_cpu(void)
+{
+#if defined(__SSE2__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+/* ================================================== */
+
+static void
+acquire_lock(int *lock)
+{
+  struct timespec ts;
+  int spins;
+
+  while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+    for (spins = 0; __atomic_load_n(lock, __ATOMIC_RELAXED); spins++) {
+      if (spins < LOCK_SPINS) {
+        relax_cpu();
+      } else {
+        ts.tv_sec = 0;
+        ts.tv_nsec = LOCK_SLEEP;
+        nanosleep(&ts, NULL);
+      }
+    }
+  }
+}
+
+/* ================================================== */
+
+static void
+release_lock(int *lock)
+{
+  __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+/* ================================================== */
+
+static void
+migrate_slot(Shard *shard, unsigned int table, unsigned int index)
+{
+  ARR_Instance records, counters;
+  unsigned int i, j, first, slots;
+  Slot *old_slot, *slot_table;
+  OldTable *old_table, *next;
+  uint32_t fingerprint;
+
+  old_table = &shard->old_tables[table];
+  old_slot = &old_table->slot_table[index];
+
+  /* Migrate to the next old table, or the current table */
+  if (table + 1 < shard->n_old_tables) {
+    next = &shard->old_tables[table + 1];
+    records = next->records;
+    counters = next->counters;
+    slot_table = next->slot_table;
+    slots = next->slots;
+  } else {
+    records = shard->records;
+    counters = shard->counters;
+    slot_table = shard->slot_table;
+    slots = shard->slots;
+  }
+
+  shard->slot_migrations++;
+
+  for (i = 0; i < SLOT_SIZE; i++) {
+    fingerprint = old_slot->fingerprints[i];
+    if (fingerprint == 0)
+      continue;
+
+    /* Records of the old slot are split between two slots of the next table,
+       which cannot get any other records before the old slot is migrated */
+    first = fingerprint % slots * SLOT_SIZE;
+    j = get_first_bit(find_fingerprint(&slot_table[first / SLOT_SIZE], 0));
+    assert(j < SLOT_SIZE);
+
+    slot_table[first / SLOT_SIZE].fingerprints[j] = fingerprint;
+    slot_table[first / SLOT_SIZE].last_hits[j] = old_slot->last_hits[i];
+    *(Record *)ARR_GetElement(records, first + j) =
+      *(Record *)ARR_GetElement(old_table->records, index * SLOT_SIZE + i);
+    *(Counters *)ARR_GetElement(counters, first + j) =
+      *(Counters *)ARR_GetElement(old_table->counters, index * SLOT_SIZE + i);
+
+    old_slot->fingerprints[i] = 0;
+  }
+}
+
+/* ================================================== */
+
+static void
+migrate_address_slots(Shard *shard, uint32_t fingerprint)
+{
+  unsigned int i;
+
+  /* Move the records of the address through all old tables to the current
+     table, starting with the oldest table */
+  for (i = 0; i < shard->n_old_tables; i++)
+    migrate_slot(shard, i, fingerprint % shard->old_tables[i].slots);
+}
+
+/* ================================================== */
+
+static void
+free_old_table(Shard *shard)
+{
+  OldTable *table = &shard->old_tables[0];
+
+  acquire_lock(&slots_lock);
+  allocated_slots -= table->slots;
+  release_lock(&slots_lock);
+
+  ARR_DestroyInstance(table->records);
+  ARR_DestroyInstance(table->counters);
+  Free(table->slot_table_buffer);
+
+  shard->n_old_tables--;
+  memmove(&shard->old_tables[0], &shard->old_tables[1],
+          shard->n_old_tables * sizeof (shard->old_tables[0]));
+  shard->migrated_slots = 0;
+}
+
+/* ================================================== */
+
+static void
+migrate_slots(Shard *shard, unsigned int n)
+{
+  /* Only the oldest table is migrated in order as the other tables
+     can get records from the older tables */
+  while (n > 0 && shard->n_old_tables > 0) {
+    for (; n > 0 && shard->migrated_slots < shard->old_tables[0].slots;
+         n--, shard->migrated_slots++)
+      migrate_slot(shard, 0, shard->migrated_slots);
+
+    if (shard->migrated_slots < shard->old_tables[0].slots)
+      return;
+
+    free_old_table(shard);
+  }
+}
+
+/* ================================================== */
+
+static Shard *
+lock_shard(IPAddr *ip, uint32_t *fingerprint)
+{
+  Shard *shard;
 
   if (!active || (ip->family != IPADDR_INET4 && ip->family != IPADDR_INET6))
     return NULL;
 
-  while (1) {
-    /* Get index of the first record in the slot */
-    first = UTI_IPToHash(ip) % slots * SLOT_SIZE;
+  /* The fingerprint is used also as the hash to not need to compute it
+     again when migrating the record to a new table */
+  *fingerprint = get_fingerprint(UTI_IPToHash(ip));
 
-    for (i = 0, oldest_record = NULL; i < SLOT_SIZE; i++) {
-      record = ARR_GetElement(records, first + i);
+  shard = get_shard(*fingerprint);
+  acquire_lock(&shard->lock);
 
-      if (is_ip_equal(ip, &record->ip_addr))
-        return record;
+  return shard;
+}
 
-      if (record->ip_addr.family == IPADDR_UNSPEC)
-        break;
+/* ================================================== */
 
-      last_hit = record->last_hit[0];
-      for (j = 1; j < MAX_SERVICES; j++) {
-        if (compare_ts(last_hit, record->last_hit[j]) < 0)
-          last_hit = record->last_hit[j];
-      }
+static void
+unlock_shard(Shard *shard)
+{
+  release_lock(&shard->lock);
+}
 
-      if (!oldest_record || compare_ts(oldest_hit, last_hit) > 0 ||
-          (oldest_hit == last_hit && compare_total_hits(oldest_record, record) > 0)) {
-        oldest_record = record;
-        oldest_hit = last_hit;
-      }
+/* ================================================== */
+
+static Record *
+get_record(Shard *shard, IPAddr *ip, uint32_t fingerprint)
+{
+  unsigned int first, i, mask;
+  Counters *counters;
+  Record *record;
+  Slot *slot;
+
+  migrate_slots(shard, MIGRATION_SLOTS);
+
+  while (1) {
+    /* Make sure the records of the address are in the current table */
+    migrate_address_slots(shard, fingerprint);
+
+    /* Get index of the first record in the slot */
+    first = fingerprint % shard->slots * SLOT_SIZE;
+    slot = get_slot(shard, first);
+
+    /* Check records with a matching fingerprint */
+    for (mask = find_fingerprint(slot, fingerprint); mask; mask &= mask - 1) {
+      record = ARR_GetElement(shard->records, first + get_first_bit(mask));
+      if (is_ip_equal(ip, &record->ip_addr))
+        return record;
     }
 
     /* If the slot still has an empty record, use it */
-    if (record->ip_addr.family == IPADDR_UNSPEC)
+    mask = find_fingerprint(slot, 0);
+    if (mask) {
+      i = get_first_bit(mask);
       break;
+    }
 
     /* Resize the table if possible and try again as the new slot may
        have some empty records */
-    if (expand_hashtable())
+    if (expand_hashtable(shard))
       continue;
 
     /* There is no other option, replace the oldest record */
-    record = oldest_record;
-    total_record_drops++;
+    i = find_oldest_record(shard, slot, first);
+    shard->record_drops++;
     break;
   }
 
+  slot->fingerprints[i] = fingerprint;
+  slot->last_hits[i] = INVALID_TS;
+
+  record = ARR_GetElement(shard->records, first + i);
   record->ip_addr = *ip;
   for (i = 0; i < MAX_SERVICES; i++)
     record->last_hit[i] = INVALID_TS;
+
+  counters = get_counters(shard, record);
   for (i = 0; i < MAX_SERVICES; i++)
-    record->hits[i] = 0;
+    counters->hits[i] = 0;
   for (i = 0; i < MAX_SERVICES; i++)
-    record->drops[i] = 0;
+    counters->drops[i] = 0;
   for (i = 0; i < MAX_SERVICES; i++)
-    record->tokens[i] = max_tokens[i];
+    counters->tokens[i] = max_tokens[i];
   for (i = 0; i < MAX_SERVICES; i++)
-    record->rate[i] = INVALID_RATE;
-  record->ntp_timeout_rate = INVALID_RATE;
-  record->drop_flags = 0;
+    counters->rate[i] = INVALID_RATE;
+  counters->ntp_timeout_rate = INVALID_RATE;
+  counters->drop_flags = 0;
 
   return record;
 }
@@ -303,46 +691,120 @@ get_record(IPAddr *ip)
 /* ================================================== */
 
 static int
-expand_hashtable(void)
+get_index(Shard *shard, Record *record)
 {
-  ARR_Instance old_records;
-  Record *old_record, *new_record;
-  unsigned int i;
+  /* Indices of the shards are interleaved */
+  return (record - (Record *)ARR_GetElements(shard->records)) * n_shards +
+         (shard - shards);
+}
 
-  old_records = records;
+/* ================================================== */
 
-  if (2 * slots > max_slots)
-    return 0;
+static Record *
+get_shard_record_by_index(Shard *shard, unsigned int index, Counters **counters)
+{
+  unsigned int i, size = ARR_GetSize(shard->records);
+  OldTable *table;
+
+  if (index < size) {
+    if (get_slot(shard, index)->fingerprints[index % SLOT_SIZE] == 0)
+      return NULL;
+    *counters = ARR_GetElement(shard->counters, index);
+    return ARR_GetElement(shard->records, index);
+  }
 
-  records = ARR_CreateInstance(sizeof (Record));
+  /* Records of the old tables follow the records of the current table */
+  for (i = 0, index -= size; i < shard->n_old_tables; i++, index -= size) {
+    table = &shard->old_tables[i];
+    size = table->slots * SLOT_SIZE;
+    if (index >= size)
+      continue;
 
-  slots = MAX(MIN_SLOTS, 2 * slots);
-  assert(slots <= max_slots);
+    if (table->slot_table[index / SLOT_SIZE].fingerprints[index % SLOT_SIZE] == 0)
+      return NULL;
+    *counters = ARR_GetElement(table->counters, index);
+    return ARR_GetElement(table->records, index);
+  }
+
+  return NULL;
+}
 
-  ARR_SetSize(records, slots * SLOT_SIZE);
 
-  /* Mark all new records as empty */
-  for (i = 0; i < slots * SLOT_SIZE; i++) {
-    new_record = ARR_GetElement(records, i);
-    new_record->ip_addr.family = IPADDR_UNSPEC;
+/* ================================================== */
+
+static int
+expand_hashtable(Shard *shard)
+{
+  ARR_Instance records, counters;
+  unsigned int slots, new_slots;
+  void *slot_table_buffer;
+  OldTable *table;
+
+  slots = shard->slots;
+  new_slots = MAX(MIN_SLOTS, 2 * slots);
+  if (new_slots > MAX_SLOTS)
+    return 0;
+
+  /* If a slot is full before the previous migration is finished, keep the
+     old tables and migrate them later.  They are limited by the memory which
+     is reserved for one old table in all shards, i.e. a record can be
+     replaced below the limit only if the table is expanded again when it is
+     close to the maximum size. */
+  acquire_lock(&slots_lock);
+  if (total_slots + new_slots - slots > max_slots ||
+      allocated_slots + new_slots > max_allocated_slots) {
+    release_lock(&slots_lock);
+    return 0;
   }
+  total_slots += new_slots - slots;
+  allocated_slots += new_slots;
+  release_lock(&slots_lock);
 
-  if (!old_records)
-    return 1;
+  /* Allocate the new table without holding the lock of the shard to not
+     block server threads.  Records of the new table are not initialised and
+     the slot table is zeroed by the allocator (i.e. all records are empty)
+     to avoid touching the whole memory at once. */
+  release_lock(&shard->lock);
 
-  /* Copy old records to the new hash table */
-  for (i = 0; i < ARR_GetSize(old_records); i++) {
-    old_record = ARR_GetElement(old_records, i);
-    if (old_record->ip_addr.family == IPADDR_UNSPEC)
-      continue;
+  records = ARR_CreateInstance(sizeof (Record));
+  ARR_SetSize(records, new_slots * SLOT_SIZE);
+  counters = ARR_CreateInstance(sizeof (Counters));
+  ARR_SetSize(counters, new_slots * SLOT_SIZE);
+  slot_table_buffer = Calloc(new_slots + 1, sizeof (Slot));
 
-    new_record = get_record(&old_record->ip_addr);
+  acquire_lock(&shard->lock);
 
-    assert(new_record);
-    *new_record = *old_record;
+  /* If another thread expanded the table in the meantime, drop the new table
+     and let the caller look for an empty record again */
+  if (shard->slots != slots) {
+    ARR_DestroyInstance(records);
+    ARR_DestroyInstance(counters);
+    Free(slot_table_buffer);
+
+    acquire_lock(&slots_lock);
+    total_slots -= new_slots - slots;
+    allocated_slots -= new_slots;
+    release_lock(&slots_lock);
+
+    return 1;
+  }
+
+  if (shard->records) {
+    assert(shard->n_old_tables < MAX_OLD_TABLES);
+    table = &shard->old_tables[shard->n_old_tables++];
+    table->records = shard->records;
+    table->counters = shard->counters;
+    table->slot_table = shard->slot_table;
+    table->slot_table_buffer = shard->slot_table_buffer;
+    table->slots = shard->slots;
   }
 
-  ARR_DestroyInstance(old_records);
+  shard->slots = new_slots;
+  shard->records = records;
+  shard->counters = counters;
+  shard->slot_table_buffer = slot_table_buffer;
+  shard->slot_table = (Slot *)(((uintptr_t)shard->slot_table_buffer + CACHE_LINE_SIZE - 1) &
+                               ~(uintptr_t)(CACHE_LINE_SIZE - 1));
 
   return 1;
 }
@@ -380,6 +842,8 @@ void
 CLG_Initialise(void)
 {
   int i, interval, burst, lrate, krate, slots2;
+  unsigned int slot_size;
+  Shard *shard;
 
   for (i = 0; i < MAX_SERVICES; i++) {
     max_tokens[i] = 0;
@@ -421,34 +885,40 @@ CLG_Initialise(void)
     return;
   }
 
-  /* Calculate the maximum number of slots that can be allocated in the
-     configured memory limit.  Take into account expanding of the hash
-     table where two copies exist at the same time. */
-  max_slots = CNF_GetClientLogLimit() /
-              ((sizeof (Record) + sizeof (NtpTimestamps)) * SLOT_SIZE * 3 / 2);
-  max_slots = CLAMP(MIN_SLOTS, max_slots, MAX_SLOTS);
-  for (slots2 = 0; 1U << (slots2 + 1) <= max_slots; slots2++)
+  /* Use a shard for each thread which can answer requests */
+  for (n_shards = 1; n_shards < CNF_GetServerThreads() + 1 && n_shards < MAX_SHARDS; )
+    n_shards *= 2;
+
+  /* Calculate the maximum number of slots that can be allocated in all
+     shards in the configured memory limit.  Take into account expanding of
+     the hash table where two copies exist at the same time. */
+  slot_size = (sizeof (Record) + sizeof (Counters) + sizeof (NtpTimestamps)) * SLOT_SIZE +
+              sizeof (Slot);
+  max_slots = CNF_GetClientLogLimit() / (slot_size * 3 / 2);
+  max_slots = CLAMP(n_shards * MIN_SLOTS, max_slots, n_shards * MAX_SLOTS);
+  max_allocated_slots = max_slots + max_slots / 2;
+  total_slots = allocated_slots = 0;
+
+  /* Split the maximum number of timestamps equally */
+  for (slots2 = 0; 1U << (slots2 + 1) <= max_slots / n_shards; slots2++)
     ;
 
-  DEBUG_LOG("Max records %u", 1U << (slots2 + SLOT_BITS));
+  DEBUG_LOG("Shards %u max slots %u", n_shards, max_slots);
 
-  slots = 0;
-  records = NULL;
+  shards = MallocArray(Shard, n_shards);
+  memset(shards, 0, sizeof (Shard) * n_shards);
 
-  expand_hashtable();
+  for (i = 0; i < n_shards; i++) {
+    shard = &shards[i];
+    acquire_lock(&shard->lock);
+    expand_hashtable(shard);
+    release_lock(&shard->lock);
+    shard->ntp_ts_map.max_size = 1U << (slots2 + SLOT_BITS);
+  }
 
   UTI_GetRandomBytes(&ts_offset, sizeof (ts_offset));
   ts_offset %= NSEC_PER_SEC / (1U << TS_FRAC);
 
-  ntp_ts_map.timestamps = NULL;
-  ntp_ts_map.first = 0;
-  ntp_ts_map.size = 0;
-  ntp_ts_map.max_size = 1U << (slots2 + SLOT_BITS);
-  ntp_ts_map.cached_index = 0;
-  ntp_ts_map.cached_rx_ts = 0ULL;
-  ntp_ts_map.slew_epoch = 0;
-  ntp_ts_map.slew_offset = 0.0;
-
   LCL_AddParameterChangeHandler(handle_slew, NULL);
 }
 
@@ -457,12 +927,24 @@ CLG_Initialise(void)
 void
 CLG_Finalise(void)
 {
+  Shard *shard;
+  unsigned int i;
+
   if (!active)
     return;
 
-  ARR_DestroyInstance(records);
-  if (ntp_ts_map.timestamps)
-    ARR_DestroyInstance(ntp_ts_map.timestamps);
+  for (i = 0; i < n_shards; i++) {
+    shard = &shards[i];
+    ARR_DestroyInstance(shard->records);
+    ARR_DestroyInstance(shard->counters);
+    Free(shard->slot_table_buffer);
+    while (shard->n_old_tables > 0)
+      free_old_table(shard);
+    if (shard->ntp_ts_map.timestamps)
+      ARR_DestroyInstance(shard->ntp_ts_map.timestamps);
+  }
+
+  Free(shards);
 
   LCL_RemoveParameterChangeHandler(handle_slew, NULL);
 }
@@ -487,17 +969,21 @@ get_ts_from_timespec(struct timespec *ts)
 /* ================================================== */
 
 static void
-update_record(CLG_Service service, Record *record, struct timespec *now)
+update_record(CLG_Service service, Shard *shard, Record *record, struct timespec *now)
 {
   uint32_t interval, now_ts, prev_hit, tokens;
   int interval2, tshift, mtokens;
+  Counters *counters;
   int8_t *rate;
 
   now_ts = get_ts_from_timespec(now);
+  counters = get_counters(shard, record);
 
   prev_hit = record->last_hit[service];
   record->last_hit[service] = now_ts;
-  record->hits[service]++;
+  counters->hits[service]++;
+
+  update_last_hit(shard, record, record - (Record *)ARR_GetElements(shard->records));
 
   interval = now_ts - prev_hit;
 
@@ -513,7 +999,7 @@ update_record(CLG_Service service, Record *record, struct timespec *now)
     tokens = mtokens;
   else
     tokens = (now_ts - prev_hit) << -tshift;
-  record->tokens[service] = MIN(record->tokens[service] + tokens, mtokens);
+  counters->tokens[service] = MIN(counters->tokens[service] + tokens, mtokens);
 
   /* Convert the interval to scaled and rounded log2 */
   if (interval) {
@@ -530,8 +1016,8 @@ update_record(CLG_Service service, Record *record, struct timespec *now)
 
   /* For the NTP service, update one of the two rates depending on whether
      the previous request of the client had a reply or it timed out */
-  rate = service == CLG_NTP && record->drop_flags & (1U << service) ?
-           &record->ntp_timeout_rate : &record->rate[service];
+  rate = service == CLG_NTP && counters->drop_flags & (1U << service) ?
+           &counters->ntp_timeout_rate : &counters->rate[service];
 
   /* Update the rate in a rough approximation of exponential moving average */
   if (*rate == INVALID_RATE) {
@@ -550,24 +1036,22 @@ update_record(CLG_Service service, Record *record, struct timespec *now)
 
 /* ================================================== */
 
-static int
-get_index(Record *record)
-{
-  return record - (Record *)ARR_GetElements(records);
-}
-
-/* ================================================== */
-
 int
 CLG_GetClientIndex(IPAddr *client)
 {
-  Record *record;
+  uint32_t fingerprint;
+  Shard *shard;
+  int index;
 
-  record = get_record(client);
-  if (record == NULL)
+  shard = lock_shard(client, &fingerprint);
+  if (!shard)
     return -1;
 
-  return get_index(record);
+  index = get_index(shard, get_record(shard, client, fingerprint));
+
+  unlock_shard(shard);
+
+  return index;
 }
 
 /* ================================================== */
@@ -580,101 +1064,171 @@ check_service_number(CLG_Service service)
 
 /* ================================================== */
 
+static Record *
+log_service_access(CLG_Service service, Shard *shard, IPAddr *client, uint32_t fingerprint,
+                   struct timespec *now)
+{
+  Record *record;
+
+  shard->hits[service]++;
+
+  record = get_record(shard, client, fingerprint);
+  update_record(service, shard, record, now);
+
+  return record;
+}
+
+/* ================================================== */
+
 int
 CLG_LogServiceAccess(CLG_Service service, IPAddr *client, struct timespec *now)
 {
+  uint32_t fingerprint;
+  Counters *counters;
   Record *record;
+  Shard *shard;
+  int index;
 
   check_service_number(service);
 
-  total_hits[service]++;
-
-  record = get_record(client);
-  if (record == NULL)
+  shard = lock_shard(client, &fingerprint);
+  if (!shard) {
+    total_hits[service]++;
     return -1;
+  }
 
-  update_record(service, record, now);
+  record = log_service_access(service, shard, client, fingerprint, now);
 
+  counters = get_counters(shard, record);
   DEBUG_LOG("service %d hits %"PRIu32" rate %d trate %d tokens %d",
-            (int)service, record->hits[service], record->rate[service],
-            service == CLG_NTP ? record->ntp_timeout_rate : INVALID_RATE,
-            record->tokens[service]);
+            (int)service, counters->hits[service], counters->rate[service],
+            service == CLG_NTP ? counters->ntp_timeout_rate : INVALID_RATE,
+            counters->tokens[service]);
 
-  return get_index(record);
+  index = get_index(shard, record);
+
+  unlock_shard(shard);
+
+  return index;
 }
 
 /* ================================================== */
 
 static int
-limit_response_random(int rate)
+limit_response_random(Shard *shard, int rate)
 {
-  static uint32_t rnd;
-  static int bits_left = 0;
   int r;
 
-  if (bits_left < rate) {
-    UTI_GetRandomBytes(&rnd, sizeof (rnd));
-    bits_left = 8 * sizeof (rnd);
+  if (shard->random_bits_left < rate) {
+    UTI_GetRandomBytesUnbuffered(&shard->random_bits, sizeof (shard->random_bits));
+    shard->random_bits_left = 8 * sizeof (shard->random_bits);
   }
 
   /* Return zero on average once per 2^rate */
-  r = rnd % (1U << rate) ? 1 : 0;
-  rnd >>= rate;
-  bits_left -= rate;
+  r = shard->random_bits % (1U << rate) ? 1 : 0;
+  shard->random_bits >>= rate;
+  shard->random_bits_left -= rate;
 
   return r;
 }
 
 /* ================================================== */
 
-CLG_Limit
-CLG_LimitServiceRate(CLG_Service service, int index)
+static CLG_Limit
+limit_service_rate(CLG_Service service, Shard *shard, Counters *counters)
 {
-  Record *record;
   int drop;
 
-  check_service_number(service);
-
   if (tokens_per_hit[service] == 0)
     return CLG_PASS;
 
-  record = ARR_GetElement(records, index);
-  record->drop_flags &= ~(1U << service);
+  counters->drop_flags &= ~(1U << service);
 
-  if (record->tokens[service] >= tokens_per_hit[service]) {
-    record->tokens[service] -= tokens_per_hit[service];
+  if (counters->tokens[service] >= tokens_per_hit[service]) {
+    counters->tokens[service] -= tokens_per_hit[service];
     return CLG_PASS;
   }
 
-  drop = limit_response_random(leak_rate[service]);
+  drop = limit_response_random(shard, leak_rate[service]);
 
   /* Poorly implemented NTP clients can send requests at a higher rate
      when they are not getting replies.  If the request rate seems to be more
      than twice as much as when replies are sent, give up on rate limiting to
      reduce the amount of traffic.  Invert the sense of the leak to respond to
      most of the requests, but still keep the estimated rate updated. */
-  if (service == CLG_NTP && record->ntp_timeout_rate != INVALID_RATE &&
-      record->ntp_timeout_rate > record->rate[service] + RATE_SCALE)
+  if (service == CLG_NTP && counters->ntp_timeout_rate != INVALID_RATE &&
+      counters->ntp_timeout_rate > counters->rate[service] + RATE_SCALE)
     drop = !drop;
 
   if (!drop) {
-    record->tokens[service] = 0;
+    counters->tokens[service] = 0;
     return CLG_PASS;
   }
 
-  if (kod_rate[service] > 0 && !limit_response_random(kod_rate[service])) {
+  if (kod_rate[service] > 0 && !limit_response_random(shard, kod_rate[service])) {
     return CLG_KOD;
   }
 
-  record->drop_flags |= 1U << service;
-  record->drops[service]++;
-  total_drops[service]++;
+  counters->drop_flags |= 1U << service;
+  counters->drops[service]++;
+  shard->drops[service]++;
 
   return CLG_DROP;
 }
 
 /* ================================================== */
 
+CLG_Limit
+CLG_LimitServiceRate(CLG_Service service, int index)
+{
+  CLG_Limit limit;
+  Shard *shard;
+
+  check_service_number(service);
+
+  shard = &shards[index % n_shards];
+  acquire_lock(&shard->lock);
+
+  limit = limit_service_rate(service, shard,
+                             ARR_GetElement(shard->counters, index / n_shards));
+
+  unlock_shard(shard);
+
+  return limit;
+}
+
+/* ================================================== */
+
+CLG_Limit
+CLG_LogAndLimitServiceAccess(CLG_Service service, IPAddr *client, struct timespec *now,
+                             int *logged)
+{
+  uint32_t fingerprint;
+  CLG_Limit limit;
+  Record *record;
+  Shard *shard;
+
+  check_service_number(service);
+
+  shard = lock_shard(client, &fingerprint);
+  if (!shard) {
+    total_hits[service]++;
+    *logged = 0;
+    return CLG_PASS;
+  }
+
+  record = log_service_access(service, shard, client, fingerprint, now);
+  limit = limit_service_rate(service, shard, get_counters(shard, record));
+
+  unlock_shard(shard);
+
+  *logged = 1;
+
+  return limit;
+}
+
+/* ================================================== */
+
 void
 CLG_UpdateNtpStats(int auth, NTP_Timestamp_Source rx_ts_src, NTP_Timestamp_Source tx_ts_src)
 {
@@ -697,34 +1251,34 @@ CLG_GetNtpMinPoll(void)
 /* ================================================== */
 
 static NtpTimestamps *
-get_ntp_tss(uint32_t index)
+get_ntp_tss(NtpTimestampMap *map, uint32_t index)
 {
-  return ARR_GetElement(ntp_ts_map.timestamps,
-                        (ntp_ts_map.first + index) & (ntp_ts_map.max_size - 1));
+  return ARR_GetElement(map->timestamps,
+                        (map->first + index) & (map->max_size - 1));
 }
 
 /* ================================================== */
 
 static int
-find_ntp_rx_ts(uint64_t rx_ts, uint32_t *index)
+find_ntp_rx_ts(NtpTimestampMap *map, uint64_t rx_ts, uint32_t *index)
 {
   uint64_t rx_x, rx_lo, rx_hi, step;
   uint32_t i, x, lo, hi;
 
-  if (ntp_ts_map.cached_rx_ts == rx_ts && rx_ts != 0ULL) {
-    *index = ntp_ts_map.cached_index;
+  if (map->cached_rx_ts == rx_ts && rx_ts != 0ULL) {
+    *index = map->cached_index;
     return 1;
   }
 
-  if (ntp_ts_map.size == 0) {
+  if (map->size == 0) {
     *index = 0;
     return 0;
   }
 
   lo = 0;
-  hi = ntp_ts_map.size - 1;
-  rx_lo = get_ntp_tss(lo)->rx_ts;
-  rx_hi = get_ntp_tss(hi)->rx_ts;
+  hi = map->size - 1;
+  rx_lo = get_ntp_tss(map, lo)->rx_ts;
+  rx_hi = get_ntp_tss(map, hi)->rx_ts;
 
   /* Check for ts < lo before ts > hi to trim timestamps from "future" later
      if both conditions are true to not break the order of the endpoints.
@@ -733,7 +1287,7 @@ find_ntp_rx_ts(uint64_t rx_ts, uint32_t *index)
     *index = 0;
     return 0;
   } else if ((int64_t)(rx_ts - rx_hi) > 0) {
-    *index = ntp_ts_map.size;
+    *index = map->size;
     return 0;
   }
 
@@ -741,12 +1295,12 @@ find_ntp_rx_ts(uint64_t rx_ts, uint32_t *index)
 
   for (i = 0; ; i++) {
     if (rx_ts == rx_hi) {
-      *index = ntp_ts_map.cached_index = hi;
-      ntp_ts_map.cached_rx_ts = rx_ts;
+      *index = map->cached_index = hi;
+      map->cached_rx_ts = rx_ts;
       return 1;
     } else if (rx_ts == rx_lo) {
-      *index = ntp_ts_map.cached_index = lo;
-      ntp_ts_map.cached_rx_ts = rx_ts;
+      *index = map->cached_index = lo;
+      map->cached_rx_ts = rx_ts;
       return 1;
     } else if (lo + 1 == hi) {
       *index = hi;
@@ -767,7 +1321,7 @@ find_ntp_rx_ts(uint64_t rx_ts, uint32_t *index)
     else if (x >= hi)
       x = hi - 1;
 
-    rx_x = get_ntp_tss(x)->rx_ts;
+    rx_x = get_ntp_tss(map, x)->rx_ts;
 
     if ((int64_t)(rx_x - rx_ts) <= 0) {
       lo = x;
@@ -799,12 +1353,12 @@ int64_to_ntp64(uint64_t ts, NTP_int64 *ntp_ts)
 /* ================================================== */
 
 static uint32_t
-push_ntp_tss(uint32_t index)
+push_ntp_tss(NtpTimestampMap *map, uint32_t index)
 {
-  if (ntp_ts_map.size < ntp_ts_map.max_size) {
-    ntp_ts_map.size++;
+  if (map->size < map->max_size) {
+    map->size++;
   } else {
-    ntp_ts_map.first = (ntp_ts_map.first + 1) % (ntp_ts_map.max_size);
+    map->first = (map->first + 1) % (map->max_size);
     if (index > 0)
       index--;
   }
@@ -864,20 +1418,34 @@ get_ntp_tx(NtpTimestamps *tss, struct timespec *tx_ts, NTP_Timestamp_Source *tx_
 
 /* ================================================== */
 
+static NtpTimestampMap *
+get_ntp_ts_map(IPAddr *client)
+{
+  if (!active)
+    return NULL;
+
+  return &get_shard(get_fingerprint(UTI_IPToHash(client)))->ntp_ts_map;
+}
+
+/* ================================================== */
+
 void
-CLG_SaveNtpTimestamps(NTP_int64 *rx_ts, struct timespec *tx_ts, NTP_Timestamp_Source tx_src)
+CLG_SaveNtpTimestamps(IPAddr *client, NTP_int64 *rx_ts, struct timespec *tx_ts,
+                      NTP_Timestamp_Source tx_src)
 {
+  NtpTimestampMap *map;
   NtpTimestamps *tss;
   uint32_t i, index;
   uint64_t rx;
 
-  if (!active)
+  map = get_ntp_ts_map(client);
+  if (!map)
     return;
 
   /* Allocate the array on first use */
-  if (!ntp_ts_map.timestamps) {
-    ntp_ts_map.timestamps = ARR_CreateInstance(sizeof (NtpTimestamps));
-    ARR_SetSize(ntp_ts_map.timestamps, ntp_ts_map.max_size);
+  if (!map->timestamps) {
+    map->timestamps = ARR_CreateInstance(sizeof (NtpTimestamps));
+    ARR_SetSize(map->timestamps, map->max_size);
   }
 
   rx = ntp64_to_int64(rx_ts);
@@ -887,46 +1455,46 @@ CLG_SaveNtpTimestamps(NTP_int64 *rx_ts, struct timespec *tx_ts, NTP_Timestamp_So
 
   /* Disable the RX timestamp if it already exists to avoid responding
      with a wrong TX timestamp */
-  if (find_ntp_rx_ts(rx, &index)) {
-    get_ntp_tss(index)->flags |= NTPTS_DISABLED;
+  if (find_ntp_rx_ts(map, rx, &index)) {
+    get_ntp_tss(map, index)->flags |= NTPTS_DISABLED;
     return;
   }
 
-  assert(index <= ntp_ts_map.size);
+  assert(index <= map->size);
 
-  if (index == ntp_ts_map.size) {
+  if (index == map->size) {
     /* Increase the size or drop the oldest timestamp to make room for
        the new timestamp */
-    index = push_ntp_tss(index);
+    index = push_ntp_tss(map, index);
   } else {
     /* Trim timestamps in distant future after backward step */
-    while (index < ntp_ts_map.size &&
-           get_ntp_tss(ntp_ts_map.size - 1)->rx_ts - rx > NTPTS_FUTURE_LIMIT)
-      ntp_ts_map.size--;
+    while (index < map->size &&
+           get_ntp_tss(map, map->size - 1)->rx_ts - rx > NTPTS_FUTURE_LIMIT)
+      map->size--;
 
     /* Insert the timestamp if it is close to the latest timestamp.
        Otherwise, replace the closest older or the oldest timestamp. */
-    if (index + NTPTS_INSERT_LIMIT >= ntp_ts_map.size) {
-      index = push_ntp_tss(index);
-      for (i = ntp_ts_map.size - 1; i > index; i--)
-        *get_ntp_tss(i) = *get_ntp_tss(i - 1);
+    if (index + NTPTS_INSERT_LIMIT >= map->size) {
+      index = push_ntp_tss(map, index);
+      for (i = map->size - 1; i > index; i--)
+        *get_ntp_tss(map, i) = *get_ntp_tss(map, i - 1);
     } else {
       if (index > 0)
         index--;
     }
   }
 
-  ntp_ts_map.cached_index = index;
-  ntp_ts_map.cached_rx_ts = rx;
+  map->cached_index = index;
+  map->cached_rx_ts = rx;
 
-  tss = get_ntp_tss(index);
+  tss = get_ntp_tss(map, index);
   tss->rx_ts = rx;
   tss->flags = 0;
-  tss->slew_epoch = ntp_ts_map.slew_epoch;
+  tss->slew_epoch = map->slew_epoch;
   set_ntp_tx(tss, rx_ts, tx_ts, tx_src);
 
   DEBUG_LOG("Saved RX+TX index=%"PRIu32" first=%"PRIu32" size=%"PRIu32,
-            index, ntp_ts_map.first, ntp_ts_map.size);
+            index, map->first, map->size);
 }
 
 /* ================================================== */
@@ -935,68 +1503,81 @@ static void
 handle_slew(struct timespec *raw, struct timespec *cooked, double dfreq,
             double doffset, LCL_ChangeType change_type, void *anything)
 {
-  /* Drop all timestamps on unknown step */
-  if (change_type == LCL_ChangeUnknownStep) {
-    ntp_ts_map.size = 0;
-    ntp_ts_map.cached_rx_ts = 0ULL;
-  }
+  NtpTimestampMap *map;
+  unsigned int i;
+
+  for (i = 0; i < n_shards; i++) {
+    map = &shards[i].ntp_ts_map;
 
-  ntp_ts_map.slew_epoch++;
-  ntp_ts_map.slew_offset = doffset;
+    /* Drop all timestamps on unknown step */
+    if (change_type == LCL_ChangeUnknownStep) {
+      map->size = 0;
+      map->cached_rx_ts = 0ULL;
+    }
+
+    map->slew_epoch++;
+    map->slew_offset = doffset;
+  }
 }
 
 /* ================================================== */
 
 void
-CLG_UndoNtpTxTimestampSlew(NTP_int64 *rx_ts, struct timespec *tx_ts)
+CLG_UndoNtpTxTimestampSlew(IPAddr *client, NTP_int64 *rx_ts, struct timespec *tx_ts)
 {
+  NtpTimestampMap *map;
   uint32_t index;
 
-  if (!ntp_ts_map.timestamps)
+  map = get_ntp_ts_map(client);
+  if (!map || !map->timestamps)
     return;
 
-  if (!find_ntp_rx_ts(ntp64_to_int64(rx_ts), &index))
+  if (!find_ntp_rx_ts(map, ntp64_to_int64(rx_ts), &index))
     return;
 
   /* If the RX timestamp was captured before the last correction of the clock,
      remove the adjustment from the TX timestamp */
-  if ((uint16_t)(get_ntp_tss(index)->slew_epoch + 1U) == ntp_ts_map.slew_epoch)
-    UTI_AddDoubleToTimespec(tx_ts, ntp_ts_map.slew_offset, tx_ts);
+  if ((uint16_t)(get_ntp_tss(map, index)->slew_epoch + 1U) == map->slew_epoch)
+    UTI_AddDoubleToTimespec(tx_ts, map->slew_offset, tx_ts);
 }
 
 /* ================================================== */
 
 void
-CLG_UpdateNtpTxTimestamp(NTP_int64 *rx_ts, struct timespec *tx_ts,
+CLG_UpdateNtpTxTimestamp(IPAddr *client, NTP_int64 *rx_ts, struct timespec *tx_ts,
                          NTP_Timestamp_Source tx_src)
 {
+  NtpTimestampMap *map;
   uint32_t index;
 
-  if (!ntp_ts_map.timestamps)
+  map = get_ntp_ts_map(client);
+  if (!map || !map->timestamps)
     return;
 
-  if (!find_ntp_rx_ts(ntp64_to_int64(rx_ts), &index))
+  if (!find_ntp_rx_ts(map, ntp64_to_int64(rx_ts), &index))
     return;
 
-  set_ntp_tx(get_ntp_tss(index), rx_ts, tx_ts, tx_src);
+  set_ntp_tx(get_ntp_tss(map, index), rx_ts, tx_ts, tx_src);
 }
 
 /* ================================================== */
 
 int
-CLG_GetNtpTxTimestamp(NTP_int64 *rx_ts, struct timespec *tx_ts,
+CLG_GetNtpTxTimestamp(IPAddr *client, NTP_int64 *rx_ts, struct timespec *tx_ts,
                       NTP_Timestamp_Source *tx_src)
 {
+  NtpTimestampMap *map;
   NtpTimestamps *tss;
   uint32_t index;
 
-  if (!ntp_ts_map.timestamps)
+  map = get_ntp_ts_map(client);
+  if (!map || !map->timestamps)
     return 0;
 
-  if (!find_ntp_rx_ts(ntp64_to_int64(rx_ts), &index))
+  if (!find_ntp_rx_ts(map, ntp64_to_int64(rx_ts), &index))
     return 0;
 
-  tss = get_ntp_tss(index);
+  tss = get_ntp_tss(map, index);
 
   if (tss->flags & NTPTS_DISABLED)
     return 0;
@@ -1009,15 +1590,17 @@ CLG_GetNtpTxTimestamp(NTP_int64 *rx_ts, struct timespec *tx_ts,
 /* ================================================== */
 
 void
-CLG_DisableNtpTimestamps(NTP_int64 *rx_ts)
+CLG_DisableNtpTimestamps(IPAddr *client, NTP_int64 *rx_ts)
 {
+  NtpTimestampMap *map;
   uint32_t index;
 
-  if (!ntp_ts_map.timestamps)
+  map = get_ntp_ts_map(client);
+  if (!map || !map->timestamps)
     return;
 
-  if (find_ntp_rx_ts(ntp64_to_int64(rx_ts), &index))
-    get_ntp_tss(index)->flags |= NTPTS_DISABLED;
+  if (find_ntp_rx_ts(map, ntp64_to_int64(rx_ts), &index))
+    get_ntp_tss(map, index)->flags |= NTPTS_DISABLED;
 
   /* This assumes the function is called only to prevent multiple
      interleaved responses to the same timestamp */
@@ -1029,10 +1612,23 @@ CLG_DisableNtpTimestamps(NTP_int64 *rx_ts)
 int
 CLG_GetNumberOfIndices(void)
 {
+  unsigned int i, j, size, max_size;
+  Shard *shard;
+
   if (!active)
     return -1;
 
-  return ARR_GetSize(records);
+  for (i = max_size = 0; i < n_shards; i++) {
+    shard = &shards[i];
+    acquire_lock(&shard->lock);
+    size = ARR_GetSize(shard->records);
+    for (j = 0; j < shard->n_old_tables; j++)
+      size += shard->old_tables[j].slots * SLOT_SIZE;
+    max_size = MAX(max_size, size);
+    unlock_shard(shard);
+  }
+
+  return max_size * n_shards;
 }
 
 /* ================================================== */
@@ -1063,23 +1659,29 @@ int
 CLG_GetClientAccessReportByIndex(int index, int reset, uint32_t min_hits,
                                  RPT_ClientAccessByIndex_Report *report, struct timespec *now)
 {
+  Counters *counters;
   Record *record;
   uint32_t now_ts;
+  Shard *shard;
   int i, r;
 
-  if (!active || index < 0 || index >= ARR_GetSize(records))
+  if (!active || index < 0)
     return 0;
 
-  record = ARR_GetElement(records, index);
+  shard = &shards[index % n_shards];
+  acquire_lock(&shard->lock);
 
-  if (record->ip_addr.family == IPADDR_UNSPEC)
+  record = get_shard_record_by_index(shard, index / n_shards, &counters);
+  if (!record) {
+    unlock_shard(shard);
     return 0;
+  }
 
   if (min_hits == 0) {
     r = 1;
   } else {
     for (i = r = 0; i < MAX_SERVICES; i++) {
-      if (record->hits[i] >= min_hits) {
+      if (counters->hits[i] >= min_hits) {
         r = 1;
         break;
       }
@@ -1090,16 +1692,16 @@ CLG_GetClientAccessReportByIndex(int index, int reset, uint32_t min_hits,
     now_ts = get_ts_from_timespec(now);
 
     report->ip_addr = record->ip_addr;
-    report->ntp_hits = record->hits[CLG_NTP];
-    report->nke_hits = record->hits[CLG_NTSKE];
-    report->cmd_hits = record->hits[CLG_CMDMON];
-    report->ntp_drops = record->drops[CLG_NTP];
-    report->nke_drops = record->drops[CLG_NTSKE];
-    report->cmd_drops = record->drops[CLG_CMDMON];
-    report->ntp_interval = get_interval(record->rate[CLG_NTP]);
-    report->nke_interval = get_interval(record->rate[CLG_NTSKE]);
-    report->cmd_interval = get_interval(record->rate[CLG_CMDMON]);
-    report->ntp_timeout_interval = get_interval(record->ntp_timeout_rate);
+    report->ntp_hits = counters->hits[CLG_NTP];
+    report->nke_hits = counters->hits[CLG_NTSKE];
+    report->cmd_hits = counters->hits[CLG_CMDMON];
+    report->ntp_drops = counters->drops[CLG_NTP];
+    report->nke_drops = counters->drops[CLG_NTSKE];
+    report->cmd_drops = counters->drops[CLG_CMDMON];
+    report->ntp_interval = get_interval(counters->rate[CLG_NTP]);
+    report->nke_interval = get_interval(counters->rate[CLG_NTSKE]);
+    report->cmd_interval = get_interval(counters->rate[CLG_CMDMON]);
+    report->ntp_timeout_interval = get_interval(counters->ntp_timeout_rate);
     report->last_ntp_hit_ago = get_last_ago(now_ts, record->last_hit[CLG_NTP]);
     report->last_nke_hit_ago = get_last_ago(now_ts, record->last_hit[CLG_NTSKE]);
     report->last_cmd_hit_ago = get_last_ago(now_ts, record->last_hit[CLG_CMDMON]);
@@ -1107,11 +1709,13 @@ CLG_GetClientAccessReportByIndex(int index, int reset, uint32_t min_hits,
 
   if (reset) {
     for (i = 0; i < MAX_SERVICES; i++) {
-      record->hits[i] = 0;
-      record->drops[i] = 0;
+      counters->hits[i] = 0;
+      counters->drops[i] = 0;
     }
   }
 
+  unlock_shard(shard);
+
   return r;
 }
 
@@ -1120,19 +1724,45 @@ CLG_GetClientAccessReportByIndex(int index, int reset, uint32_t min_hits,
 void
 CLG_GetServerStatsReport(RPT_ServerStatsReport *report)
 {
+  NtpTimestampMap *map;
+  unsigned int i;
+  uint64_t span;
+  Shard *shard;
+
   report->ntp_hits = total_hits[CLG_NTP];
   report->nke_hits = total_hits[CLG_NTSKE];
   report->cmd_hits = total_hits[CLG_CMDMON];
-  report->ntp_drops = total_drops[CLG_NTP];
-  report->nke_drops = total_drops[CLG_NTSKE];
-  report->cmd_drops = total_drops[CLG_CMDMON];
-  report->log_drops = total_record_drops;
+  report->ntp_drops = 0;
+  report->nke_drops = 0;
+  report->cmd_drops = 0;
+  report->log_drops = 0;
   report->ntp_auth_hits = total_ntp_auth_hits;
   report->ntp_interleaved_hits = total_ntp_interleaved_hits;
-  report->ntp_timestamps = ntp_ts_map.size;
-  report->ntp_span_seconds = ntp_ts_map.size > 1 ?
-                             (get_ntp_tss(ntp_ts_map.size - 1)->rx_ts -
-                              get_ntp_tss(0)->rx_ts) >> 32 : 0;
+  report->ntp_timestamps = 0;
+  report->ntp_span_seconds = 0;
+
+  /* Sum the counters of the shards.  Report the longest span of
+     the timestamps as the clients are spread over all shards. */
+  for (i = 0; i < n_shards; i++) {
+    shard = &shards[i];
+    map = &shard->ntp_ts_map;
+
+    acquire_lock(&shard->lock);
+    report->ntp_hits += shard->hits[CLG_NTP];
+    report->nke_hits += shard->hits[CLG_NTSKE];
+    report->cmd_hits += shard->hits[CLG_CMDMON];
+    report->ntp_drops += shard->drops[CLG_NTP];
+    report->nke_drops += shard->drops[CLG_NTSKE];
+    report->cmd_drops += shard->drops[CLG_CMDMON];
+    report->log_drops += shard->record_drops;
+    unlock_shard(shard);
+    report->ntp_timestamps += map->size;
+
+    span = map->size > 1 ? (get_ntp_tss(map, map->size - 1)->rx_ts -
+                            get_ntp_tss(map, 0)->rx_ts) >> 32 : 0;
+    report->ntp_span_seconds = MAX(report->ntp_span_seconds, span);
+  }
+
   report->ntp_daemon_rx_timestamps = total_ntp_rx_timestamps[NTP_TS_DAEMON];
   report->ntp_daemon_tx_timestamps = total_ntp_tx_timestamps[NTP_TS_DAEMON];
   report->ntp_kernel_rx_timestamps = total_ntp_rx_timestamps[NTP_TS_KERNEL];
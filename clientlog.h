@@ -48,19 +48,28 @@ extern void CLG_Finalise(void);
 extern int CLG_GetClientIndex(IPAddr *client);
 extern int CLG_LogServiceAccess(CLG_Service service, IPAddr *client, struct timespec *now);
 extern CLG_Limit CLG_LimitServiceRate(CLG_Service service, int index);
+
+/* Log an access of a client to a service and check its rate limit in one
+   step, which can be used also in the server threads (the index returned
+   by CLG_LogServiceAccess() could be invalidated by the threads before
+   CLG_LimitServiceRate() is called).  The logged flag is set to zero if
+   the client could not be logged. */
+extern CLG_Limit CLG_LogAndLimitServiceAccess(CLG_Service service, IPAddr *client,
+                                              struct timespec *now, int *logged);
 extern void CLG_UpdateNtpStats(int auth, NTP_Timestamp_Source rx_ts_src,
                                NTP_Timestamp_Source tx_ts_src);
 extern int CLG_GetNtpMinPoll(void);
 
 /* Functions to save and retrieve timestamps for server interleaved mode */
-extern void CLG_SaveNtpTimestamps(NTP_int64 *rx_ts, struct timespec *tx_ts,
+extern void CLG_SaveNtpTimestamps(IPAddr *client, NTP_int64 *rx_ts, struct timespec *tx_ts,
                                   NTP_Timestamp_Source tx_src);
-extern void CLG_UndoNtpTxTimestampSlew(NTP_int64 *rx_ts, struct timespec *tx_ts);
-extern void CLG_UpdateNtpTxTimestamp(NTP_int64 *rx_ts, struct timespec *tx_ts,
+extern void CLG_UndoNtpTxTimestampSlew(IPAddr *client, NTP_int64 *rx_ts,
+                                       struct timespec *tx_ts);
+extern void CLG_UpdateNtpTxTimestamp(IPAddr *client, NTP_int64 *rx_ts, struct timespec *tx_ts,
                                      NTP_Timestamp_Source tx_src);
-extern int CLG_GetNtpTxTimestamp(NTP_int64 *rx_ts, struct timespec *tx_ts,
+extern int CLG_GetNtpTxTimestamp(IPAddr *client, NTP_int64 *rx_ts, struct timespec *tx_ts,
                                  NTP_Timestamp_Source *tx_src);
-extern void CLG_DisableNtpTimestamps(NTP_int64 *rx_ts);
+extern void CLG_DisableNtpTimestamps(IPAddr *client, NTP_int64 *rx_ts);
 
 /* And some reporting functions, for use by chronyc. */
 
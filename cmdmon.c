@@ -37,6 +37,8 @@
 #include "keys.h"
 #include "ntp_sources.h"
 #include "ntp_core.h"
+#include "ntp_io.h"
+#include "ntp_workers.h"
 #include "smooth.h"
 #include "socket.h"
 #include "sources.h"
@@ -1112,9 +1114,12 @@ static void
 handle_server_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
 {
   RPT_ServerStatsReport report;
+  int i;
 
   CLG_GetServerStatsReport(&report);
-  tx_message->reply = htons(RPY_SERVER_STATS4);
+  NWK_AddServerStats(&report);
+  NIO_GetServerStatsReport(&report);
+  tx_message->reply = htons(RPY_SERVER_STATS5);
   tx_message->data.server_stats.ntp_hits = UTI_Integer64HostToNetwork(report.ntp_hits);
   tx_message->data.server_stats.nke_hits = UTI_Integer64HostToNetwork(report.nke_hits);
   tx_message->data.server_stats.cmd_hits = UTI_Integer64HostToNetwork(report.cmd_hits);
@@ -1142,6 +1147,9 @@ handle_server_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
     UTI_Integer64HostToNetwork(report.ntp_hw_rx_timestamps);
   tx_message->data.server_stats.ntp_hw_tx_timestamps =
     UTI_Integer64HostToNetwork(report.ntp_hw_tx_timestamps);
+  for (i = 0; i < RPT_RX_BATCH_BUCKETS; i++)
+    tx_message->data.server_stats.ntp_rx_batches[i] =
+      UTI_Integer64HostToNetwork(report.ntp_rx_batches[i]);
   memset(tx_message->data.server_stats.reserved, 0xff,
          sizeof (tx_message->data.server_stats.reserved));
 }
@@ -1597,7 +1605,7 @@ handle_readonly_commands(int command, int full_access, CMD_Request *request, CMD
 static void
 read_from_cmd_socket(int sock_fd, int event, void *anything)
 {
-  int read_length, expected_length, localhost, log_index, full_access, handled;
+  int read_length, expected_length, localhost, logged, full_access, handled;
   SCK_Message *sck_message;
   CMD_Request rx_message;
   CMD_Reply tx_message;
@@ -1655,12 +1663,12 @@ read_from_cmd_socket(int sock_fd, int event, void *anything)
     return;
   }
 
-  log_index = CLG_LogServiceAccess(CLG_CMDMON, &remote_ip, &cooked_now);
-
   /* Don't reply to all requests from hosts other than localhost if the rate
      is excessive */
-  if (!localhost && log_index >= 0 &&
-      CLG_LimitServiceRate(CLG_CMDMON, log_index) != CLG_PASS) {
+  if (localhost) {
+    CLG_LogServiceAccess(CLG_CMDMON, &remote_ip, &cooked_now);
+  } else if (CLG_LogAndLimitServiceAccess(CLG_CMDMON, &remote_ip, &cooked_now,
+                                          &logged) != CLG_PASS) {
     DEBUG_LOG("Command packet discarded to limit response rate");
     return;
   }
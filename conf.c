@@ -68,6 +68,7 @@ static void parse_bindacqaddress(char *);
 static void parse_bindaddress(char *);
 static void parse_bindcmdaddress(char *);
 static void parse_broadcast(char *);
+static void parse_busypoll(char *);
 static void parse_clientloglimit(char *);
 static void parse_confdir(char *);
 static void parse_driftfile(char *);
@@ -87,6 +88,7 @@ static void parse_open_commands(char *line);
 static void parse_pidfile(char *line);
 static void parse_ratelimit(char *line, int *enabled, int *interval,
                             int *burst, int *leak, int *kod);
+static void parse_receivebatch(char *);
 static void parse_refclock(char *);
 static void parse_smoothtime(char *);
 static void parse_source(char *line, char *type, int fatal);
@@ -282,9 +284,11 @@ static ARR_Instance nts_server_cert_files; /* array of (char *) */
 static ARR_Instance nts_server_key_files; /* array of (char *) */
 static int nts_server_port = NKE_PORT;
 static int nts_server_processes = 1;
+static int nts_server_threads = 0;
 static int nts_server_connections = 100;
 static int nts_refresh = 2419200; /* 4 weeks */
 static int nts_rotate = 604800; /* 1 week */
+static int nts_ticket_lifetime = 0;
 static ARR_Instance nts_trusted_certs_paths; /* array of (char *) */
 static ARR_Instance nts_trusted_certs_ids; /* array of uint32_t */
 
@@ -308,6 +312,20 @@ static int ptp_port = 0;
 /* PTP domain number of NTP-over-PTP messages */
 static int ptp_domain = 123;
 
+/* Number of threads answering NTP client requests (disabled by default) */
+static int server_threads = 0;
+
+/* Maximum number of messages received from a server socket in one system
+   call and whether it should be adapted to the observed load */
+static int receive_batch = 16;
+static int receive_batch_adaptive = 0;
+
+/* Busy polling of server sockets (timeout in microseconds, maximum number
+   of packets per poll, and preference over interrupts) */
+static int busy_poll = 0;
+static int busy_poll_budget = 0;
+static int busy_poll_prefer = 0;
+
 typedef struct {
   NTP_Source_Type type;
   int pool;
@@ -624,6 +642,8 @@ CNF_ParseLine(const char *filename, int number, char *line)
     parse_string(p, &bind_ntp_iface);
   } else if (!strcasecmp(command, "broadcast")) {
     parse_broadcast(p);
+  } else if (!strcasecmp(command, "busypoll")) {
+    parse_busypoll(p);
   } else if (!strcasecmp(command, "clientloglimit")) {
     parse_clientloglimit(p);
   } else if (!strcasecmp(command, "clockprecision")) {
@@ -741,10 +761,14 @@ CNF_ParseLine(const char *filename, int number, char *line)
     parse_int(p, &nts_server_port, 0, 65535);
   } else if (!strcasecmp(command, "ntsprocesses")) {
     parse_int(p, &nts_server_processes, 0, 1000);
+  } else if (!strcasecmp(command, "ntsthreads")) {
+    parse_int(p, &nts_server_threads, 0, 1000);
   } else if (!strcasecmp(command, "ntsrefresh")) {
     parse_int(p, &nts_refresh, 0, INT_MAX);
   } else if (!strcasecmp(command, "ntsrotate")) {
     parse_int(p, &nts_rotate, 0, INT_MAX);
+  } else if (!strcasecmp(command, "ntsticketlifetime")) {
+    parse_int(p, &nts_ticket_lifetime, 0, 604800);
   } else if (!strcasecmp(command, "ntsservercert")) {
     parse_ntsserver(p, nts_server_cert_files);
   } else if (!strcasecmp(command, "ntsserverkey")) {
@@ -768,6 +792,8 @@ CNF_ParseLine(const char *filename, int number, char *line)
   } else if (!strcasecmp(command, "ratelimit")) {
     parse_ratelimit(p, &ntp_ratelimit_enabled, &ntp_ratelimit_interval,
                     &ntp_ratelimit_burst, &ntp_ratelimit_leak, &ntp_ratelimit_kod);
+  } else if (!strcasecmp(command, "receivebatch")) {
+    parse_receivebatch(p);
   } else if (!strcasecmp(command, "refclock")) {
     parse_refclock(p);
   } else if (!strcasecmp(command, "refresh")) {
@@ -788,6 +814,8 @@ CNF_ParseLine(const char *filename, int number, char *line)
     parse_int(p, &sched_priority, 0, 100);
   } else if (!strcasecmp(command, "server")) {
     parse_source(p, command, 1);
+  } else if (!strcasecmp(command, "serverthreads")) {
+    parse_int(p, &server_threads, 0, 1024);
   } else if (!strcasecmp(command, "smoothtime")) {
     parse_smoothtime(p);
   } else if (!strcasecmp(command, "sourcedir")) {
@@ -1538,6 +1566,67 @@ parse_broadcast(char *line)
 
 /* ================================================== */
 
+static void
+parse_busypoll(char *line)
+{
+  char *opt;
+  int n;
+
+  busy_poll_budget = 0;
+  busy_poll_prefer = 0;
+
+  if (!SSCANF_IN_RANGE(line, "%d%n", &busy_poll, &n, 0, 1000000) ||
+      (line[n] != '\0' && line[n] != ' ' && line[n] != '\t')) {
+    busy_poll = 0;
+    command_parse_error();
+    return;
+  }
+
+  line = CPS_SplitWord(line);
+
+  while (*line) {
+    opt = line;
+    line = CPS_SplitWord(line);
+    if (!strcasecmp(opt, "prefer")) {
+      busy_poll_prefer = 1;
+    } else if (!strcasecmp(opt, "budget")) {
+      if (!SSCANF_IN_RANGE(line, "%d%n", &busy_poll_budget, &n, 1, 65535)) {
+        command_parse_error();
+        return;
+      }
+      line = CPS_SplitWord(line);
+    } else {
+      command_parse_error();
+      return;
+    }
+  }
+}
+
+/* ================================================== */
+
+static void
+parse_receivebatch(char *line)
+{
+  char *adaptive;
+
+  if (get_number_of_args(line) != 2)
+    check_number_of_args(line, 1);
+
+  adaptive = CPS_SplitWord(line);
+  receive_batch_adaptive = 0;
+
+  if (*adaptive) {
+    if (!strcasecmp(adaptive, "adaptive"))
+      receive_batch_adaptive = 1;
+    else
+      command_parse_error();
+  }
+
+  parse_int(line, &receive_batch, 1, 256);
+}
+
+/* ================================================== */
+
 static void
 parse_smoothtime(char *line)
 {
@@ -2807,6 +2896,33 @@ CNF_GetPtpDomain(void)
 
 /* ================================================== */
 
+int
+CNF_GetServerThreads(void)
+{
+  return server_threads;
+}
+
+/* ================================================== */
+
+int
+CNF_GetReceiveBatch(int *adaptive)
+{
+  *adaptive = receive_batch_adaptive;
+  return receive_batch;
+}
+
+/* ================================================== */
+
+int
+CNF_GetBusyPoll(int *budget, int *prefer)
+{
+  *budget = busy_poll_budget;
+  *prefer = busy_poll_prefer;
+  return busy_poll;
+}
+
+/* ================================================== */
+
 int
 CNF_GetRefresh(void)
 {
@@ -2869,6 +2985,14 @@ CNF_GetNtsServerProcesses(void)
 
 /* ================================================== */
 
+int
+CNF_GetNtsServerThreads(void)
+{
+  return nts_server_threads;
+}
+
+/* ================================================== */
+
 int
 CNF_GetNtsServerConnections(void)
 {
@@ -2893,6 +3017,14 @@ CNF_GetNtsRotate(void)
 
 /* ================================================== */
 
+int
+CNF_GetNtsTicketLifetime(void)
+{
+  return nts_ticket_lifetime;
+}
+
+/* ================================================== */
+
 int
 CNF_GetNtsTrustedCertsPaths(const char ***paths, uint32_t **ids)
 {
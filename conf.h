@@ -167,6 +167,10 @@ extern int CNF_GetMaxTxBuffers(void);
 extern int CNF_GetPtpPort(void);
 extern int CNF_GetPtpDomain(void);
 
+extern int CNF_GetServerThreads(void);
+extern int CNF_GetReceiveBatch(int *adaptive);
+extern int CNF_GetBusyPoll(int *budget, int *prefer);
+
 extern int CNF_GetRefresh(void);
 
 extern ARR_Instance CNF_GetNtsAeads(void);
@@ -175,9 +179,11 @@ extern char *CNF_GetNtsNtpServer(void);
 extern int CNF_GetNtsServerCertAndKeyFiles(const char ***certs, const char ***keys);
 extern int CNF_GetNtsServerPort(void);
 extern int CNF_GetNtsServerProcesses(void);
+extern int CNF_GetNtsServerThreads(void);
 extern int CNF_GetNtsServerConnections(void);
 extern int CNF_GetNtsRefresh(void);
 extern int CNF_GetNtsRotate(void);
+extern int CNF_GetNtsTicketLifetime(void);
 extern int CNF_GetNtsTrustedCertsPaths(const char ***paths, uint32_t **ids);
 extern int CNF_GetNoSystemCert(void);
 extern int CNF_GetNoCertTimeCheck(void);
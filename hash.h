@@ -52,6 +52,21 @@ extern int HSH_GetHashId(HSH_Algorithm algorithm);
 extern int HSH_Hash(int id, const void *in1, int in1_len, const void *in2, int in2_len,
                     unsigned char *out, int out_len);
 
+typedef struct HSH_Prefix_Record *HSH_Prefix;
+
+/* Create a hash state with a prefix (e.g. a key) already hashed, which
+   can be used to hash different data following the same prefix.  NULL is
+   returned if the implementation doesn't support it, or it would not be
+   faster than HSH_Hash() (e.g. the prefix is shorter than the block). */
+extern HSH_Prefix HSH_CreatePrefix(int id, const void *in, int in_len);
+
+extern void HSH_DestroyPrefix(HSH_Prefix prefix);
+
+/* Hash the prefix followed by the input (same as HSH_Hash() with the prefix
+   as in1) */
+extern int HSH_HashWithPrefix(HSH_Prefix prefix, const void *in, int in_len,
+                              unsigned char *out, int out_len);
+
 extern void HSH_Finalise(void);
 
 #endif
@@ -128,6 +128,27 @@ HSH_Hash(int id, const void *in1, int in1_len, const void *in2, int in2_len,
   return out_len;
 }
 
+/* Copying of the hash state with gnutls_hash_copy() needs an allocation,
+   which makes it slower than hashing the prefix again */
+
+HSH_Prefix
+HSH_CreatePrefix(int id, const void *in, int in_len)
+{
+  return NULL;
+}
+
+void
+HSH_DestroyPrefix(HSH_Prefix prefix)
+{
+}
+
+int
+HSH_HashWithPrefix(HSH_Prefix prefix, const void *in, int in_len,
+                   unsigned char *out, int out_len)
+{
+  return 0;
+}
+
 void
 HSH_Finalise(void)
 {
@@ -65,6 +65,50 @@ HSH_Hash(int id, const void *in1, int in1_len, const void *in2, int in2_len,
   return out_len;
 }
 
+struct HSH_Prefix_Record {
+  MD5_CTX ctx;
+};
+
+HSH_Prefix
+HSH_CreatePrefix(int id, const void *in, int in_len)
+{
+  HSH_Prefix prefix;
+
+  /* It's not faster than HSH_Hash() if no block would be processed */
+  if (in_len < 64)
+    return NULL;
+
+  prefix = MallocNew(struct HSH_Prefix_Record);
+  MD5Init(&prefix->ctx);
+  MD5Update(&prefix->ctx, in, in_len);
+
+  return prefix;
+}
+
+void
+HSH_DestroyPrefix(HSH_Prefix prefix)
+{
+  Free(prefix);
+}
+
+int
+HSH_HashWithPrefix(HSH_Prefix prefix, const void *in, int in_len,
+                   unsigned char *out, int out_len)
+{
+  if (in_len < 0 || out_len < 0)
+    return 0;
+
+  ctx = prefix->ctx;
+  MD5Update(&ctx, in, in_len);
+  MD5Final(&ctx);
+
+  out_len = MIN(out_len, 16);
+
+  memcpy(out, ctx.digest, out_len);
+
+  return out_len;
+}
+
 void
 HSH_Finalise(void)
 {
@@ -123,6 +123,74 @@ HSH_Hash(int id, const void *in1, int in1_len, const void *in2, int in2_len,
   return out_len;
 }
 
+struct HSH_Prefix_Record {
+  int id;
+  void *context;
+};
+
+HSH_Prefix
+HSH_CreatePrefix(int id, const void *in, int in_len)
+{
+  const struct nettle_hash *hash;
+  HSH_Prefix prefix;
+
+  hash = hashes[id].nettle_hash;
+
+  /* It's not faster than HSH_Hash() if no block would be processed */
+  if (in_len < (int)hash->block_size)
+    return NULL;
+
+  prefix = MallocNew(struct HSH_Prefix_Record);
+  prefix->id = id;
+  prefix->context = Malloc(hash->context_size);
+
+  hash->init(prefix->context);
+  hash->update(prefix->context, in_len, in);
+
+  return prefix;
+}
+
+void
+HSH_DestroyPrefix(HSH_Prefix prefix)
+{
+  Free(prefix->context);
+  Free(prefix);
+}
+
+int
+HSH_HashWithPrefix(HSH_Prefix prefix, const void *in, int in_len,
+                   unsigned char *out, int out_len)
+{
+  unsigned char buf[MAX_HASH_LENGTH];
+  const struct nettle_hash *hash;
+  void *context;
+
+  if (in_len < 0 || out_len < 0)
+    return 0;
+
+  hash = hashes[prefix->id].nettle_hash;
+  context = hashes[prefix->id].context;
+
+  if (out_len > hash->digest_size)
+    out_len = hash->digest_size;
+
+  if (hash->digest_size > sizeof (buf))
+    return 0;
+
+  /* The nettle contexts don't contain any pointers and can be copied */
+  memcpy(context, prefix->context, hash->context_size);
+  hash->update(context, in_len, in);
+  hash->digest(context,
+#if NETTLE_VERSION_MAJOR < 4
+               hash->digest_size,
+#endif
+               buf);
+
+  memcpy(out, buf, out_len);
+
+  return out_len;
+}
+
 void
 HSH_Finalise(void)
 {
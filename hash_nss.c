@@ -99,6 +99,26 @@ HSH_Hash(int id, const void *in1, int in1_len, const void *in2, int in2_len,
   return ret;
 }
 
+/* NSSLOWHASH contexts cannot be copied */
+
+HSH_Prefix
+HSH_CreatePrefix(int id, const void *in, int in_len)
+{
+  return NULL;
+}
+
+void
+HSH_DestroyPrefix(HSH_Prefix prefix)
+{
+}
+
+int
+HSH_HashWithPrefix(HSH_Prefix prefix, const void *in, int in_len,
+                   unsigned char *out, int out_len)
+{
+  return 0;
+}
+
 void
 HSH_Finalise(void)
 {
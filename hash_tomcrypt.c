@@ -29,6 +29,7 @@
 
 #include "config.h"
 #include "hash.h"
+#include "memory.h"
 #include "util.h"
 
 struct hash {
@@ -120,6 +121,64 @@ HSH_Hash(int id, const void *in1, int in1_len, const void *in2, int in2_len,
   return len;
 }
 
+struct HSH_Prefix_Record {
+  int id;
+  hash_state state;
+};
+
+HSH_Prefix
+HSH_CreatePrefix(int id, const void *in, int in_len)
+{
+  HSH_Prefix prefix;
+
+  /* It's not faster than HSH_Hash() if no block would be processed */
+  if (in_len < (int)hash_descriptor[id].blocksize)
+    return NULL;
+
+  prefix = MallocNew(struct HSH_Prefix_Record);
+  prefix->id = id;
+
+  if (hash_descriptor[id].init(&prefix->state) != CRYPT_OK ||
+      hash_descriptor[id].process(&prefix->state, in, in_len) != CRYPT_OK) {
+    Free(prefix);
+    return NULL;
+  }
+
+  return prefix;
+}
+
+void
+HSH_DestroyPrefix(HSH_Prefix prefix)
+{
+  Free(prefix);
+}
+
+int
+HSH_HashWithPrefix(HSH_Prefix prefix, const void *in, int in_len,
+                   unsigned char *out, int out_len)
+{
+  unsigned char buf[MAX_HASH_LENGTH];
+  hash_state state;
+  unsigned long len;
+
+  if (in_len < 0 || out_len < 0)
+    return 0;
+
+  len = hash_descriptor[prefix->id].hashsize;
+  if (len > sizeof (buf))
+    return 0;
+
+  state = prefix->state;
+  if (hash_descriptor[prefix->id].process(&state, in, in_len) != CRYPT_OK ||
+      hash_descriptor[prefix->id].done(&state, buf) != CRYPT_OK)
+    return 0;
+
+  len = MIN(len, out_len);
+  memcpy(out, buf, len);
+
+  return len;
+}
+
 void
 HSH_Finalise(void)
 {
@@ -57,30 +57,35 @@ typedef struct {
     struct {
       unsigned char *value;
       int hash_id;
+      HSH_Prefix prefix;
     } ntp_mac;
     CMC_Instance cmac;
   } data;
 } Key;
 
+/* Array of keys sorted by ID */
 static ARR_Instance keys;
 
-static int cache_valid;
-static uint32_t cache_key_id;
-static int cache_key_pos;
+/* Open-addressing hash table with linear probing mapping key IDs to
+   their positions in the array (or -1 for empty slots).  Its size is
+   a power of 2 and at least twice the number of keys. */
+static ARR_Instance key_index;
 
 /* ================================================== */
 
 static void
-free_keys(void)
+free_keys(ARR_Instance key_array)
 {
   unsigned int i;
   Key *key;
 
-  for (i = 0; i < ARR_GetSize(keys); i++) {
-    key = ARR_GetElement(keys, i);
+  for (i = 0; i < ARR_GetSize(key_array); i++) {
+    key = ARR_GetElement(key_array, i);
     switch (key->class) {
       case NTP_MAC:
         Free(key->data.ntp_mac.value);
+        if (key->data.ntp_mac.prefix)
+          HSH_DestroyPrefix(key->data.ntp_mac.prefix);
         break;
       case CMAC:
         CMC_DestroyInstance(key->data.cmac);
@@ -90,8 +95,7 @@ free_keys(void)
     }
   }
 
-  ARR_SetSize(keys, 0);
-  cache_valid = 0;
+  ARR_DestroyInstance(key_array);
 }
 
 /* ================================================== */
@@ -99,8 +103,8 @@ free_keys(void)
 void
 KEY_Initialise(void)
 {
-  keys = ARR_CreateInstance(sizeof (Key));
-  cache_valid = 0;
+  keys = NULL;
+  key_index = NULL;
   KEY_Reload();
 }
 
@@ -109,16 +113,61 @@ KEY_Initialise(void)
 void
 KEY_Finalise(void)
 {
-  free_keys();
-  ARR_DestroyInstance(keys);
+  free_keys(keys);
+  ARR_DestroyInstance(key_index);
 }
 
 /* ================================================== */
 
 static Key *
-get_key(unsigned int index)
+get_key(ARR_Instance key_array, unsigned int index)
 {
-  return ((Key *)ARR_GetElements(keys)) + index;
+  return ((Key *)ARR_GetElements(key_array)) + index;
+}
+
+/* ================================================== */
+
+static unsigned int
+get_index_slot(uint32_t id, unsigned int size)
+{
+  /* Mix the bits of the ID as the IDs are not necessarily random */
+  id ^= id >> 16;
+  id *= 0x85ebca6bU;
+  id ^= id >> 13;
+  id *= 0xc2b2ae35U;
+  id ^= id >> 16;
+
+  return id & (size - 1);
+}
+
+/* ================================================== */
+
+static void
+build_index(ARR_Instance key_array, ARR_Instance index)
+{
+  unsigned int i, j, size;
+  uint32_t id;
+  int *slots;
+
+  for (size = 1; size < 2 * ARR_GetSize(key_array); size *= 2)
+    ;
+
+  ARR_SetSize(index, size);
+  slots = ARR_GetElements(index);
+
+  for (i = 0; i < size; i++)
+    slots[i] = -1;
+
+  for (i = 0; i < ARR_GetSize(key_array); i++) {
+    id = get_key(key_array, i)->id;
+    for (j = get_index_slot(id, size); slots[j] >= 0; j = (j + 1) % size) {
+      /* Ignore duplicates */
+      if (get_key(key_array, slots[j])->id == id)
+        break;
+    }
+    if (slots[j] < 0)
+      slots[j] = i;
+  }
 }
 
 /* ================================================== */
@@ -162,8 +211,8 @@ compare_keys_by_id(const void *a, const void *b)
 
 /* ================================================== */
 
-void
-KEY_Reload(void)
+static void
+load_keys(ARR_Instance key_array)
 {
   unsigned int i, line_number, key_length, cmac_key_length;
   FILE *in;
@@ -174,8 +223,6 @@ KEY_Reload(void)
   int hash_id;
   Key key;
 
-  free_keys();
-
   key_file = CNF_GetKeysFile();
   line_number = 0;
 
@@ -226,6 +273,8 @@ KEY_Reload(void)
       key.data.ntp_mac.value = MallocArray(unsigned char, key_length);
       memcpy(key.data.ntp_mac.value, key_value, key_length);
       key.data.ntp_mac.hash_id = hash_id;
+      /* Hash the key in advance if possible */
+      key.data.ntp_mac.prefix = HSH_CreatePrefix(hash_id, key_value, key_length);
     } else if (cmac_algorithm != 0) {
       cmac_key_length = CMC_GetKeyLength(cmac_algorithm);
       if (cmac_key_length == 0) {
@@ -248,7 +297,7 @@ KEY_Reload(void)
       continue;
     }
 
-    ARR_AppendElement(keys, &key);
+    ARR_AppendElement(key_array, &key);
   }
 
   fclose(in);
@@ -256,35 +305,37 @@ KEY_Reload(void)
   /* Sort keys into order.  Note, if there's a duplicate, it is
      arbitrary which one we use later - the user should have been
      more careful! */
-  qsort(ARR_GetElements(keys), ARR_GetSize(keys), sizeof (Key), compare_keys_by_id);
+  qsort(ARR_GetElements(key_array), ARR_GetSize(key_array), sizeof (Key), compare_keys_by_id);
 
-  LOG(LOGS_INFO, "Loaded %u symmetric keys", ARR_GetSize(keys));
+  LOG(LOGS_INFO, "Loaded %u symmetric keys", ARR_GetSize(key_array));
 
   /* Check for duplicates */
-  for (i = 1; i < ARR_GetSize(keys); i++) {
-    if (get_key(i - 1)->id == get_key(i)->id)
-      LOG(LOGS_WARN, "Detected duplicate key %"PRIu32, get_key(i - 1)->id);
+  for (i = 1; i < ARR_GetSize(key_array); i++) {
+    if (get_key(key_array, i - 1)->id == get_key(key_array, i)->id)
+      LOG(LOGS_WARN, "Detected duplicate key %"PRIu32, get_key(key_array, i - 1)->id);
   }
 }
 
 /* ================================================== */
 
-static int
-lookup_key(uint32_t id)
+void
+KEY_Reload(void)
 {
-  Key specimen, *where, *keys_ptr;
-  int pos;
-
-  keys_ptr = ARR_GetElements(keys);
-  specimen.id = id;
-  where = (Key *)bsearch((void *)&specimen, keys_ptr, ARR_GetSize(keys),
-                         sizeof (Key), compare_keys_by_id);
-  if (!where) {
-    return -1;
-  } else {
-    pos = where - keys_ptr;
-    return pos;
+  ARR_Instance new_keys, new_index;
+
+  /* Load the keys and build the index before replacing the old ones */
+  new_keys = ARR_CreateInstance(sizeof (Key));
+  new_index = ARR_CreateInstance(sizeof (int));
+  load_keys(new_keys);
+  build_index(new_keys, new_index);
+
+  if (keys) {
+    free_keys(keys);
+    ARR_DestroyInstance(key_index);
   }
+
+  keys = new_keys;
+  key_index = new_index;
 }
 
 /* ================================================== */
@@ -292,19 +343,17 @@ lookup_key(uint32_t id)
 static Key *
 get_key_by_id(uint32_t key_id)
 {
-  int position;
-
-  if (cache_valid && key_id == cache_key_id)
-    return get_key(cache_key_pos);
-
-  position = lookup_key(key_id);
+  unsigned int i, size;
+  int *slots;
+  Key *key;
 
-  if (position >= 0) {
-    cache_valid = 1;
-    cache_key_pos = position;
-    cache_key_id = key_id;
+  size = ARR_GetSize(key_index);
+  slots = ARR_GetElements(key_index);
 
-    return get_key(position);
+  for (i = get_index_slot(key_id, size); slots[i] >= 0; i = (i + 1) % size) {
+    key = get_key(keys, slots[i]);
+    if (key->id == key_id)
+      return key;
   }
 
   return NULL;
@@ -382,6 +431,9 @@ generate_auth(Key *key, const void *data, int data_len, unsigned char *auth, int
 {
   switch (key->class) {
     case NTP_MAC:
+      if (key->data.ntp_mac.prefix)
+        return HSH_HashWithPrefix(key->data.ntp_mac.prefix, data, data_len,
+                                  auth, auth_len);
       return HSH_Hash(key->data.ntp_mac.hash_id, key->data.ntp_mac.value,
                       key->length, data, data_len, auth, auth_len);
     case CMAC:
@@ -146,7 +146,7 @@ void LOG_Message(LOG_Severity severity,
   char buf[2048];
   va_list other_args;
   time_t t;
-  struct tm *tm;
+  struct tm tm;
 
   assert(initialised);
   severity = CLAMP(LOGS_DEBUG, severity, LOGS_FATAL);
@@ -154,9 +154,8 @@ void LOG_Message(LOG_Severity severity,
   if (!system_log && file_log && severity >= log_min_severity) {
     /* Don't clutter up syslog with timestamps and internal debugging info */
     time(&t);
-    tm = gmtime(&t);
-    if (tm) {
-      strftime(buf, sizeof (buf), "%Y-%m-%dT%H:%M:%SZ", tm);
+    if (gmtime_r(&t, &tm)) {
+      strftime(buf, sizeof (buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
       fprintf(file_log, "%s ", buf);
     }
 #if DEBUG > 0
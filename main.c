@@ -39,6 +39,7 @@
 #include "ntp_signd.h"
 #include "ntp_sources.h"
 #include "ntp_core.h"
+#include "ntp_workers.h"
 #include "nts_ke_server.h"
 #include "nts_ntp_server.h"
 #include "socket.h"
@@ -164,6 +165,7 @@ MAI_CleanupAndExit(void)
   NKS_Finalise();
   NNS_Finalise();
   NSD_Finalise();
+  NWK_Finalise();
   NSR_Finalise();
   SST_Finalise();
   NCR_Finalise();
@@ -683,6 +685,7 @@ int main
   NIO_Initialise();
   NCR_Initialise();
   CNF_SetupAccessRestrictions();
+  NWK_Initialise();
 
   /* Command-line switch must have priority */
   if (!sched_priority) {
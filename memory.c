@@ -79,6 +79,18 @@ Malloc2(size_t nmemb, size_t size)
   return Malloc(get_array_size(nmemb, size));
 }
 
+void *
+Calloc(size_t nmemb, size_t size)
+{
+  void *r;
+
+  r = calloc(nmemb, size);
+  if (!r && nmemb && size)
+    LOG_FATAL("Could not allocate memory");
+
+  return r;
+}
+
 void *
 Realloc2(void *ptr, size_t nmemb, size_t size)
 {
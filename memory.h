@@ -33,6 +33,7 @@
 extern void *Malloc(size_t size);
 extern void *Realloc(void *ptr, size_t size);
 extern void *Malloc2(size_t nmemb, size_t size);
+extern void *Calloc(size_t nmemb, size_t size);
 extern void *Realloc2(void *ptr, size_t nmemb, size_t size);
 extern char *Strdup(const char *s);
 
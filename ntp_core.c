@@ -34,6 +34,7 @@
 #include "ntp_core.h"
 #include "ntp_ext.h"
 #include "ntp_io.h"
+#include "ntp_workers.h"
 #include "memory.h"
 #include "quantiles.h"
 #include "sched.h"
@@ -1119,6 +1120,115 @@ add_ef_net_correction(NTP_Packet *message, NTP_PacketInfo *info,
 
 /* ================================================== */
 
+/* ================================================== */
+/* Fill the header of a packet (except the originate, receive, and transmit
+   timestamps) from a snapshot of the reference.  A non-zero smoothing offset
+   is applied to the reference time.  This function doesn't depend on the
+   state of the main thread, so it can be used also by the server threads. */
+
+static void
+set_header(NTP_Packet *message, NTP_Mode mode, int version, int poll, uint32_t kod,
+           REF_ServerState *state, struct timespec *local_time, double smooth_offset,
+           int suppress_leap)
+{
+  struct timespec ref_time;
+  uint32_t ref_id;
+  NTP_Leap leap;
+  int stratum;
+
+  leap = state->leap;
+  stratum = state->stratum;
+  ref_id = state->ref_id;
+  ref_time = state->ref_time;
+
+  if (suppress_leap && (leap == LEAP_InsertSecond || leap == LEAP_DeleteSecond))
+    leap = LEAP_Normal;
+
+  if (smooth_offset != 0.0) {
+    ref_id = NTP_REFID_SMOOTH;
+    UTI_AddDoubleToTimespec(&ref_time, smooth_offset, &ref_time);
+  }
+
+  if (kod != 0) {
+    leap = LEAP_Unsynchronised;
+    stratum = NTP_INVALID_STRATUM;
+    ref_id = kod;
+  }
+
+  message->lvm = NTP_LVM(leap, version, mode);
+  /* Stratum 16 and larger are invalid */
+  message->stratum = stratum < NTP_MAX_STRATUM ? stratum : NTP_INVALID_STRATUM;
+  message->poll = poll;
+  message->precision = state->precision;
+  message->root_delay = UTI_DoubleToNtp32(state->root_delay);
+  message->root_dispersion =
+    UTI_DoubleToNtp32(REF_GetServerRootDispersion(state, local_time));
+  message->reference_id = htonl(ref_id);
+  UTI_TimespecToNtp64(&ref_time, &message->reference_ts, NULL);
+}
+
+/* ================================================== */
+/* Convert a local timestamp to an NTP timestamp with random bits below the
+   precision, which are provided by the specified function, or the default
+   generator if NULL.  Don't allow a non-zero result equal to any of the
+   specified timestamps (the precision must be at least -30 to prevent an
+   infinite loop!) */
+
+static void
+set_timestamp(NTP_int64 *ts, struct timespec *local_ts, int precision,
+              UTI_RandomFunction get_random, void *random_arg,
+              NTP_int64 *ts1, NTP_int64 *ts2, NTP_int64 *ts3)
+{
+  NTP_int64 ts_fuzz;
+
+  do {
+    if (get_random)
+      UTI_GetNtp64FuzzFrom(&ts_fuzz, precision, get_random, random_arg);
+    else
+      UTI_GetNtp64Fuzz(&ts_fuzz, precision);
+
+    UTI_TimespecToNtp64(local_ts, ts, &ts_fuzz);
+  } while (!UTI_IsZeroNtp64(ts) && UTI_IsEqualAnyNtp64(ts, ts1, ts2, ts3));
+}
+
+/* ================================================== */
+
+static void
+encode_rx_flag(NTP_Packet *message)
+{
+  /* Encode in server timestamps a flag indicating RX timestamp to avoid
+     saving all RX timestamps for detection of interleaved requests */
+  message->receive_ts.lo |= htonl(1);
+  message->transmit_ts.lo &= ~htonl(1);
+}
+
+/* ================================================== */
+
+void
+NCR_FormServerResponse(NTP_Packet *request, NTP_Packet *response, int version, int poll,
+                       int kod_rate, REF_ServerState *state, struct timespec *rx_ts,
+                       struct timespec *tx_ts, double smooth_offset, int suppress_leap,
+                       UTI_RandomFunction get_random, void *random_arg)
+{
+  struct timespec local_receive, local_transmit;
+
+  set_header(response, MODE_SERVER, version, poll, kod_rate ? KOD_RATE : 0, state, rx_ts,
+             smooth_offset, suppress_leap);
+
+  UTI_AddDoubleToTimespec(rx_ts, smooth_offset, &local_receive);
+  UTI_AddDoubleToTimespec(tx_ts, smooth_offset, &local_transmit);
+
+  response->originate_ts = request->transmit_ts;
+  set_timestamp(&response->receive_ts, &local_receive, state->precision,
+                get_random, random_arg, &response->originate_ts, NULL, NULL);
+  set_timestamp(&response->transmit_ts, &local_transmit, state->precision,
+                get_random, random_arg, &response->receive_ts, &response->originate_ts, NULL);
+
+  encode_rx_flag(response);
+}
+
+/* ================================================== */
+
 static int
 transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
                 int interleaved, /* Flag enabling interleaved mode */
@@ -1146,15 +1256,10 @@ transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
   NTP_Packet message;
   struct timespec local_receive, local_transmit;
   double smooth_offset, local_transmit_err;
-  int ret, precision;
-  NTP_int64 ts_fuzz;
+  int ret, precision, smooth_time, suppress_leap;
 
   /* Parameters read from reference module */
-  int are_we_synchronised, our_stratum, smooth_time;
-  NTP_Leap leap_status;
-  uint32_t our_ref_id;
-  struct timespec our_ref_time;
-  double our_root_delay, our_root_dispersion;
+  REF_ServerState server_state;
 
   assert(auth || (request && request_info));
 
@@ -1169,6 +1274,7 @@ transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
 
   smooth_time = 0;
   smooth_offset = 0.0;
+  suppress_leap = 0;
 
   /* Get an initial transmit timestamp.  A more accurate timestamp will be
      taken later in this function. */
@@ -1176,16 +1282,10 @@ transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
 
   if (my_mode == MODE_CLIENT) {
     /* Don't reveal local time or state of the clock in client packets */
-    precision = 32;
-    leap_status = our_stratum = our_ref_id = 0;
-    our_root_delay = our_root_dispersion = 0.0;
-    UTI_ZeroTimespec(&our_ref_time);
+    memset(&server_state, 0, sizeof (server_state));
+    server_state.precision = 32;
   } else {
-    REF_GetReferenceParams(&local_transmit,
-                           &are_we_synchronised, &leap_status,
-                           &our_stratum,
-                           &our_ref_id, &our_ref_time,
-                           &our_root_delay, &our_root_dispersion);
+    REF_GetServerState(&local_transmit, &server_state);
 
     /* Get current smoothing offset when sending packet to a client */
     if (SMT_IsEnabled() && (my_mode == MODE_SERVER || my_mode == MODE_BROADCAST)) {
@@ -1193,46 +1293,22 @@ transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
       smooth_time = fabs(smooth_offset) > LCL_GetSysPrecisionAsQuantum();
 
       /* Suppress leap second when smoothing and slew mode are enabled */
-      if (REF_GetLeapMode() == REF_LeapModeSlew &&
-          (leap_status == LEAP_InsertSecond || leap_status == LEAP_DeleteSecond))
-        leap_status = LEAP_Normal;
+      suppress_leap = REF_GetLeapMode() == REF_LeapModeSlew;
     }
-
-    precision = LCL_GetSysPrecisionAsLog();
   }
 
+  precision = server_state.precision;
+
   if (smooth_time && !UTI_IsZeroTimespec(&local_rx->ts)) {
-    our_ref_id = NTP_REFID_SMOOTH;
-    UTI_AddDoubleToTimespec(&our_ref_time, smooth_offset, &our_ref_time);
     UTI_AddDoubleToTimespec(&local_rx->ts, smooth_offset, &local_receive);
   } else {
     local_receive = local_rx->ts;
   }
 
-  if (kod != 0) {
-    leap_status = LEAP_Unsynchronised;
-    our_stratum = NTP_INVALID_STRATUM;
-    our_ref_id = kod;
-  }
-
   /* Generate transmit packet */
-  message.lvm = NTP_LVM(leap_status, version, my_mode);
-  /* Stratum 16 and larger are invalid */
-  if (our_stratum < NTP_MAX_STRATUM) {
-    message.stratum = our_stratum;
-  } else {
-    message.stratum = NTP_INVALID_STRATUM;
-  }
- 
-  message.poll = my_poll;
-  message.precision = precision;
-  message.root_delay = UTI_DoubleToNtp32(our_root_delay);
-  message.root_dispersion = UTI_DoubleToNtp32(our_root_dispersion);
-  message.reference_id = htonl(our_ref_id);
-
-  /* Now fill in timestamps */
-
-  UTI_TimespecToNtp64(&our_ref_time, &message.reference_ts, NULL);
+  set_header(&message, my_mode, version, my_poll, kod, &server_state, &local_transmit,
+             smooth_time && !UTI_IsZeroTimespec(&local_rx->ts) ? smooth_offset : 0.0,
+             suppress_leap);
 
   /* Don't reveal timestamps which are not necessary for the protocol */
 
@@ -1240,21 +1316,14 @@ transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
     /* Originate - this comes from the last packet the source sent us */
     message.originate_ts = interleaved ? *remote_ntp_rx : *remote_ntp_tx;
 
-    do {
-      /* Prepare random bits which will be added to the receive timestamp */
-      UTI_GetNtp64Fuzz(&ts_fuzz, precision);
-
-      /* Receive - this is when we received the last packet from the source.
-         This timestamp will have been adjusted so that it will now look to
-         the source like we have been running on our latest estimate of
-         frequency all along */
-      UTI_TimespecToNtp64(&local_receive, &message.receive_ts, &ts_fuzz);
-
-      /* Do not send a packet with a non-zero receive timestamp equal to the
-         originate timestamp or previous receive timestamp */
-    } while (!UTI_IsZeroNtp64(&message.receive_ts) &&
-             UTI_IsEqualAnyNtp64(&message.receive_ts, &message.originate_ts,
-                                 local_ntp_rx, NULL));
+    /* Receive - this is when we received the last packet from the source.
+       This timestamp will have been adjusted so that it will now look to
+       the source like we have been running on our latest estimate of
+       frequency all along.  Do not send a packet with a non-zero receive
+       timestamp equal to the originate timestamp or previous receive
+       timestamp. */
+    set_timestamp(&message.receive_ts, &local_receive, precision, NULL, NULL,
+                  &message.originate_ts, local_ntp_rx, NULL);
   } else {
     UTI_ZeroNtp64(&message.originate_ts);
     UTI_ZeroNtp64(&message.receive_ts);
@@ -1270,43 +1339,32 @@ transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
     }
     if (ext_field_flags & NTP_EF_FLAG_EXP_MONO_ROOT) {
       if (!add_ef_mono_root(&message, &info, smooth_time ? NULL : &local_receive,
-                            our_root_delay, our_root_dispersion))
+                            server_state.root_delay,
+                            REF_GetServerRootDispersion(&server_state, &local_transmit)))
         return 0;
     }
   }
 
-  do {
-    /* Prepare random bits which will be added to the transmit timestamp */
-    UTI_GetNtp64Fuzz(&ts_fuzz, precision);
-
-    /* Get a more accurate transmit timestamp if it needs to be saved in the
-       packet (i.e. in the server, symmetric, and broadcast basic modes) */
-    if (!interleaved && precision < 32) {
-      LCL_ReadCookedTime(&local_transmit, &local_transmit_err);
-      if (smooth_time)
-        UTI_AddDoubleToTimespec(&local_transmit, smooth_offset, &local_transmit);
-    }
-
-    UTI_TimespecToNtp64(interleaved ? &local_tx->ts : &local_transmit,
-                        &message.transmit_ts, &ts_fuzz);
+  /* Get a more accurate transmit timestamp if it needs to be saved in the
+     packet (i.e. in the server, symmetric, and broadcast basic modes) */
+  if (!interleaved && precision < 32) {
+    LCL_ReadCookedTime(&local_transmit, &local_transmit_err);
+    if (smooth_time)
+      UTI_AddDoubleToTimespec(&local_transmit, smooth_offset, &local_transmit);
+  }
 
-    /* Do not send a packet with a non-zero transmit timestamp which is
-       equal to any of the following timestamps:
-       - receive (to allow reliable detection of the interleaved mode)
-       - originate (to prevent the packet from being its own valid response
-                    in the symmetric mode)
-       - previous transmit (to invalidate responses to the previous packet)
-       (the precision must be at least -30 to prevent an infinite loop!) */
-  } while (!UTI_IsZeroNtp64(&message.transmit_ts) &&
-           UTI_IsEqualAnyNtp64(&message.transmit_ts, &message.receive_ts,
-                               &message.originate_ts, local_ntp_tx));
+  /* Do not send a packet with a non-zero transmit timestamp which is
+     equal to any of the following timestamps:
+     - receive (to allow reliable detection of the interleaved mode)
+     - originate (to prevent the packet from being its own valid response
+                  in the symmetric mode)
+     - previous transmit (to invalidate responses to the previous packet) */
+  set_timestamp(&message.transmit_ts, interleaved ? &local_tx->ts : &local_transmit,
+                precision, NULL, NULL, &message.receive_ts, &message.originate_ts,
+                local_ntp_tx);
 
-  /* Encode in server timestamps a flag indicating RX timestamp to avoid
-     saving all RX timestamps for detection of interleaved requests */
-  if (my_mode == MODE_SERVER || my_mode == MODE_PASSIVE) {
-    message.receive_ts.lo |= htonl(1);
-    message.transmit_ts.lo &= ~htonl(1);
-  }
+  if (my_mode == MODE_SERVER || my_mode == MODE_PASSIVE)
+    encode_rx_flag(&message);
 
   /* Generate the authentication data */
   if (auth) {
@@ -2660,7 +2718,7 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
   NTP_Mode my_mode;
   NTP_Local_Timestamp local_tx, *tx_ts;
   NTP_int64 ntp_rx, *local_ntp_rx;
-  int log_index, interleaved, poll, version;
+  int logged, interleaved, poll, version;
   CLG_Limit limit;
   uint32_t kod;
 
@@ -2704,10 +2762,9 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
   }
 
   kod = 0;
-  log_index = CLG_LogServiceAccess(CLG_NTP, &remote_addr->ip_addr, &rx_ts->ts);
 
   /* Don't reply to all requests if the rate is excessive */
-  limit = log_index >= 0 ? CLG_LimitServiceRate(CLG_NTP, log_index) : CLG_PASS;
+  limit = CLG_LogAndLimitServiceAccess(CLG_NTP, &remote_addr->ip_addr, &rx_ts->ts, &logged);
   if (limit == CLG_DROP) {
       DEBUG_LOG("NTP packet discarded to limit response rate");
       return;
@@ -2741,17 +2798,18 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
      transmit timestamp (this is verified in transmit_packet()).  For a new
      client starting with a zero origin timestamp, the third response is the
      earliest one that can be interleaved. */
-  if (kod == 0 && log_index >= 0 && info.version == 4 &&
+  if (kod == 0 && logged && info.version == 4 &&
       message->originate_ts.lo & htonl(1) &&
       UTI_CompareNtp64(&message->receive_ts, &message->transmit_ts) != 0) {
     ntp_rx = message->originate_ts;
     local_ntp_rx = &ntp_rx;
     zero_local_timestamp(&local_tx);
-    interleaved = CLG_GetNtpTxTimestamp(&ntp_rx, &local_tx.ts, &local_tx.source);
+    interleaved = CLG_GetNtpTxTimestamp(&remote_addr->ip_addr, &ntp_rx,
+                                        &local_tx.ts, &local_tx.source);
 
     tx_ts = &local_tx;
     if (interleaved)
-      CLG_DisableNtpTimestamps(&ntp_rx);
+      CLG_DisableNtpTimestamps(&remote_addr->ip_addr, &ntp_rx);
   }
 
   CLG_UpdateNtpStats(kod == 0 && info.auth.mode != NTP_AUTH_NONE &&
@@ -2774,7 +2832,8 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
     return;
 
   if (local_ntp_rx)
-    CLG_SaveNtpTimestamps(local_ntp_rx, &tx_ts->ts, tx_ts->source);
+    CLG_SaveNtpTimestamps(&remote_addr->ip_addr, local_ntp_rx,
+                          &tx_ts->ts, tx_ts->source);
 }
 
 /* ================================================== */
@@ -2860,16 +2919,18 @@ NCR_ProcessTxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
   local_ntp_rx = &message->receive_ts;
   new_tx = *tx_ts;
 
-  if (!CLG_GetNtpTxTimestamp(local_ntp_rx, &old_tx.ts, &old_tx.source))
+  if (!CLG_GetNtpTxTimestamp(&remote_addr->ip_addr, local_ntp_rx,
+                             &old_tx.ts, &old_tx.source))
     return;
 
   /* Undo a clock adjustment between the RX and TX timestamps to minimise error
      in the delay measured by the client */
-  CLG_UndoNtpTxTimestampSlew(local_ntp_rx, &new_tx.ts);
+  CLG_UndoNtpTxTimestampSlew(&remote_addr->ip_addr, local_ntp_rx, &new_tx.ts);
 
   update_tx_timestamp(&old_tx, &new_tx, local_ntp_rx, NULL, message);
 
-  CLG_UpdateNtpTxTimestamp(local_ntp_rx, &new_tx.ts, new_tx.source);
+  CLG_UpdateNtpTxTimestamp(&remote_addr->ip_addr, local_ntp_rx,
+                           &new_tx.ts, new_tx.source);
 }
 
 /* ================================================== */
@@ -3134,6 +3195,8 @@ NCR_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all)
  {
   ADF_Status status;
 
+  NWK_LockAccessRestrictions();
+
   if (allow) {
     if (all) {
       status = ADF_AllowAll(access_auth_table, ip_addr, subnet_bits);
@@ -3148,6 +3211,8 @@ NCR_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all)
     }
   }
 
+  NWK_UnlockAccessRestrictions();
+
   if (status != ADF_SUCCESS)
     return 0;
 
@@ -32,7 +32,9 @@
 #include "addressing.h"
 #include "srcparams.h"
 #include "ntp.h"
+#include "reference.h"
 #include "reports.h"
+#include "util.h"
 
 typedef enum {
   NTP_SERVER, NTP_PEER
@@ -126,6 +128,18 @@ extern void NCR_GetNTPReport(NCR_Instance inst, RPT_NTPReport *report);
 extern int NCR_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all);
 extern int NCR_CheckAccessRestriction(IPAddr *ip_addr);
 
+/* Form a basic response to a client request (without extension fields
+   and authentication), or a RATE KoD if kod_rate is non-zero, from
+   a snapshot of the reference and the cooked receive and transmit times.
+   A non-zero smoothing offset is applied to the timestamps.  The random
+   bits are provided by the specified function.  This function can be
+   called from the server threads. */
+extern void NCR_FormServerResponse(NTP_Packet *request, NTP_Packet *response, int version,
+                                   int poll, int kod_rate, REF_ServerState *state,
+                                   struct timespec *rx_ts, struct timespec *tx_ts,
+                                   double smooth_offset, int suppress_leap,
+                                   UTI_RandomFunction get_random, void *random_arg);
+
 extern void NCR_IncrementActivityCounters(NCR_Instance inst, int *online, int *offline, 
                                           int *burst_online, int *burst_offline);
 
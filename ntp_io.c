@@ -49,6 +49,22 @@
 
 #define INVALID_SOCK_FD -1
 
+/* Maximum number of packets queued for transmission in one batch */
+#define MAX_QUEUED_PACKETS 16
+
+/* Packet queued for transmission with its addresses */
+typedef struct {
+  NTP_Remote_Address remote_addr;
+  NTP_Local_Address local_addr;
+  int process_tx;
+  /* Offset of the NTP message in the buffer (non-zero with NTP-over-PTP) */
+  int ntp_offset;
+  union {
+    NTP_Packet ntp;
+    PTP_NtpMessage ptp;
+  } buf;
+} QueuedPacket;
+
 /* The server/peer and client sockets for IPv4 and IPv6 */
 static int server_sock_fd4;
 static int server_sock_fd6;
@@ -65,8 +81,8 @@ static int separate_client_sockets;
 
 /* Flag indicating the server sockets are not created dynamically when needed,
    either to have a socket for client requests when separate client sockets
-   are disabled and client port is equal to server port, or the server port is
-   disabled */
+   are disabled and client port is equal to server port, to share the server
+   port with sockets of server threads, or the server port is disabled */
 static int permanent_server_sockets;
 
 /* Flag indicating the server IPv4 socket is bound to an address */
@@ -82,6 +98,26 @@ static int ptp_sock_fd6;
 /* Buffer for transmitted NTP-over-PTP messages */
 static PTP_NtpMessage *ptp_message;
 
+/* Flag enabling queueing of transmitted packets while processing
+   received messages, and the queue which is sent at the end of the
+   processing using a single system call for each socket */
+static int queue_packets;
+static int num_queued_packets;
+static SCK_Message queued_messages[MAX_QUEUED_PACKETS];
+static QueuedPacket queued_packets[MAX_QUEUED_PACKETS];
+static int sent_packets[MAX_QUEUED_PACKETS];
+
+/* Maximum number of messages received from a socket in one call, flag
+   enabling adaptation of the number for the server sockets to the load,
+   and the current numbers for the IPv4/IPv6 server and PTP sockets */
+static int max_recv_batch;
+static int adaptive_recv_batch;
+static int server_recv_batches[4];
+
+/* Histogram of the number of messages received from server sockets in
+   one call, using power-of-two buckets */
+static uint64_t server_rx_batches[RPT_RX_BATCH_BUCKETS];
+
 /* Flag indicating that we have been initialised */
 static int initialised=0;
 
@@ -89,6 +125,7 @@ static int initialised=0;
 
 /* Forward prototypes */
 static void read_from_socket(int sock_fd, int event, void *anything);
+static void send_queued_packets(void);
 
 /* ================================================== */
 
@@ -140,6 +177,9 @@ open_socket(int family, int local_port, int client_only, IPSockAddr *remote_addr
   if (!client_only && family == IPADDR_INET4 && local_addr.port > 0)
     bound_server_sock_fd4 = local_addr.ip_addr.addr.in4 != INADDR_ANY;
 
+  if (!client_only)
+    NIO_EnableBusyPolling(sock_fd);
+
   /* Enable kernel/HW timestamping of packets */
 #ifdef HAVE_LINUX_TIMESTAMPING
   if (!NIO_Linux_SetTimestampSocketOptions(sock_fd, client_only, &events))
@@ -155,6 +195,24 @@ open_socket(int family, int local_port, int client_only, IPSockAddr *remote_addr
 
 /* ================================================== */
 
+void
+NIO_EnableBusyPolling(int sock_fd)
+{
+  static int warned = 0;
+  int timeout, budget, prefer;
+
+  timeout = CNF_GetBusyPoll(&budget, &prefer);
+  if (timeout <= 0)
+    return;
+
+  if (!SCK_EnableBusyPolling(sock_fd, timeout, budget, prefer) && !warned) {
+    LOG(LOGS_WARN, "Could not enable busy polling");
+    warned = 1;
+  }
+}
+
+/* ================================================== */
+
 static int
 open_separate_client_socket(IPSockAddr *remote_addr)
 {
@@ -169,6 +227,10 @@ close_socket(int sock_fd)
   if (sock_fd == INVALID_SOCK_FD)
     return;
 
+  /* Don't leave queued packets for a closed socket */
+  if (num_queued_packets > 0)
+    send_queued_packets();
+
   SCH_RemoveFileHandler(sock_fd);
   SCK_CloseSocket(sock_fd);
 }
@@ -178,7 +240,7 @@ close_socket(int sock_fd)
 void
 NIO_Initialise(void)
 {
-  int server_port, client_port;
+  int i, server_port, client_port;
 
   assert(!initialised);
   initialised = 1;
@@ -197,6 +259,11 @@ NIO_Initialise(void)
   }
 #endif
 
+  max_recv_batch = SCK_SetMaxReceiveMessages(CNF_GetReceiveBatch(&adaptive_recv_batch));
+  for (i = 0; i < sizeof (server_recv_batches) / sizeof (server_recv_batches[0]); i++)
+    server_recv_batches[i] = adaptive_recv_batch ? 1 : max_recv_batch;
+  memset(server_rx_batches, 0, sizeof (server_rx_batches));
+
   server_port = CNF_GetNTPPort();
   client_port = CNF_GetAcquisitionPort();
 
@@ -205,8 +272,8 @@ NIO_Initialise(void)
   if (client_port < 0)
     client_port = 0;
 
-  permanent_server_sockets = !server_port || (!separate_client_sockets &&
-                                              client_port == server_port);
+  permanent_server_sockets = !server_port || CNF_GetServerThreads() > 0 ||
+                             (!separate_client_sockets && client_port == server_port);
 
   server_sock_fd4 = INVALID_SOCK_FD;
   server_sock_fd6 = INVALID_SOCK_FD;
@@ -473,11 +540,52 @@ process_message(SCK_Message *message, int sock_fd, int event)
 
 /* ================================================== */
 
+static int *
+get_server_recv_batch(int sock_fd)
+{
+  if (sock_fd == INVALID_SOCK_FD)
+    return NULL;
+  if (sock_fd == server_sock_fd4)
+    return &server_recv_batches[0];
+  if (sock_fd == server_sock_fd6)
+    return &server_recv_batches[1];
+  if (sock_fd == ptp_sock_fd4)
+    return &server_recv_batches[2];
+  if (sock_fd == ptp_sock_fd6)
+    return &server_recv_batches[3];
+  return NULL;
+}
+
+/* ================================================== */
+
+static void
+update_server_recv_batch(int *batch, int received)
+{
+  int bucket;
+
+  if (received > 0) {
+    for (bucket = 0; bucket + 1 < RPT_RX_BATCH_BUCKETS && received >> (bucket + 1); bucket++)
+      ;
+    server_rx_batches[bucket]++;
+  }
+
+  if (!adaptive_recv_batch)
+    return;
+
+  /* Double the batch if it was filled and halve it if it was mostly empty */
+  if (received >= *batch)
+    *batch = MIN(2 * *batch, max_recv_batch);
+  else if (received <= *batch / 4)
+    *batch = MAX(*batch / 2, 1);
+}
+
+/* ================================================== */
+
 static void
 read_from_socket(int sock_fd, int event, void *anything)
 {
+  int i, received, *batch, flags = 0;
   SCK_Message *messages;
-  int i, received, flags = 0;
 
   if (event == SCH_FILE_EXCEPTION) {
 #ifdef HAVE_LINUX_TIMESTAMPING
@@ -487,12 +595,64 @@ read_from_socket(int sock_fd, int event, void *anything)
 #endif
   }
 
-  messages = SCK_ReceiveMessages(sock_fd, flags, &received);
+  batch = event == SCH_FILE_INPUT ? get_server_recv_batch(sock_fd) : NULL;
+
+  messages = SCK_ReceiveMessages(sock_fd, flags, batch ? *batch : max_recv_batch, &received);
+
+  if (batch)
+    update_server_recv_batch(batch, received);
+
   if (!messages)
     return;
 
+  queue_packets = 1;
+
   for (i = 0; i < received; i++)
     process_message(&messages[i], sock_fd, event);
+
+  queue_packets = 0;
+
+  send_queued_packets();
+}
+
+/* ================================================== */
+
+void
+NIO_GetServerStatsReport(RPT_ServerStatsReport *report)
+{
+  memcpy(report->ntp_rx_batches, server_rx_batches, sizeof (report->ntp_rx_batches));
+}
+
+/* ================================================== */
+
+void
+NIO_ProcessServerMessage(SCK_Message *message)
+{
+  int sock_fd;
+
+  if (message->addr_type != SCK_ADDR_IP) {
+    DEBUG_LOG("Unexpected address type");
+    return;
+  }
+
+  switch (message->remote_addr.ip.ip_addr.family) {
+    case IPADDR_INET4:
+      sock_fd = server_sock_fd4;
+      break;
+    case IPADDR_INET6:
+      sock_fd = server_sock_fd6;
+      break;
+    default:
+      sock_fd = INVALID_SOCK_FD;
+      break;
+  }
+
+  if (sock_fd == INVALID_SOCK_FD) {
+    DEBUG_LOG("No server socket for message");
+    return;
+  }
+
+  process_message(message, sock_fd, SCH_FILE_INPUT);
 }
 
 /* ================================================== */
@@ -588,6 +748,79 @@ wrap_message(SCK_Message *message, int sock_fd)
 /* ================================================== */
 /* Send a packet to remote address from local address */
 
+static int
+queue_packet(SCK_Message *message, NTP_Remote_Address *remote_addr,
+             NTP_Local_Address *local_addr, int process_tx)
+{
+  QueuedPacket *packet;
+
+  if (num_queued_packets >= MAX_QUEUED_PACKETS)
+    send_queued_packets();
+
+  packet = &queued_packets[num_queued_packets];
+
+  if (message->length > sizeof (packet->buf)) {
+    DEBUG_LOG("Unexpected length");
+    return 0;
+  }
+
+  memcpy(&packet->buf, message->data, message->length);
+  packet->remote_addr = *remote_addr;
+  packet->local_addr = *local_addr;
+  packet->process_tx = process_tx;
+  packet->ntp_offset = is_ptp_socket(local_addr->sock_fd) ? PTP_NTP_PREFIX_LENGTH : 0;
+
+  queued_messages[num_queued_packets] = *message;
+  queued_messages[num_queued_packets].data = &packet->buf;
+  num_queued_packets++;
+
+  return 1;
+}
+
+/* ================================================== */
+
+static void
+send_queued_packets(void)
+{
+  NTP_Local_Timestamp local_ts, tx_ts;
+  QueuedPacket *packet;
+  int i, j, k, sock_fd;
+
+  for (i = 0; i < num_queued_packets; i = j) {
+    sock_fd = queued_packets[i].local_addr.sock_fd;
+
+    for (j = i + 1; j < num_queued_packets &&
+         queued_packets[j].local_addr.sock_fd == sock_fd; j++)
+      ;
+
+    /* Get a new daemon timestamp closer to the transmission */
+    LCL_ReadCookedTime(&local_ts.ts, &local_ts.err);
+    local_ts.source = NTP_TS_DAEMON;
+    local_ts.rx_duration = 0.0;
+    local_ts.net_correction = 0.0;
+
+    SCK_SendMessages(sock_fd, &queued_messages[i], j - i, 0, &sent_packets[i]);
+
+    /* Update the daemon transmit timestamps which were saved before
+       the packets were queued (only of packets which were sent as in
+       the processing of packets sent without queueing) */
+    for (k = i; k < j; k++) {
+      packet = &queued_packets[k];
+      if (!packet->process_tx || !sent_packets[k])
+        continue;
+
+      tx_ts = local_ts;
+      NSR_ProcessTx(&packet->remote_addr, &packet->local_addr, &tx_ts,
+                    (NTP_Packet *)((char *)&packet->buf + packet->ntp_offset),
+                    queued_messages[k].length - packet->ntp_offset);
+    }
+  }
+
+  num_queued_packets = 0;
+}
+
+/* ================================================== */
+
 int
 NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
                NTP_Local_Address *local_addr, int length, int process_tx)
@@ -634,6 +867,9 @@ NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
     NIO_Linux_RequestTxTimestamp(&message, local_addr->sock_fd, remote_addr);
 #endif
 
+  if (queue_packets)
+    return queue_packet(&message, remote_addr, local_addr, process_tx);
+
   if (!SCK_SendMessage(local_addr->sock_fd, &message, 0))
     return 0;
 
@@ -31,6 +31,7 @@
 
 #include "ntp.h"
 #include "addressing.h"
+#include "reports.h"
 #include "socket.h"
 
 /* Function to initialise the module. */
@@ -63,6 +64,17 @@ extern int NIO_IsServerSocketOpen(void);
 /* Function to check if client packets can be sent to a server */
 extern int NIO_IsServerConnectable(NTP_Remote_Address *remote_addr);
 
+/* Function to enable busy polling on a server socket if configured */
+extern void NIO_EnableBusyPolling(int sock_fd);
+
+/* Function to fill the histogram of received batches in a server
+   statistics report */
+extern void NIO_GetServerStatsReport(RPT_ServerStatsReport *report);
+
+/* Function to process a message which was received by a server socket
+   of a server thread */
+extern void NIO_ProcessServerMessage(SCK_Message *message);
+
 /* Function to unwrap an NTP message from non-native transport (e.g. PTP) */
 extern int NIO_UnwrapMessage(SCK_Message *message, int sock_fd, double *net_correction);
 
@@ -0,0 +1,861 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+
+  =======================================================================
+
+  Threads answering NTP client requests.  Each thread has its own server
+  sockets sharing the NTP port with the server sockets of the main thread
+  (using SO_REUSEPORT), which makes the kernel distribute the requests
+  between the threads.  The threads respond to basic client requests using
+  a copy of the reference and clock state published by the main thread.
+  The clients are logged and their response rate is limited in the shard of
+  the client log owning their address, which is shared with the main thread.
+  Other packets, including requests in the interleaved mode, are passed to
+  the main thread.
+
+  The threads must not call functions which are not thread-safe (e.g.
+  logging, scheduling, or the socket functions using static buffers).
+  */
+
+#include "config.h"
+
+#include "sysincl.h"
+
+#include "ntp_workers.h"
+#include "conf.h"
+#include "logging.h"
+
+#if defined(LINUX) && defined(HAVE_RECVMMSG) && defined(HAVE_GETRANDOM) && \
+    defined(HAVE_IN_PKTINFO) && defined(SO_REUSEPORT)
+
+#include <poll.h>
+#include <pthread.h>
+
+#include "clientlog.h"
+#include "local.h"
+#include "memory.h"
+#include "ntp.h"
+#include "ntp_core.h"
+#include "ntp_io.h"
+#include "reference.h"
+#include "sched.h"
+#include "smooth.h"
+#include "socket.h"
+#include "util.h"
+
+#define INVALID_SOCK_FD -1
+
+/* Maximum number of messages received and sent in one system call */
+#define MAX_WORKER_MESSAGES 16
+
+/* Maximum number of full batches processed before checking for
+   the request to stop the thread */
+#define MAX_BUSY_BATCHES 64
+
+/* Interval of periodic updates of the server state */
+#define STATE_UPDATE_INTERVAL 1.0
+
+#define CMSG_BUF_SIZE 256
+
+/* State of the clock needed to form server responses.  The cooked time and
+   smoothing offset are extrapolated from the time of the update.  The state
+   of the reference is published by the reference module. */
+typedef struct {
+  struct timespec raw_time;
+  struct timespec cooked_time;
+  double correction_rate;
+  int smoothing;
+  int suppress_leap;
+  double smooth_offset;
+  double smooth_rate;
+  double precision_quantum;
+  int min_poll;
+} ServerState;
+
+/* Packet passed from a server thread to the main thread */
+typedef struct {
+  IPSockAddr remote_addr;
+  IPAddr local_addr;
+  int if_index;
+  struct timespec kernel_ts;
+  int length;
+  NTP_Packet packet;
+} ForwardedMessage;
+
+typedef struct {
+  union {
+    struct sockaddr_in in4;
+#ifdef FEAT_IPV6
+    struct sockaddr_in6 in6;
+#endif
+  } name;
+  struct iovec rx_iov;
+  struct iovec tx_iov;
+  NTP_Packet request;
+  NTP_Packet response;
+  struct cmsghdr rx_cmsg_buf[CMSG_BUF_SIZE / sizeof (struct cmsghdr)];
+  struct cmsghdr tx_cmsg_buf[CMSG_BUF_SIZE / sizeof (struct cmsghdr)];
+} Message;
+
+typedef struct {
+  uint64_t hits;
+  uint64_t drops;
+  uint64_t daemon_rx_timestamps;
+  uint64_t kernel_rx_timestamps;
+  uint64_t daemon_tx_timestamps;
+} ServerStats;
+
+typedef struct {
+  pthread_t thread;
+  /* IPv4 and IPv6 server sockets */
+  int sock_fds[2];
+  struct mmsghdr rx_headers[MAX_WORKER_MESSAGES];
+  struct mmsghdr tx_headers[MAX_WORKER_MESSAGES];
+  Message messages[MAX_WORKER_MESSAGES];
+  /* Copies of the server and reference state used for the current batch */
+  ServerState state;
+  REF_ServerState ref_state;
+  /* Buffer of random bytes for the timestamp fuzz */
+  unsigned char random_buf[256];
+  unsigned int random_available;
+  pthread_mutex_t stats_lock;
+  ServerStats stats;
+} Worker;
+
+/* ================================================== */
+
+static Worker *workers;
+static int n_workers;
+static int started;
+
+static SCH_TimeoutID start_timeout_id;
+
+/* Flag indicating the clients are logged in the client log */
+static int log_clients;
+static SCH_TimeoutID state_timeout_id;
+
+/* Pipe used to request the threads to stop */
+static int quit_fds[2];
+
+/* Socket pair used to pass packets from the threads to the main thread */
+static int forward_fd;
+static int main_forward_fd;
+
+/* Lock protecting the access table of the NTP server from modifications
+   while it is checked by the threads */
+static pthread_rwlock_t access_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Server state published by the main thread */
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
+static ServerState server_state;
+
+/* ================================================== */
+
+static void
+update_state(void)
+{
+  struct timespec raw, cooked;
+  ServerState state;
+
+  LCL_ReadRawTime(&state.raw_time);
+  LCL_CookTime(&state.raw_time, &state.cooked_time, NULL);
+  UTI_AddDoubleToTimespec(&state.raw_time, 1.0, &raw);
+  LCL_CookTime(&raw, &cooked, NULL);
+  state.correction_rate = UTI_DiffTimespecsToDouble(&cooked, &state.cooked_time) - 1.0;
+
+  state.smoothing = SMT_IsEnabled();
+  if (state.smoothing) {
+    state.smooth_offset = SMT_GetOffset(&state.cooked_time);
+    UTI_AddDoubleToTimespec(&state.cooked_time, 1.0, &cooked);
+    state.smooth_rate = SMT_GetOffset(&cooked) - state.smooth_offset;
+  } else {
+    state.smooth_offset = 0.0;
+    state.smooth_rate = 0.0;
+  }
+
+  /* Suppress leap second when smoothing and slew mode are enabled */
+  state.suppress_leap = state.smoothing && REF_GetLeapMode() == REF_LeapModeSlew;
+
+  state.precision_quantum = LCL_GetSysPrecisionAsQuantum();
+  state.min_poll = CLG_GetNtpMinPoll();
+
+  pthread_mutex_lock(&state_lock);
+  server_state = state;
+  pthread_mutex_unlock(&state_lock);
+}
+
+/* ================================================== */
+
+static void
+state_timeout(void *arg)
+{
+  state_timeout_id = SCH_AddTimeoutByDelay(STATE_UPDATE_INTERVAL, state_timeout, NULL);
+  update_state();
+}
+
+/* ================================================== */
+
+static void
+handle_slew(struct timespec *raw, struct timespec *cooked, double dfreq,
+            double doffset, LCL_ChangeType change_type, void *anything)
+{
+  update_state();
+}
+
+/* ================================================== */
+
+static void
+handle_dispersion(double dispersion, void *anything)
+{
+  /* The slewing frequency has changed.  The notification can come before
+     the system driver finished the update, so update the state later. */
+  SCH_RemoveTimeout(state_timeout_id);
+  state_timeout_id = SCH_AddTimeoutByDelay(0.0, state_timeout, NULL);
+}
+
+/* ================================================== */
+
+static void
+read_forwarded_message(int fd, int event, void *anything)
+{
+  ForwardedMessage msg;
+  SCK_Message message;
+  int length;
+
+  length = SCK_Receive(fd, &msg, sizeof (msg), 0);
+  if (length < (int)offsetof(ForwardedMessage, packet) + NTP_HEADER_LENGTH ||
+      length != (int)offsetof(ForwardedMessage, packet) + msg.length)
+    return;
+
+  SCK_InitMessage(&message, SCK_ADDR_IP);
+  message.data = &msg.packet;
+  message.length = msg.length;
+  message.remote_addr.ip = msg.remote_addr;
+  message.local_addr.ip = msg.local_addr;
+  message.if_index = msg.if_index;
+  message.timestamp.kernel = msg.kernel_ts;
+
+  NIO_ProcessServerMessage(&message);
+}
+
+/* ================================================== */
+
+static int
+forward_message(IPSockAddr *remote_addr, IPAddr *local_addr, int if_index,
+                struct timespec *kernel_ts, NTP_Packet *packet, int length)
+{
+  ForwardedMessage msg;
+
+  msg.remote_addr = *remote_addr;
+  msg.local_addr = *local_addr;
+  msg.if_index = if_index;
+  msg.kernel_ts = *kernel_ts;
+  msg.length = length;
+  memcpy(&msg.packet, packet, length);
+
+  /* Drop the packet if the main thread is too busy */
+  return send(forward_fd, &msg, offsetof(ForwardedMessage, packet) + length,
+              MSG_DONTWAIT) >= 0;
+}
+
+/* ================================================== */
+
+static void
+get_random_bytes(void *buf, unsigned int length, void *arg)
+{
+  Worker *worker = arg;
+  unsigned int i;
+
+  for (i = 0; i < length; i++) {
+    if (worker->random_available == 0) {
+      UTI_GetRandomBytesUnbuffered(worker->random_buf, sizeof (worker->random_buf));
+      worker->random_available = sizeof (worker->random_buf);
+    }
+    ((unsigned char *)buf)[i] = worker->random_buf[--worker->random_available];
+  }
+}
+
+/* ================================================== */
+
+static void
+cook_time(ServerState *state, struct timespec *raw, struct timespec *cooked)
+{
+  double elapsed;
+
+  elapsed = UTI_DiffTimespecsToDouble(raw, &state->raw_time);
+  UTI_AddDoubleToTimespec(&state->cooked_time, elapsed * (1.0 + state->correction_rate),
+                          cooked);
+}
+
+/* ================================================== */
+
+static void
+read_raw_time(struct timespec *ts)
+{
+  if (clock_gettime(CLOCK_REALTIME, ts) < 0)
+    UTI_ZeroTimespec(ts);
+}
+
+/* ================================================== */
+
+static int
+process_request(Worker *worker, struct mmsghdr *rx_hdr, Message *msg,
+                struct timespec *rx_raw_ts, struct mmsghdr *tx_hdr, ServerStats *stats)
+{
+  struct timespec kernel_ts, rx_ts, tx_ts;
+  NTP_Packet *request, *response;
+  ServerState *state = &worker->state;
+  double smooth_offset;
+  IPSockAddr remote_addr;
+  struct cmsghdr *cmsg;
+  struct msghdr *tx_msg;
+  int if_index, length, version, allowed, logged;
+  IPAddr local_addr;
+  CLG_Limit limit;
+
+  if (rx_hdr->msg_hdr.msg_flags & (MSG_TRUNC | MSG_CTRUNC))
+    return 0;
+
+  SCK_SockaddrToIPSockAddr(rx_hdr->msg_hdr.msg_name, rx_hdr->msg_hdr.msg_namelen,
+                           &remote_addr);
+  if (remote_addr.ip_addr.family == IPADDR_UNSPEC)
+    return 0;
+
+  local_addr.family = IPADDR_UNSPEC;
+  if_index = INVALID_IF_INDEX;
+  UTI_ZeroTimespec(&kernel_ts);
+
+  for (cmsg = CMSG_FIRSTHDR(&rx_hdr->msg_hdr); cmsg;
+       cmsg = CMSG_NXTHDR(&rx_hdr->msg_hdr, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof (struct in_pktinfo))) {
+      struct in_pktinfo ipi;
+
+      memcpy(&ipi, CMSG_DATA(cmsg), sizeof (ipi));
+      local_addr.addr.in4 = ntohl(ipi.ipi_addr.s_addr);
+      local_addr.family = IPADDR_INET4;
+      if_index = ipi.ipi_ifindex;
+    }
+#if defined(FEAT_IPV6) && defined(HAVE_IN6_PKTINFO)
+    else if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO &&
+             cmsg->cmsg_len == CMSG_LEN(sizeof (struct in6_pktinfo))) {
+      struct in6_pktinfo ipi;
+
+      memcpy(&ipi, CMSG_DATA(cmsg), sizeof (ipi));
+      memcpy(&local_addr.addr.in6, &ipi.ipi6_addr.s6_addr, sizeof (local_addr.addr.in6));
+      local_addr.family = IPADDR_INET6;
+      if_index = ipi.ipi6_ifindex;
+    }
+#endif
+#ifdef SCM_TIMESTAMPNS
+    else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS &&
+             cmsg->cmsg_len == CMSG_LEN(sizeof (kernel_ts))) {
+      memcpy(&kernel_ts, CMSG_DATA(cmsg), sizeof (kernel_ts));
+    }
+#endif
+    else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP &&
+             cmsg->cmsg_len == CMSG_LEN(sizeof (struct timeval))) {
+      struct timeval tv;
+
+      memcpy(&tv, CMSG_DATA(cmsg), sizeof (tv));
+      UTI_TimevalToTimespec(&tv, &kernel_ts);
+    }
+  }
+
+  length = rx_hdr->msg_len;
+  if (length < NTP_HEADER_LENGTH || length > sizeof (NTP_Packet))
+    return 0;
+
+  request = &msg->request;
+  version = NTP_LVM_TO_VERSION(request->lvm);
+
+  /* Pass anything else than a basic client request to the main thread,
+     including responses to its own requests if the client and server ports
+     are equal and requests which may be in the interleaved mode (using the
+     same condition as NCR_ProcessRxUnknown()), which need the transmit
+     timestamps saved in the main thread */
+  if (length != NTP_HEADER_LENGTH || NTP_LVM_TO_MODE(request->lvm) != MODE_CLIENT ||
+      version < 1 || version > NTP_VERSION ||
+      (version == 4 && request->originate_ts.lo & htonl(1) &&
+       UTI_CompareNtp64(&request->receive_ts, &request->transmit_ts) != 0)) {
+    if (!forward_message(&remote_addr, &local_addr, if_index, &kernel_ts, request, length))
+      stats->drops++;
+    return 0;
+  }
+
+  pthread_rwlock_rdlock(&access_lock);
+  allowed = NCR_CheckAccessRestriction(&remote_addr.ip_addr);
+  pthread_rwlock_unlock(&access_lock);
+
+  if (!allowed)
+    return 0;
+
+  if (!UTI_IsZeroTimespec(&kernel_ts)) {
+    cook_time(state, &kernel_ts, &rx_ts);
+    stats->kernel_rx_timestamps++;
+  } else {
+    cook_time(state, rx_raw_ts, &rx_ts);
+    stats->daemon_rx_timestamps++;
+  }
+
+  /* Don't reply to all requests if the rate is excessive */
+  if (log_clients) {
+    limit = CLG_LogAndLimitServiceAccess(CLG_NTP, &remote_addr.ip_addr, &rx_ts, &logged);
+    if (limit == CLG_DROP)
+      return 0;
+  } else {
+    limit = CLG_PASS;
+    stats->hits++;
+  }
+
+  smooth_offset = 0.0;
+  if (state->smoothing) {
+    smooth_offset = state->smooth_offset + state->smooth_rate *
+                    UTI_DiffTimespecsToDouble(&rx_ts, &state->cooked_time);
+    if (fabs(smooth_offset) <= state->precision_quantum)
+      smooth_offset = 0.0;
+  }
+
+  read_raw_time(&tx_ts);
+  cook_time(state, &tx_ts, &tx_ts);
+
+  response = &msg->response;
+  NCR_FormServerResponse(request, response, version, MAX(state->min_poll, request->poll),
+                         limit == CLG_KOD, &worker->ref_state, &rx_ts, &tx_ts,
+                         smooth_offset, state->suppress_leap, get_random_bytes, worker);
+
+  stats->daemon_tx_timestamps++;
+
+  /* Send the response back to the source address of the request from the
+     address which received the request */
+  msg->tx_iov.iov_base = response;
+  msg->tx_iov.iov_len = NTP_HEADER_LENGTH;
+
+  tx_msg = &tx_hdr->msg_hdr;
+  tx_msg->msg_name = rx_hdr->msg_hdr.msg_name;
+  tx_msg->msg_namelen = rx_hdr->msg_hdr.msg_namelen;
+  tx_msg->msg_iov = &msg->tx_iov;
+  tx_msg->msg_iovlen = 1;
+  tx_msg->msg_control = NULL;
+  tx_msg->msg_controllen = 0;
+  tx_msg->msg_flags = 0;
+  tx_hdr->msg_len = 0;
+
+  if (local_addr.family == IPADDR_INET4) {
+    struct in_pktinfo ipi;
+
+    memset(&ipi, 0, sizeof (ipi));
+    ipi.ipi_spec_dst.s_addr = htonl(local_addr.addr.in4);
+    if (if_index != INVALID_IF_INDEX)
+      ipi.ipi_ifindex = if_index;
+
+    memset(msg->tx_cmsg_buf, 0, CMSG_SPACE(sizeof (ipi)));
+    cmsg = msg->tx_cmsg_buf;
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof (ipi));
+    memcpy(CMSG_DATA(cmsg), &ipi, sizeof (ipi));
+
+    tx_msg->msg_control = msg->tx_cmsg_buf;
+    tx_msg->msg_controllen = CMSG_SPACE(sizeof (ipi));
+  }
+#if defined(FEAT_IPV6) && defined(HAVE_IN6_PKTINFO)
+  else if (local_addr.family == IPADDR_INET6) {
+    struct in6_pktinfo ipi;
+
+    memset(&ipi, 0, sizeof (ipi));
+    memcpy(&ipi.ipi6_addr.s6_addr, &local_addr.addr.in6, sizeof (ipi.ipi6_addr.s6_addr));
+    if (if_index != INVALID_IF_INDEX)
+      ipi.ipi6_ifindex = if_index;
+
+    memset(msg->tx_cmsg_buf, 0, CMSG_SPACE(sizeof (ipi)));
+    cmsg = msg->tx_cmsg_buf;
+    cmsg->cmsg_level = IPPROTO_IPV6;
+    cmsg->cmsg_type = IPV6_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof (ipi));
+    memcpy(CMSG_DATA(cmsg), &ipi, sizeof (ipi));
+
+    tx_msg->msg_control = msg->tx_cmsg_buf;
+    tx_msg->msg_controllen = CMSG_SPACE(sizeof (ipi));
+  }
+#endif
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+process_socket(Worker *worker, int sock_fd)
+{
+  struct timespec rx_raw_ts;
+  struct mmsghdr *hdr;
+  ServerStats stats;
+  Message *msg;
+  int i, n, n_tx, r, sent;
+
+  for (i = 0; i < MAX_WORKER_MESSAGES; i++) {
+    msg = &worker->messages[i];
+    hdr = &worker->rx_headers[i];
+
+    msg->rx_iov.iov_base = &msg->request;
+    msg->rx_iov.iov_len = sizeof (msg->request);
+    hdr->msg_hdr.msg_name = &msg->name;
+    hdr->msg_hdr.msg_namelen = sizeof (msg->name);
+    hdr->msg_hdr.msg_iov = &msg->rx_iov;
+    hdr->msg_hdr.msg_iovlen = 1;
+    hdr->msg_hdr.msg_control = msg->rx_cmsg_buf;
+    hdr->msg_hdr.msg_controllen = sizeof (msg->rx_cmsg_buf);
+    hdr->msg_hdr.msg_flags = 0;
+    hdr->msg_len = 0;
+  }
+
+  n = recvmmsg(sock_fd, worker->rx_headers, MAX_WORKER_MESSAGES, MSG_DONTWAIT, NULL);
+  if (n <= 0)
+    return 0;
+
+  read_raw_time(&rx_raw_ts);
+
+  pthread_mutex_lock(&state_lock);
+  worker->state = server_state;
+  pthread_mutex_unlock(&state_lock);
+
+  REF_ReadServerState(&worker->ref_state);
+
+  memset(&stats, 0, sizeof (stats));
+
+  for (i = n_tx = 0; i < n; i++) {
+    if (process_request(worker, &worker->rx_headers[i], &worker->messages[i], &rx_raw_ts,
+                        &worker->tx_headers[n_tx], &stats))
+      n_tx++;
+  }
+
+  for (sent = 0; sent < n_tx; sent += r) {
+    r = sendmmsg(sock_fd, &worker->tx_headers[sent], n_tx - sent, 0);
+    if (r <= 0)
+      break;
+  }
+
+  pthread_mutex_lock(&worker->stats_lock);
+  worker->stats.hits += stats.hits;
+  worker->stats.drops += stats.drops;
+  worker->stats.daemon_rx_timestamps += stats.daemon_rx_timestamps;
+  worker->stats.kernel_rx_timestamps += stats.kernel_rx_timestamps;
+  worker->stats.daemon_tx_timestamps += stats.daemon_tx_timestamps;
+  pthread_mutex_unlock(&worker->stats_lock);
+
+  return n;
+}
+
+/* ================================================== */
+
+static void *
+run_worker(void *arg)
+{
+  struct pollfd fds[3];
+  Worker *worker = arg;
+  int i, n_fds, busy, batches;
+
+  for (i = n_fds = 0; i < 2; i++) {
+    if (worker->sock_fds[i] == INVALID_SOCK_FD)
+      continue;
+    fds[n_fds].fd = worker->sock_fds[i];
+    fds[n_fds].events = POLLIN;
+    n_fds++;
+  }
+
+  fds[n_fds].fd = quit_fds[0];
+  fds[n_fds].events = POLLIN;
+
+  while (1) {
+    if (poll(fds, n_fds + 1, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (fds[n_fds].revents)
+      break;
+
+    /* Avoid waiting in poll() while the sockets have full batches of
+       messages, but check the quit pipe from time to time */
+    for (batches = 0; batches < MAX_BUSY_BATCHES; batches++) {
+      for (i = busy = 0; i < n_fds; i++) {
+        if (!fds[i].revents)
+          continue;
+        if (process_socket(worker, fds[i].fd) < MAX_WORKER_MESSAGES)
+          fds[i].revents = 0;
+        else
+          busy = 1;
+      }
+
+      if (!busy)
+        break;
+    }
+  }
+
+  return NULL;
+}
+
+/* ================================================== */
+
+static void
+start_workers(void *arg)
+{
+  sigset_t signals, old_signals;
+  int i;
+
+  start_timeout_id = 0;
+
+  update_state();
+
+  LCL_AddParameterChangeHandler(handle_slew, NULL);
+  LCL_AddDispersionNotifyHandler(handle_dispersion, NULL);
+  state_timeout_id = SCH_AddTimeoutByDelay(STATE_UPDATE_INTERVAL, state_timeout, NULL);
+
+  /* Make sure signals are handled only in the main thread */
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, &old_signals);
+
+  for (i = 0; i < n_workers; i++) {
+    if (pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]))
+      LOG_FATAL("pthread_create() failed");
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+
+  started = 1;
+
+  LOG(LOGS_INFO, "Started %d server threads", n_workers);
+}
+
+/* ================================================== */
+
+static int
+open_socket(int family, int port)
+{
+  int sock_fd, dscp;
+  IPSockAddr local_addr;
+
+  CNF_GetBindAddress(family, &local_addr.ip_addr);
+  local_addr.port = port;
+
+  sock_fd = SCK_OpenUdpSocket(NULL, &local_addr, CNF_GetBindNtpInterface(),
+                              SCK_FLAG_RX_DEST_ADDR | SCK_FLAG_PRIV_BIND);
+  if (sock_fd < 0)
+    LOG_FATAL("Could not open NTP socket on %s for server thread",
+              UTI_IPSockAddrToString(&local_addr));
+
+  dscp = CNF_GetNtpDscp();
+  if (dscp > 0 && dscp < 64) {
+#ifdef IP_TOS
+    if (family == IPADDR_INET4)
+      if (!SCK_SetIntOption(sock_fd, IPPROTO_IP, IP_TOS, dscp << 2))
+        ;
+#endif
+#if defined(FEAT_IPV6) && defined(IPV6_TCLASS)
+    if (family == IPADDR_INET6)
+      if (!SCK_SetIntOption(sock_fd, IPPROTO_IPV6, IPV6_TCLASS, dscp << 2))
+        ;
+#endif
+  }
+
+  NIO_EnableBusyPolling(sock_fd);
+
+  if (!SCK_EnableKernelRxTimestamping(sock_fd))
+    ;
+
+  return sock_fd;
+}
+
+/* ================================================== */
+
+void
+NWK_Initialise(void)
+{
+  NTP_Remote_Address remote_addr;
+  int i, j, port, families[2] = { IPADDR_INET4, IPADDR_INET6 };
+
+  n_workers = CNF_GetServerThreads();
+  port = CNF_GetNTPPort();
+  started = 0;
+  start_timeout_id = state_timeout_id = 0;
+
+  if (n_workers <= 0 || port <= 0) {
+    n_workers = 0;
+    return;
+  }
+
+  log_clients = !CNF_GetNoClientLog();
+
+  /* The client log and responses use /dev/urandom in the threads if
+     getrandom() fails.  Open it here to not race on its lazy opening. */
+  UTI_GetRandomBytesUrandom(&i, sizeof (i));
+
+  workers = MallocArray(Worker, n_workers);
+  memset(workers, 0, sizeof (Worker) * n_workers);
+
+  for (i = 0; i < n_workers; i++) {
+    for (j = 0; j < 2; j++) {
+      workers[i].sock_fds[j] = INVALID_SOCK_FD;
+
+      /* Share only ports which have a server socket in the main thread */
+      remote_addr.ip_addr.family = families[j];
+      remote_addr.port = 0;
+      if (NIO_OpenServerSocket(&remote_addr) < 0)
+        continue;
+
+      workers[i].sock_fds[j] = open_socket(families[j], port);
+    }
+
+    if (workers[i].sock_fds[0] == INVALID_SOCK_FD &&
+        workers[i].sock_fds[1] == INVALID_SOCK_FD)
+      LOG_FATAL("No server socket for server threads");
+
+    pthread_mutex_init(&workers[i].stats_lock, NULL);
+  }
+
+  main_forward_fd = SCK_OpenUnixSocketPair(0, &forward_fd);
+  if (main_forward_fd < 0)
+    LOG_FATAL("Could not open socket pair");
+
+  SCH_AddFileHandler(main_forward_fd, SCH_FILE_INPUT, read_forwarded_message, NULL);
+
+  if (pipe(quit_fds) < 0)
+    LOG_FATAL("pipe() failed : %s", strerror(errno));
+
+  UTI_FdSetCloexec(quit_fds[0]);
+  UTI_FdSetCloexec(quit_fds[1]);
+
+  /* Start the threads from the main loop to have them running with
+     the same system call filter */
+  start_timeout_id = SCH_AddTimeoutByDelay(0.0, start_workers, NULL);
+}
+
+/* ================================================== */
+
+void
+NWK_Finalise(void)
+{
+  int i, j;
+
+  if (n_workers <= 0)
+    return;
+
+  if (started) {
+    if (write(quit_fds[1], "", 1) != 1)
+      LOG_FATAL("write() failed");
+
+    for (i = 0; i < n_workers; i++) {
+      if (pthread_join(workers[i].thread, NULL))
+        LOG_FATAL("pthread_join() failed");
+    }
+
+    LCL_RemoveParameterChangeHandler(handle_slew, NULL);
+    LCL_RemoveDispersionNotifyHandler(handle_dispersion, NULL);
+  }
+
+  SCH_RemoveTimeout(start_timeout_id);
+  SCH_RemoveTimeout(state_timeout_id);
+
+  for (i = 0; i < n_workers; i++) {
+    for (j = 0; j < 2; j++) {
+      if (workers[i].sock_fds[j] != INVALID_SOCK_FD)
+        SCK_CloseSocket(workers[i].sock_fds[j]);
+    }
+    pthread_mutex_destroy(&workers[i].stats_lock);
+  }
+
+  SCH_RemoveFileHandler(main_forward_fd);
+  SCK_CloseSocket(main_forward_fd);
+  SCK_CloseSocket(forward_fd);
+  close(quit_fds[0]);
+  close(quit_fds[1]);
+
+  Free(workers);
+  n_workers = 0;
+}
+
+/* ================================================== */
+
+void
+NWK_AddServerStats(RPT_ServerStatsReport *report)
+{
+  int i;
+
+  for (i = 0; i < n_workers; i++) {
+    pthread_mutex_lock(&workers[i].stats_lock);
+    report->ntp_hits += workers[i].stats.hits;
+    report->ntp_drops += workers[i].stats.drops;
+    report->ntp_daemon_rx_timestamps += workers[i].stats.daemon_rx_timestamps;
+    report->ntp_kernel_rx_timestamps += workers[i].stats.kernel_rx_timestamps;
+    report->ntp_daemon_tx_timestamps += workers[i].stats.daemon_tx_timestamps;
+    pthread_mutex_unlock(&workers[i].stats_lock);
+  }
+}
+
+/* ================================================== */
+
+void
+NWK_LockAccessRestrictions(void)
+{
+  pthread_rwlock_wrlock(&access_lock);
+}
+
+/* ================================================== */
+
+void
+NWK_UnlockAccessRestrictions(void)
+{
+  pthread_rwlock_unlock(&access_lock);
+}
+
+/* ================================================== */
+
+#else
+
+void
+NWK_Initialise(void)
+{
+  if (CNF_GetServerThreads() > 0)
+    LOG_FATAL("Server threads not supported");
+}
+
+void
+NWK_Finalise(void)
+{
+}
+
+void
+NWK_AddServerStats(RPT_ServerStatsReport *report)
+{
+}
+
+void
+NWK_LockAccessRestrictions(void)
+{
+}
+
+void
+NWK_UnlockAccessRestrictions(void)
+{
+}
+
+#endif
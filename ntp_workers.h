@@ -0,0 +1,46 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+
+  =======================================================================
+
+  Header file for the threads answering NTP client requests.
+  */
+
+#ifndef GOT_NTP_WORKERS_H
+#define GOT_NTP_WORKERS_H
+
+#include "reports.h"
+
+/* Open the sockets of the server threads (needs to be called before dropping
+   root privileges) and schedule the start of the threads */
+extern void NWK_Initialise(void);
+
+/* Stop the threads and close their sockets */
+extern void NWK_Finalise(void);
+
+/* Add counters of the server threads to a server statistics report */
+extern void NWK_AddServerStats(RPT_ServerStatsReport *report);
+
+/* Prevent the threads from checking the access restrictions of the server
+   while they are modified by the main thread */
+extern void NWK_LockAccessRestrictions(void);
+extern void NWK_UnlockAccessRestrictions(void);
+
+#endif
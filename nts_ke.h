@@ -56,6 +56,7 @@
 #define NKE_MAX_COOKIE_LENGTH           256
 #define NKE_MAX_COOKIES                 8
 #define NKE_MAX_KEY_LENGTH SIV_MAX_KEY_LENGTH
+#define NKE_MAX_SESSION_DATA_LENGTH     8192
 
 #define NKE_RETRY_FACTOR2_CONNECT       4
 #define NKE_RETRY_FACTOR2_TLS           10
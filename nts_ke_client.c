@@ -505,3 +505,19 @@ NKC_GetRetryFactor(NKC_Instance inst)
 {
   return NKSN_GetRetryFactor(inst->session);
 }
+
+/* ================================================== */
+
+void
+NKC_SetSessionData(NKC_Instance inst, const void *data, int length)
+{
+  NKSN_SetSessionData(inst->session, data, length);
+}
+
+/* ================================================== */
+
+int
+NKC_GetSessionData(NKC_Instance inst, const void **data)
+{
+  return NKSN_GetSessionData(inst->session, data);
+}
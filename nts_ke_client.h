@@ -50,6 +50,13 @@ extern int NKC_GetNtsData(NKC_Instance inst, NKE_Context *context, NKE_Context *
                           NKE_Cookie *cookies, int *num_cookies, int max_cookies,
                           IPSockAddr *ntp_address);
 
+/* Set data of a previous TLS session to be resumed by the next session */
+extern void NKC_SetSessionData(NKC_Instance inst, const void *data, int length);
+
+/* Get data for resumption of the last session.  The function returns the
+   length of the data, or zero if the server did not provide a ticket. */
+extern int NKC_GetSessionData(NKC_Instance inst, const void **data);
+
 /* Get a factor to calculate retry interval (in log2 seconds) */
 extern int NKC_GetRetryFactor(NKC_Instance inst);
 
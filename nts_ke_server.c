@@ -33,11 +33,13 @@
 #include "array.h"
 #include "conf.h"
 #include "clientlog.h"
+#include "hash.h"
 #include "local.h"
 #include "logging.h"
 #include "memory.h"
 #include "ntp_core.h"
 #include "nts_ke_session.h"
+#include "nts_ke_workers.h"
 #include "privops.h"
 #include "siv.h"
 #include "socket.h"
@@ -59,6 +61,8 @@
 
 #define INVALID_SOCK_FD (-7)
 
+#define TICKET_KEY_LABEL "chrony NTS-KE ticket key"
+
 typedef struct {
   uint32_t key_id;
 } ServerCookieHeader;
@@ -84,15 +88,24 @@ typedef struct {
 
 static ServerKey server_keys[MAX_SERVER_KEYS];
 static int current_server_key;
+static uint32_t server_key_generation;
 static double last_server_key_ts;
 static int key_rotation_interval;
 
+/* Lifetime of TLS session tickets and hash function deriving their key
+   from the current server key */
+static int ticket_lifetime;
+static int ticket_hash_id;
+static uint32_t ticket_key_id;
+
 static int server_sock_fd4;
 static int server_sock_fd6;
 
 static int helper_sock_fd;
 static int is_helper;
 
+static int server_threads;
+
 static int initialised = 0;
 
 /* Array of NKSN instances */
@@ -111,6 +124,7 @@ handle_client(int sock_fd, IPSockAddr *addr)
   NKSN_Instance inst, *instp;
   int i;
 
+#ifndef HAVE_EPOLL
   /* Leave at least half of the descriptors which can handled by select()
      to other use */
   if (sock_fd > FD_SETSIZE / 2) {
@@ -118,6 +132,7 @@ handle_client(int sock_fd, IPSockAddr *addr)
               UTI_IPSockAddrToString(addr), "too many descriptors");
     return 0;
   }
+#endif
 
   /* Find an unused server slot or one with an already stopped session */
   for (i = 0, inst = NULL; i < ARR_GetSize(sessions); i++) {
@@ -163,6 +178,31 @@ update_key_siv(ServerKey *key, SIV_Algorithm algorithm)
 
   if (!key->siv || !SIV_SetKey(key->siv, key->key, SIV_GetKeyLength(key->siv_algorithm)))
     LOG_FATAL("Could not set SIV key");
+
+  server_key_generation++;
+}
+
+/* ================================================== */
+
+static void
+update_ticket_key(void)
+{
+  unsigned char hash[MAX_HASH_LENGTH];
+  ServerKey *key;
+
+  if (ticket_lifetime <= 0)
+    return;
+
+  /* Derive the key of TLS session tickets from the current server key to
+     rotate them together and have the same tickets accepted by all helpers,
+     threads, and servers sharing the keys */
+  key = &server_keys[current_server_key];
+  if (HSH_Hash(ticket_hash_id, TICKET_KEY_LABEL, strlen(TICKET_KEY_LABEL),
+               key->key, sizeof (key->key), hash, sizeof (hash)) != NKSN_TICKET_KEY_LENGTH)
+    LOG_FATAL("Could not derive ticket key");
+
+  NKSN_SetServerTickets(hash, ticket_lifetime);
+  ticket_key_id = key->id;
 }
 
 /* ================================================== */
@@ -209,6 +249,8 @@ handle_helper_request(int fd, int event, void *arg)
   client_addr.port = ntohs(req->client_port);
 
   update_key_siv(key, ntohl(req->siv_algorithm));
+  if (key->id != ticket_key_id)
+    update_ticket_key();
 
   if (!handle_client(sock_fd, &client_addr)) {
     SCK_CloseSocket(sock_fd);
@@ -225,7 +267,7 @@ accept_connection(int listening_fd, int event, void *arg)
 {
   SCK_Message message;
   IPSockAddr addr;
-  int log_index, sock_fd;
+  int logged, sock_fd;
   struct timespec now;
 
   sock_fd = SCK_AcceptConnection(listening_fd, &addr);
@@ -241,8 +283,7 @@ accept_connection(int listening_fd, int event, void *arg)
 
   SCH_GetLastEventTime(&now, NULL, NULL);
 
-  log_index = CLG_LogServiceAccess(CLG_NTSKE, &addr.ip_addr, &now);
-  if (log_index >= 0 && CLG_LimitServiceRate(CLG_NTSKE, log_index) != CLG_PASS) {
+  if (CLG_LogAndLimitServiceAccess(CLG_NTSKE, &addr.ip_addr, &now, &logged) != CLG_PASS) {
     DEBUG_LOG("Rejected connection from %s (%s)",
               UTI_IPSockAddrToString(&addr), "rate limit");
     SCK_CloseSocket(sock_fd);
@@ -280,6 +321,11 @@ accept_connection(int listening_fd, int event, void *arg)
     }
 
     SCK_CloseSocket(sock_fd);
+  } else if (server_threads > 0) {
+    if (!NKW_HandleClient(sock_fd, &addr)) {
+      SCK_CloseSocket(sock_fd);
+      return;
+    }
   } else {
     if (!handle_client(sock_fd, &addr)) {
       SCK_CloseSocket(sock_fd);
@@ -314,7 +360,8 @@ open_socket(int family)
 
   /* Set the maximum number of waiting connections on the socket to the maximum
      number of concurrent sessions */
-  backlog = MAX(CNF_GetNtsServerProcesses(), 1) * CNF_GetNtsServerConnections();
+  backlog = MAX(server_threads > 0 ? server_threads : CNF_GetNtsServerProcesses(), 1) *
+            CNF_GetNtsServerConnections();
 
   if (!SCK_ListenOnSocket(sock_fd, backlog)) {
     SCK_CloseSocket(sock_fd);
@@ -341,8 +388,8 @@ prepare_response(NKSN_Instance session, int error, int next_protocol, int aead_a
                  int compliant_128gcm)
 {
   SIV_Algorithm exporter_algorithm;
+  NKE_Cookie cookies[NKE_MAX_COOKIES];
   NKE_Context context;
-  NKE_Cookie cookie;
   char *ntp_server;
   uint16_t datum;
   int i;
@@ -404,10 +451,12 @@ prepare_response(NKSN_Instance session, int error, int next_protocol, int aead_a
                       NKE_NEXT_PROTOCOL_NTPV4, &context.c2s, &context.s2c))
       return 0;
 
+    if (!NKS_GenerateCookies(&context, cookies, NKE_MAX_COOKIES))
+      return 0;
+
     for (i = 0; i < NKE_MAX_COOKIES; i++) {
-      if (!NKS_GenerateCookie(&context, &cookie))
-        return 0;
-      if (!NKSN_AddRecord(session, 0, NKE_RECORD_COOKIE, cookie.cookie, cookie.length))
+      if (!NKSN_AddRecord(session, 0, NKE_RECORD_COOKIE, cookies[i].cookie,
+                          cookies[i].length))
         return 0;
     }
   }
@@ -672,6 +721,7 @@ load_keys(void)
   }
 
   current_server_key = (index + MAX_SERVER_KEYS - FUTURE_KEYS) % MAX_SERVER_KEYS;
+  update_ticket_key();
   last_server_key_ts = SCH_GetLastEventMonoTime() - MAX(key_age, 0.0);
 
   fclose(f);
@@ -691,8 +741,12 @@ error:
 static void
 key_timeout(void *arg)
 {
+  NKW_LockKeys();
   current_server_key = (current_server_key + 1) % MAX_SERVER_KEYS;
   generate_key((current_server_key + FUTURE_KEYS) % MAX_SERVER_KEYS);
+  update_ticket_key();
+  NKW_UnlockKeys();
+
   save_keys();
 
   SCH_AddTimeoutByDelay(key_rotation_interval, key_timeout, NULL);
@@ -767,8 +821,9 @@ NKS_PreInitialise(uid_t uid, gid_t gid, int scfilter_level)
   if (CNF_GetNtsServerCertAndKeyFiles(&certs, &keys) <= 0)
     return;
 
+  /* Threads replace the helper processes */
   processes = CNF_GetNtsServerProcesses();
-  if (processes <= 0)
+  if (processes <= 0 || CNF_GetNtsServerThreads() > 0)
     return;
 
   /* Start helper processes to perform (computationally expensive) NTS-KE
@@ -815,6 +870,7 @@ NKS_Initialise(void)
 
   server_sock_fd4 = INVALID_SOCK_FD;
   server_sock_fd6 = INVALID_SOCK_FD;
+  server_threads = 0;
 
   n_certs_keys = CNF_GetNtsServerCertAndKeyFiles(&certs, &keys);
   if (n_certs_keys <= 0)
@@ -841,7 +897,20 @@ NKS_Initialise(void)
 
   current_server_key = MAX_SERVER_KEYS - 1;
 
+  ticket_lifetime = MAX(CNF_GetNtsTicketLifetime(), 0);
+  ticket_hash_id = HSH_GetHashId(HSH_SHA512);
+  ticket_key_id = 0;
+  if (ticket_lifetime > 0 && ticket_hash_id < 0) {
+    LOG(LOGS_WARN, "Disabled NTS-KE session tickets (no SHA512)");
+    ticket_lifetime = 0;
+  }
+  update_ticket_key();
+
   if (!is_helper) {
+    server_threads = MAX(CNF_GetNtsServerThreads(), 0);
+    NKW_Initialise(server_threads, CNF_GetNtsServerConnections(), SERVER_TIMEOUT,
+                   server_credentials, handle_message);
+
     server_sock_fd4 = open_socket(IPADDR_INET4);
     server_sock_fd6 = open_socket(IPADDR_INET6);
 
@@ -875,6 +944,8 @@ NKS_Finalise(void)
   if (!initialised)
     return;
 
+  NKW_Finalise();
+
   if (helper_sock_fd != INVALID_SOCK_FD) {
     /* Send the helpers a request to exit */
     for (i = 0; i < CNF_GetNtsServerProcesses(); i++) {
@@ -894,6 +965,8 @@ NKS_Finalise(void)
   for (i = 0; i < MAX_SERVER_KEYS; i++)
     SIV_DestroyInstance(server_keys[i].siv);
 
+  NKSN_SetServerTickets(NULL, 0);
+
   for (i = 0; i < ARR_GetSize(sessions); i++) {
     NKSN_Instance session = *(NKSN_Instance *)ARR_GetElement(sessions, i);
     if (session)
@@ -923,18 +996,30 @@ NKS_ReloadKeys(void)
   if (key_rotation_interval > 0)
     return;
 
+  NKW_LockKeys();
   load_keys();
+  NKW_UnlockKeys();
+}
+
+/* ================================================== */
+
+uint32_t
+NKS_GetKeyGeneration(void)
+{
+  return server_key_generation;
 }
 
 /* ================================================== */
 
 /* A server cookie consists of key ID, nonce, and encrypted C2S+S2C keys */
 
-int
-NKS_GenerateCookie(NKE_Context *context, NKE_Cookie *cookie)
+static int
+generate_cookies(NKE_Context *context, NKE_Cookie *cookies, int n)
 {
-  unsigned char *nonce, plaintext[2 * NKE_MAX_KEY_LENGTH], *ciphertext;
-  int plaintext_length, tag_length;
+  unsigned char nonces[NKE_MAX_COOKIES * MAX_COOKIE_NONCE_LENGTH];
+  unsigned char *ciphertexts[NKE_MAX_COOKIES], plaintext[2 * NKE_MAX_KEY_LENGTH];
+  const unsigned char *cookie_nonces[NKE_MAX_COOKIES];
+  int i, plaintext_length, tag_length, length;
   ServerCookieHeader *header;
   ServerKey *key;
 
@@ -953,15 +1038,22 @@ NKS_GenerateCookie(NKE_Context *context, NKE_Cookie *cookie)
     return 0;
   }
 
-  key = &server_keys[current_server_key];
+  if (n < 0 || n > NKE_MAX_COOKIES) {
+    DEBUG_LOG("Invalid number of cookies");
+    return 0;
+  }
 
-  header = (ServerCookieHeader *)cookie->cookie;
+  key = &server_keys[current_server_key];
 
-  header->key_id = htonl(key->id);
+  BRIEF_ASSERT(key->nonce_length <= MAX_COOKIE_NONCE_LENGTH);
+  BRIEF_ASSERT(key->nonce_length <= sizeof (cookies->cookie) - sizeof (*header));
 
-  nonce = cookie->cookie + sizeof (*header);
-  BRIEF_ASSERT(key->nonce_length <= sizeof (cookie->cookie) - sizeof (*header));
-  UTI_GetRandomBytes(nonce, key->nonce_length);
+  /* Get random nonces for all cookies at once.  The buffered random
+     generator can be used only in the main thread. */
+  if (NKW_IsWorkerThread())
+    UTI_GetRandomBytesUnbuffered(nonces, n * key->nonce_length);
+  else
+    UTI_GetRandomBytes(nonces, n * key->nonce_length);
 
   plaintext_length = context->c2s.length + context->s2c.length;
   assert(plaintext_length <= sizeof (plaintext));
@@ -969,14 +1061,26 @@ NKS_GenerateCookie(NKE_Context *context, NKE_Cookie *cookie)
   memcpy(plaintext + context->c2s.length, context->s2c.key, context->s2c.length);
 
   tag_length = SIV_GetTagLength(key->siv);
-  cookie->length = sizeof (*header) + key->nonce_length + plaintext_length + tag_length;
-  assert(cookie->length <= sizeof (cookie->cookie));
-  ciphertext = cookie->cookie + sizeof (*header) + key->nonce_length;
+  length = sizeof (*header) + key->nonce_length + plaintext_length + tag_length;
+  assert(length <= sizeof (cookies->cookie));
+
+  /* The cookies differ only in the nonce, which allows the SIV
+     implementation to encrypt them in parallel */
+  for (i = 0; i < n; i++) {
+    header = (ServerCookieHeader *)cookies[i].cookie;
+    header->key_id = htonl(key->id);
+
+    memcpy(cookies[i].cookie + sizeof (*header), nonces + i * key->nonce_length,
+           key->nonce_length);
+    cookie_nonces[i] = cookies[i].cookie + sizeof (*header);
+    ciphertexts[i] = cookies[i].cookie + sizeof (*header) + key->nonce_length;
+    cookies[i].length = length;
+  }
 
-  if (!SIV_Encrypt(key->siv, nonce, key->nonce_length,
-                   "", 0,
-                   plaintext, plaintext_length,
-                   ciphertext, plaintext_length + tag_length)) {
+  if (!SIV_EncryptMultiple(key->siv, n, cookie_nonces, key->nonce_length,
+                           "", 0,
+                           plaintext, plaintext_length,
+                           ciphertexts, plaintext_length + tag_length)) {
     DEBUG_LOG("Could not encrypt cookie");
     return 0;
   }
@@ -987,7 +1091,21 @@ NKS_GenerateCookie(NKE_Context *context, NKE_Cookie *cookie)
 /* ================================================== */
 
 int
-NKS_DecodeCookie(NKE_Cookie *cookie, NKE_Context *context)
+NKS_GenerateCookies(NKE_Context *context, NKE_Cookie *cookies, int n)
+{
+  int r;
+
+  NKW_LockKeys();
+  r = generate_cookies(context, cookies, n);
+  NKW_UnlockKeys();
+
+  return r;
+}
+
+/* ================================================== */
+
+static int
+decode_cookie(NKE_Cookie *cookie, NKE_Context *context)
 {
   unsigned char *nonce, plaintext[2 * NKE_MAX_KEY_LENGTH], *ciphertext;
   int ciphertext_length, plaintext_length, tag_length;
@@ -1062,3 +1180,17 @@ NKS_DecodeCookie(NKE_Cookie *cookie, NKE_Context *context)
 
   return 1;
 }
+
+/* ================================================== */
+
+int
+NKS_DecodeCookie(NKE_Cookie *cookie, NKE_Context *context)
+{
+  int r;
+
+  NKW_LockKeys();
+  r = decode_cookie(cookie, context);
+  NKW_UnlockKeys();
+
+  return r;
+}
@@ -40,8 +40,12 @@ extern void NKS_DumpKeys(void);
 /* Reload the keys */
 extern void NKS_ReloadKeys(void);
 
-/* Generate an NTS cookie with a given context */
-extern int NKS_GenerateCookie(NKE_Context *context, NKE_Cookie *cookie);
+/* Get a number which changes when a server key is replaced, i.e. when
+   cookies encrypted with the previous key may no longer be valid */
+extern uint32_t NKS_GetKeyGeneration(void);
+
+/* Generate a number of NTS cookies with a given context */
+extern int NKS_GenerateCookies(NKE_Context *context, NKE_Cookie *cookies, int n);
 
 /* Validate a cookie and decode the context */
 extern int NKS_DecodeCookie(NKE_Cookie *cookie, NKE_Context *context);
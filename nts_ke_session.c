@@ -73,6 +73,8 @@ struct NKSN_Instance_Record {
 
   KeState state;
   int sock_fd;
+  int scheduled;
+  int event;
   char *label;
   TLS_Instance tls_session;
   SCH_TimeoutID timeout_id;
@@ -80,6 +82,10 @@ struct NKSN_Instance_Record {
 
   struct Message message;
   int new_message;
+
+  unsigned char *session_data;
+  int session_data_length;
+  int resumed;
 };
 
 /* ================================================== */
@@ -88,6 +94,10 @@ static int credentials_counter = 0;
 
 static int clock_updates = 0;
 
+/* Key and lifetime of TLS session tickets issued by servers */
+static unsigned char server_ticket_key[NKSN_TICKET_KEY_LENGTH];
+static int server_ticket_lifetime = 0;
+
 /* ================================================== */
 
 static void
@@ -203,6 +213,21 @@ check_message_format(struct Message *message, int eof)
 
 /* ================================================== */
 
+static void
+save_session_data(NKSN_Instance inst)
+{
+  unsigned char data[NKE_MAX_SESSION_DATA_LENGTH];
+  int length;
+
+  /* Don't use a ticket more than once */
+  length = TLS_GetSessionData(inst->tls_session, data, sizeof (data));
+  NKSN_SetSessionData(inst, data, length);
+
+  DEBUG_LOG("Saved session data length=%d", length);
+}
+
+/* ================================================== */
+
 static void
 stop_session(NKSN_Instance inst)
 {
@@ -211,7 +236,8 @@ stop_session(NKSN_Instance inst)
 
   inst->state = KE_STOPPED;
 
-  SCH_RemoveFileHandler(inst->sock_fd);
+  if (inst->scheduled)
+    SCH_RemoveFileHandler(inst->sock_fd);
   SCK_CloseSocket(inst->sock_fd);
   inst->sock_fd = INVALID_SOCK_FD;
 
@@ -221,7 +247,8 @@ stop_session(NKSN_Instance inst)
   TLS_DestroyInstance(inst->tls_session);
   inst->tls_session = NULL;
 
-  SCH_RemoveTimeout(inst->timeout_id);
+  if (inst->scheduled)
+    SCH_RemoveTimeout(inst->timeout_id);
   inst->timeout_id = 0;
 }
 
@@ -243,6 +270,11 @@ session_timeout(void *arg)
 static void
 set_input_output(NKSN_Instance inst, int output)
 {
+  inst->event = output ? SCH_FILE_OUTPUT : SCH_FILE_INPUT;
+
+  if (!inst->scheduled)
+    return;
+
   SCH_SetFileHandlerEvent(inst->sock_fd, SCH_FILE_INPUT, !output);
   SCH_SetFileHandlerEvent(inst->sock_fd, SCH_FILE_OUTPUT, output);
 }
@@ -329,6 +361,9 @@ handle_event(NKSN_Instance inst, int event)
       }
 
       inst->retry_factor = NKE_RETRY_FACTOR2_TLS;
+      inst->resumed = TLS_IsResumed(inst->tls_session);
+      if (inst->resumed)
+        DEBUG_LOG("Resumed TLS session");
 
       /* Client will send a request to the server */
       change_state(inst, inst->server ? KE_RECEIVE : KE_SEND);
@@ -401,6 +436,11 @@ handle_event(NKSN_Instance inst, int event)
       if (!message->complete)
         return 0;
 
+      /* Save a session ticket received by the client (in TLS1.3 it is
+         sent after the handshake) */
+      if (!inst->server)
+        save_session_data(inst);
+
       /* Server will send a response to the client */
       change_state(inst, inst->server ? KE_SEND : KE_SHUTDOWN);
 
@@ -568,6 +608,20 @@ NKSN_DestroyCertCredentials(NKSN_Credentials credentials)
 
 /* ================================================== */
 
+void
+NKSN_SetServerTickets(const unsigned char *key, int lifetime)
+{
+  assert(NKSN_TICKET_KEY_LENGTH == TLS_TICKET_KEY_LENGTH);
+
+  if (lifetime > 0)
+    memcpy(server_ticket_key, key, sizeof (server_ticket_key));
+  else
+    memset(server_ticket_key, 0, sizeof (server_ticket_key));
+  server_ticket_lifetime = MAX(lifetime, 0);
+}
+
+/* ================================================== */
+
 NKSN_Instance
 NKSN_CreateInstance(int server_mode, const char *server_name,
                     NKSN_MessageHandler handler, void *handler_arg)
@@ -586,10 +640,15 @@ NKSN_CreateInstance(int server_mode, const char *server_name,
 
   inst->state = KE_STOPPED;
   inst->sock_fd = INVALID_SOCK_FD;
+  inst->scheduled = 1;
+  inst->event = 0;
   inst->label = NULL;
   inst->tls_session = NULL;
   inst->timeout_id = 0;
   inst->retry_factor = NKE_RETRY_FACTOR2_CONNECT;
+  inst->session_data = NULL;
+  inst->session_data_length = 0;
+  inst->resumed = 0;
 
   return inst;
 }
@@ -601,6 +660,7 @@ NKSN_DestroyInstance(NKSN_Instance inst)
 {
   stop_session(inst);
 
+  Free(inst->session_data);
   Free(inst->server_name);
   Free(inst);
 }
@@ -619,12 +679,22 @@ NKSN_StartSession(NKSN_Instance inst, int sock_fd, const char *label,
   if (!inst->tls_session)
     return 0;
 
+  /* Failures to enable tickets or resume the previous session are not fatal,
+     the session will just need a full handshake */
+  if (inst->server && server_ticket_lifetime > 0)
+    TLS_EnableServerTickets(inst->tls_session, server_ticket_key, server_ticket_lifetime);
+  else if (!inst->server && inst->session_data_length > 0)
+    TLS_SetSessionData(inst->tls_session, inst->session_data, inst->session_data_length);
+
   inst->sock_fd = sock_fd;
-  SCH_AddFileHandler(sock_fd, SCH_FILE_INPUT, read_write_socket, inst);
+  if (inst->scheduled)
+    SCH_AddFileHandler(sock_fd, SCH_FILE_INPUT, read_write_socket, inst);
 
   inst->label = Strdup(label);
-  inst->timeout_id = SCH_AddTimeoutByDelay(timeout, session_timeout, inst);
+  if (inst->scheduled)
+    inst->timeout_id = SCH_AddTimeoutByDelay(timeout, session_timeout, inst);
   inst->retry_factor = NKE_RETRY_FACTOR2_CONNECT;
+  inst->resumed = 0;
 
   reset_message(&inst->message);
   inst->new_message = 0;
@@ -744,6 +814,40 @@ NKSN_GetKeys(NKSN_Instance inst, SIV_Algorithm algorithm, SIV_Algorithm exporter
 
 /* ================================================== */
 
+void
+NKSN_SetSessionData(NKSN_Instance inst, const void *data, int length)
+{
+  Free(inst->session_data);
+  inst->session_data = NULL;
+  inst->session_data_length = 0;
+
+  if (length <= 0 || length > NKE_MAX_SESSION_DATA_LENGTH)
+    return;
+
+  inst->session_data = Malloc(length);
+  memcpy(inst->session_data, data, length);
+  inst->session_data_length = length;
+}
+
+/* ================================================== */
+
+int
+NKSN_GetSessionData(NKSN_Instance inst, const void **data)
+{
+  *data = inst->session_data;
+  return inst->session_data_length;
+}
+
+/* ================================================== */
+
+int
+NKSN_IsResumed(NKSN_Instance inst)
+{
+  return inst->resumed;
+}
+
+/* ================================================== */
+
 int
 NKSN_IsStopped(NKSN_Instance inst)
 {
@@ -760,6 +864,37 @@ NKSN_StopSession(NKSN_Instance inst)
 
 /* ================================================== */
 
+void
+NKSN_DisableScheduling(NKSN_Instance inst)
+{
+  assert(inst->state == KE_STOPPED);
+
+  inst->scheduled = 0;
+}
+
+/* ================================================== */
+
+int
+NKSN_GetEvent(NKSN_Instance inst)
+{
+  return inst->state != KE_STOPPED ? inst->event : 0;
+}
+
+/* ================================================== */
+
+void
+NKSN_HandleEvent(NKSN_Instance inst, int event)
+{
+  assert(!inst->scheduled);
+
+  if (inst->state == KE_STOPPED)
+    return;
+
+  read_write_socket(inst->sock_fd, event, inst);
+}
+
+/* ================================================== */
+
 int
 NKSN_GetRetryFactor(NKSN_Instance inst)
 {
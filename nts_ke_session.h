@@ -30,6 +30,9 @@
 #include "nts_ke.h"
 #include "siv.h"
 
+/* Length of the key encrypting TLS session tickets */
+#define NKSN_TICKET_KEY_LENGTH 64
+
 typedef struct NKSN_Credentials_Record *NKSN_Credentials;
 
 typedef struct NKSN_Instance_Record *NKSN_Instance;
@@ -50,6 +53,11 @@ extern NKSN_Credentials NKSN_CreateClientCertCredentials(const char **certs, uin
 /* Destroy the credentials */
 extern void NKSN_DestroyCertCredentials(NKSN_Credentials credentials);
 
+/* Set the key and lifetime (in seconds) of TLS session tickets issued by
+   server sessions started after the call.  Zero lifetime disables the
+   tickets. */
+extern void NKSN_SetServerTickets(const unsigned char *key, int lifetime);
+
 /* Create an instance */
 extern NKSN_Instance NKSN_CreateInstance(int server_mode, const char *server_name,
                                          NKSN_MessageHandler handler, void *handler_arg);
@@ -83,12 +91,37 @@ extern int NKSN_GetKeys(NKSN_Instance inst, SIV_Algorithm algorithm,
                         SIV_Algorithm exporter_algorithm,
                         int next_protocol, NKE_Key *c2s, NKE_Key *s2c);
 
+/* Set data of a previous TLS session which should be resumed by a client
+   in the next session */
+extern void NKSN_SetSessionData(NKSN_Instance inst, const void *data, int length);
+
+/* Get data for resumption of the last session of a client, which are
+   available if the server provided a session ticket.  The function returns
+   the length of the data, or zero if not available. */
+extern int NKSN_GetSessionData(NKSN_Instance inst, const void **data);
+
+/* Check if the TLS session was resumed */
+extern int NKSN_IsResumed(NKSN_Instance inst);
+
 /* Check if the session has stopped */
 extern int NKSN_IsStopped(NKSN_Instance inst);
 
 /* Stop the session */
 extern void NKSN_StopSession(NKSN_Instance inst);
 
+/* Disable adding the socket and timeout of the session to the scheduler,
+   e.g. to handle the session in a different thread.  The caller needs to
+   wait for the event returned by NKSN_GetEvent(), pass it to
+   NKSN_HandleEvent(), and stop the session on timeout. */
+extern void NKSN_DisableScheduling(NKSN_Instance inst);
+
+/* Get the socket event (SCH_FILE_INPUT or SCH_FILE_OUTPUT) the session is
+   waiting for, or zero if it is stopped */
+extern int NKSN_GetEvent(NKSN_Instance inst);
+
+/* Handle an event on the socket of a session with disabled scheduling */
+extern void NKSN_HandleEvent(NKSN_Instance inst, int event);
+
 /* Get a factor to calculate retry interval (in log2 seconds)
    based on the session state or how it was terminated */
 extern int NKSN_GetRetryFactor(NKSN_Instance inst);
@@ -0,0 +1,398 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+
+  =======================================================================
+
+  Threads handling NTS-KE sessions.  Connections accepted by the NTS-KE
+  server in the main thread are passed to the threads over socket pairs.
+  Each thread runs its own poll() loop with TLS sessions which are not
+  registered in the scheduler.  The server keys stay in the main thread
+  and are shared with the threads under a lock.
+
+  The threads must not call functions which are not thread-safe (e.g.
+  scheduling, or the utility functions using static buffers).  Debug
+  logging is allowed.
+  */
+
+#include "config.h"
+
+#include "sysincl.h"
+
+#include <poll.h>
+#include <pthread.h>
+
+#include "nts_ke_workers.h"
+
+#include "logging.h"
+#include "memory.h"
+#include "sched.h"
+#include "socket.h"
+#include "util.h"
+
+#define INVALID_SOCK_FD -1
+
+#define MAX_LABEL_LENGTH 64
+
+/* Connection passed from the main thread to a thread */
+typedef struct {
+  int sock_fd;
+  char label[MAX_LABEL_LENGTH];
+} Request;
+
+typedef struct {
+  NKSN_Instance session;
+  int sock_fd;
+  double deadline;
+  int poll_index;
+} Session;
+
+typedef struct {
+  pthread_t thread;
+  /* Main thread's and thread's end of the socket pair */
+  int main_fd;
+  int thread_fd;
+} Worker;
+
+/* ================================================== */
+
+static Worker *workers;
+static int n_workers;
+static int next_worker;
+static int started;
+
+static SCH_TimeoutID start_timeout_id;
+
+/* Pipe used to request the threads to stop */
+static int quit_fds[2];
+
+static pthread_t main_thread;
+
+/* Parameters of the sessions */
+static NKSN_Credentials credentials;
+static NKSN_MessageHandler message_handler;
+static int max_sessions;
+static double session_timeout;
+
+/* Lock protecting the server keys */
+static pthread_mutex_t keys_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ================================================== */
+
+static double
+get_monotonic_time(void)
+{
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    return 0.0;
+
+  return UTI_TimespecToDouble(&ts);
+}
+
+/* ================================================== */
+
+static void
+receive_requests(Worker *worker, Session *sessions, double now)
+{
+  Session *s;
+  Request req;
+  int i, r;
+
+  while (SCK_Receive(worker->thread_fd, &req, sizeof (req), 0) == sizeof (req)) {
+    req.label[sizeof (req.label) - 1] = '\0';
+
+    /* Find an unused slot or one with an already stopped session */
+    for (i = 0, s = NULL; i < max_sessions; i++) {
+      if (!sessions[i].session) {
+        s = &sessions[i];
+        s->session = NKSN_CreateInstance(1, NULL, message_handler, NULL);
+        NKSN_DisableScheduling(s->session);
+        break;
+      } else if (NKSN_IsStopped(sessions[i].session)) {
+        s = &sessions[i];
+        break;
+      }
+    }
+
+    if (!s) {
+      DEBUG_LOG("Rejected connection from %s (%s)", req.label, "too many connections");
+      SCK_CloseSocket(req.sock_fd);
+      continue;
+    }
+
+    /* The ticket key is updated with the server keys */
+    NKW_LockKeys();
+    r = NKSN_StartSession(s->session, req.sock_fd, req.label, credentials,
+                          session_timeout);
+    NKW_UnlockKeys();
+
+    if (!r) {
+      SCK_CloseSocket(req.sock_fd);
+      continue;
+    }
+
+    s->sock_fd = req.sock_fd;
+    s->deadline = now + session_timeout;
+    s->poll_index = -1;
+  }
+}
+
+/* ================================================== */
+
+static void *
+run_worker(void *arg)
+{
+  int i, n_fds, event, timeout;
+  struct pollfd *fds;
+  Worker *worker = arg;
+  Session *sessions;
+  double now, wait;
+
+  sessions = MallocArray(Session, max_sessions);
+  memset(sessions, 0, sizeof (Session) * max_sessions);
+  fds = MallocArray(struct pollfd, max_sessions + 2);
+
+  fds[0].fd = quit_fds[0];
+  fds[0].events = POLLIN;
+  fds[1].fd = worker->thread_fd;
+  fds[1].events = POLLIN;
+
+  while (1) {
+    now = get_monotonic_time();
+    timeout = -1;
+
+    for (i = 0, n_fds = 2; i < max_sessions; i++) {
+      sessions[i].poll_index = -1;
+
+      if (!sessions[i].session)
+        continue;
+
+      event = NKSN_GetEvent(sessions[i].session);
+      if (!event)
+        continue;
+
+      wait = sessions[i].deadline - now;
+      if (wait <= 0.0) {
+        DEBUG_LOG("NTS-KE session fd=%d timed out", sessions[i].sock_fd);
+        NKSN_StopSession(sessions[i].session);
+        continue;
+      }
+
+      if (timeout < 0 || wait * 1000.0 < timeout)
+        timeout = wait * 1000.0 + 1.0;
+
+      fds[n_fds].fd = sessions[i].sock_fd;
+      fds[n_fds].events = event == SCH_FILE_OUTPUT ? POLLOUT : POLLIN;
+      fds[n_fds].revents = 0;
+      sessions[i].poll_index = n_fds++;
+    }
+
+    if (poll(fds, n_fds, timeout) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (fds[0].revents)
+      break;
+
+    /* Handle the active sessions before starting new sessions in the slots
+       of stopped sessions */
+    for (i = 0; i < max_sessions; i++) {
+      if (sessions[i].poll_index < 0 || !fds[sessions[i].poll_index].revents)
+        continue;
+      NKSN_HandleEvent(sessions[i].session, NKSN_GetEvent(sessions[i].session));
+    }
+
+    if (fds[1].revents)
+      receive_requests(worker, sessions, get_monotonic_time());
+  }
+
+  for (i = 0; i < max_sessions; i++) {
+    if (sessions[i].session)
+      NKSN_DestroyInstance(sessions[i].session);
+  }
+
+  Free(sessions);
+  Free(fds);
+
+  return NULL;
+}
+
+/* ================================================== */
+
+static void
+start_workers(void *arg)
+{
+  sigset_t signals, old_signals;
+  int i;
+
+  start_timeout_id = 0;
+
+  /* Make sure signals are handled only in the main thread */
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, &old_signals);
+
+  for (i = 0; i < n_workers; i++) {
+    if (pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]))
+      LOG_FATAL("pthread_create() failed");
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+
+  started = 1;
+
+  LOG(LOGS_INFO, "Started %d NTS-KE threads", n_workers);
+}
+
+/* ================================================== */
+
+void
+NKW_Initialise(int threads, int connections, double timeout,
+               NKSN_Credentials server_credentials, NKSN_MessageHandler handler)
+{
+  int i;
+
+  n_workers = threads;
+  next_worker = 0;
+  started = 0;
+  start_timeout_id = 0;
+
+  if (n_workers <= 0) {
+    n_workers = 0;
+    return;
+  }
+
+  main_thread = pthread_self();
+  credentials = server_credentials;
+  message_handler = handler;
+  max_sessions = MAX(connections, 1);
+  session_timeout = timeout;
+
+  workers = MallocArray(Worker, n_workers);
+  memset(workers, 0, sizeof (Worker) * n_workers);
+
+  for (i = 0; i < n_workers; i++) {
+    workers[i].main_fd = SCK_OpenUnixSocketPair(0, &workers[i].thread_fd);
+    if (workers[i].main_fd < 0)
+      LOG_FATAL("Could not open socket pair");
+  }
+
+  if (pipe(quit_fds) < 0)
+    LOG_FATAL("pipe() failed : %s", strerror(errno));
+
+  UTI_FdSetCloexec(quit_fds[0]);
+  UTI_FdSetCloexec(quit_fds[1]);
+
+  /* The threads get random bytes from getrandom(), but /dev/urandom is
+     a fallback.  Open it here to not race on its lazy opening. */
+  UTI_GetRandomBytesUrandom(&i, sizeof (i));
+
+  /* Start the threads from the main loop to have them running with
+     the same system call filter */
+  start_timeout_id = SCH_AddTimeoutByDelay(0.0, start_workers, NULL);
+}
+
+/* ================================================== */
+
+void
+NKW_Finalise(void)
+{
+  Request req;
+  int i;
+
+  if (n_workers <= 0)
+    return;
+
+  if (started) {
+    if (write(quit_fds[1], "", 1) != 1)
+      LOG_FATAL("write() failed");
+
+    for (i = 0; i < n_workers; i++) {
+      if (pthread_join(workers[i].thread, NULL))
+        LOG_FATAL("pthread_join() failed");
+    }
+  }
+
+  SCH_RemoveTimeout(start_timeout_id);
+
+  for (i = 0; i < n_workers; i++) {
+    /* Close connections which were not picked up by the thread */
+    while (SCK_Receive(workers[i].thread_fd, &req, sizeof (req), 0) == sizeof (req))
+      SCK_CloseSocket(req.sock_fd);
+
+    SCK_CloseSocket(workers[i].main_fd);
+    SCK_CloseSocket(workers[i].thread_fd);
+  }
+
+  close(quit_fds[0]);
+  close(quit_fds[1]);
+
+  Free(workers);
+  n_workers = 0;
+}
+
+/* ================================================== */
+
+int
+NKW_HandleClient(int sock_fd, IPSockAddr *addr)
+{
+  Worker *worker;
+  Request req;
+
+  if (n_workers <= 0)
+    return 0;
+
+  memset(&req, 0, sizeof (req));
+  req.sock_fd = sock_fd;
+  snprintf(req.label, sizeof (req.label), "%s", UTI_IPSockAddrToString(addr));
+
+  worker = &workers[next_worker];
+  next_worker = (next_worker + 1) % n_workers;
+
+  if (SCK_Send(worker->main_fd, &req, sizeof (req), 0) != sizeof (req))
+    return 0;
+
+  return 1;
+}
+
+/* ================================================== */
+
+int
+NKW_IsWorkerThread(void)
+{
+  return n_workers > 0 && !pthread_equal(pthread_self(), main_thread);
+}
+
+/* ================================================== */
+
+void
+NKW_LockKeys(void)
+{
+  pthread_mutex_lock(&keys_lock);
+}
+
+/* ================================================== */
+
+void
+NKW_UnlockKeys(void)
+{
+  pthread_mutex_unlock(&keys_lock);
+}
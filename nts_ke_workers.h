@@ -0,0 +1,54 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+
+  =======================================================================
+
+  Header file for the threads handling NTS-KE sessions.
+  */
+
+#ifndef GOT_NTS_KE_WORKERS_H
+#define GOT_NTS_KE_WORKERS_H
+
+#include "addressing.h"
+#include "nts_ke_session.h"
+
+/* Schedule the start of threads handling up to the specified number of
+   concurrent server sessions (per thread) with the specified timeout.
+   Received messages are passed to the handler in the threads. */
+extern void NKW_Initialise(int threads, int connections, double timeout,
+                           NKSN_Credentials server_credentials,
+                           NKSN_MessageHandler handler);
+
+/* Stop the threads and their sessions */
+extern void NKW_Finalise(void);
+
+/* Pass an accepted connection to one of the threads.  The socket is closed
+   by the thread if the function succeeds. */
+extern int NKW_HandleClient(int sock_fd, IPSockAddr *addr);
+
+/* Check if the function is called from one of the threads */
+extern int NKW_IsWorkerThread(void);
+
+/* Serialise access to the server keys between the main thread and
+   the threads */
+extern void NKW_LockKeys(void);
+extern void NKW_UnlockKeys(void);
+
+#endif
@@ -60,13 +60,13 @@ get_padded_length(int length)
 /* ================================================== */
 
 int
-NNA_GenerateAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
-                   const unsigned char *nonce, int max_nonce_length,
-                   const unsigned char *plaintext, int plaintext_length,
-                   int min_ef_length)
+NNA_AddAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
+              const unsigned char *nonce, int max_nonce_length,
+              int plaintext_length, int min_ef_length,
+              int *ef_start, unsigned char **plaintext)
 {
-  int auth_length, ciphertext_length, assoc_length, nonce_length, max_siv_nonce_length;
-  int nonce_padding, ciphertext_padding, additional_padding;
+  int auth_length, ciphertext_length, nonce_length, max_siv_nonce_length;
+  int nonce_padding, ciphertext_padding, additional_padding, offset;
   unsigned char *ciphertext, *body;
   struct AuthHeader *header;
 
@@ -77,7 +77,7 @@ NNA_GenerateAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
     return 0;
   }
 
-  assoc_length = info->length;
+  *ef_start = info->length;
   max_siv_nonce_length = SIV_GetMaxNonceLength(siv);
   nonce_length = MIN(max_nonce_length, max_siv_nonce_length);
   ciphertext_length = SIV_GetTagLength(siv) + plaintext_length;
@@ -109,22 +109,80 @@ NNA_GenerateAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
 
   memcpy(body, nonce, nonce_length);
   memset(body + nonce_length, 0, nonce_padding);
+  memset(ciphertext + ciphertext_length, 0, ciphertext_padding + additional_padding);
+
+  /* Let the caller write the plaintext where it can be encrypted in place,
+     or to the beginning of the ciphertext if that is not supported */
+  offset = SIV_GetInPlaceOffset(siv);
+  *plaintext = ciphertext + MAX(offset, 0);
+
+  return 1;
+}
+
+/* ================================================== */
 
-  if (!SIV_Encrypt(siv, nonce, nonce_length, packet, assoc_length,
+int
+NNA_EncryptAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv, int ef_start)
+{
+  unsigned char buffer[NTP_MAX_EXTENSIONS_LENGTH], *nonce, *ciphertext, *plaintext;
+  int nonce_length, ciphertext_length, plaintext_length, offset;
+  struct AuthHeader *header;
+
+  BRIEF_ASSERT(ef_start >= NTP_HEADER_LENGTH && ef_start + 4 + sizeof (*header) <= info->length);
+
+  header = (struct AuthHeader *)((unsigned char *)packet + ef_start + 4);
+  nonce_length = ntohs(header->nonce_length);
+  ciphertext_length = ntohs(header->ciphertext_length);
+  plaintext_length = ciphertext_length - SIV_GetTagLength(siv);
+
+  nonce = (unsigned char *)(header + 1);
+  ciphertext = nonce + get_padded_length(nonce_length);
+
+  BRIEF_ASSERT(plaintext_length >= 0 &&
+               ciphertext + ciphertext_length <= (unsigned char *)packet + info->length);
+
+  offset = SIV_GetInPlaceOffset(siv);
+  if (offset >= 0) {
+    plaintext = ciphertext + offset;
+  } else {
+    BRIEF_ASSERT(plaintext_length <= sizeof (buffer));
+    memcpy(buffer, ciphertext, plaintext_length);
+    plaintext = buffer;
+  }
+
+  if (!SIV_Encrypt(siv, nonce, nonce_length, packet, ef_start,
                    plaintext, plaintext_length, ciphertext, ciphertext_length)) {
     DEBUG_LOG("SIV encrypt failed");
-    info->length = assoc_length;
+    info->length = ef_start;
     info->ext_fields--;
     return 0;
   }
 
-  memset(ciphertext + ciphertext_length, 0, ciphertext_padding + additional_padding);
-
   return 1;
 }
 
 /* ================================================== */
 
+int
+NNA_GenerateAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
+                   const unsigned char *nonce, int max_nonce_length,
+                   const unsigned char *plaintext, int plaintext_length,
+                   int min_ef_length)
+{
+  unsigned char *buffer;
+  int ef_start;
+
+  if (!NNA_AddAuthEF(packet, info, siv, nonce, max_nonce_length, plaintext_length,
+                     min_ef_length, &ef_start, &buffer))
+    return 0;
+
+  memcpy(buffer, plaintext, plaintext_length);
+
+  return NNA_EncryptAuthEF(packet, info, siv, ef_start);
+}
+
+/* ================================================== */
+
 int
 NNA_DecryptAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv, int ef_start,
                   unsigned char *plaintext, int buffer_length, int *plaintext_length)
@@ -31,6 +31,20 @@
 #include "ntp.h"
 #include "siv.h"
 
+/* Add an authenticator EF for plaintext of the specified length.  The
+   plaintext needs to be written to the returned buffer in the packet and
+   encrypted by NNA_EncryptAuthEF() before any other changes are made to the
+   packet. */
+extern int NNA_AddAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
+                         const unsigned char *nonce, int max_nonce_length,
+                         int plaintext_length, int min_ef_length,
+                         int *ef_start, unsigned char **plaintext);
+
+/* Encrypt the plaintext of an authenticator EF added by NNA_AddAuthEF() */
+extern int NNA_EncryptAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
+                             int ef_start);
+
+/* Add an authenticator EF with encrypted plaintext */
 extern int NNA_GenerateAuthEF(NTP_Packet *packet, NTP_PacketInfo *info, SIV_Instance siv,
                               const unsigned char *nonce, int max_nonce_length,
                               const unsigned char *plaintext, int plaintext_length,
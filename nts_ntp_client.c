@@ -50,7 +50,8 @@
 #define RETRY_INTERVAL_KE_START 2.0
 
 /* Magic string of files containing keys and cookies */
-#define DUMP_IDENTIFIER "NNC0\n"
+#define DUMP_IDENTIFIER "NNC1\n"
+#define OLD_DUMP_IDENTIFIER "NNC0\n"
 
 struct NNC_Instance_Record {
   /* Address of NTS-KE server */
@@ -77,6 +78,9 @@ struct NNC_Instance_Record {
   NKE_Cookie cookies[NTS_MAX_COOKIES];
   int num_cookies;
   int cookie_index;
+  /* Data for resumption of the last TLS session */
+  unsigned char *session_data;
+  int session_data_length;
   int auth_ready;
   int nak_response;
   int ok_response;
@@ -91,6 +95,23 @@ static void load_cookies(NNC_Instance inst);
 
 /* ================================================== */
 
+static void
+set_session_data(NNC_Instance inst, const void *data, int length)
+{
+  Free(inst->session_data);
+  inst->session_data = NULL;
+  inst->session_data_length = 0;
+
+  if (length <= 0)
+    return;
+
+  inst->session_data = Malloc(length);
+  memcpy(inst->session_data, data, length);
+  inst->session_data_length = length;
+}
+
+/* ================================================== */
+
 static void
 reset_instance(NNC_Instance inst)
 {
@@ -111,6 +132,7 @@ reset_instance(NNC_Instance inst)
   memset(inst->cookies, 0, sizeof (inst->cookies));
   inst->num_cookies = 0;
   inst->cookie_index = 0;
+  set_session_data(inst, NULL, 0);
   inst->auth_ready = 0;
   inst->nak_response = 0;
   inst->ok_response = 1;
@@ -135,6 +157,7 @@ NNC_CreateInstance(IPSockAddr *nts_address, const char *name, uint32_t cert_set,
   inst->ntp_address.port = ntp_port;
   inst->siv = NULL;
   inst->nke = NULL;
+  inst->session_data = NULL;
 
   reset_instance(inst);
 
@@ -159,6 +182,21 @@ NNC_DestroyInstance(NNC_Instance inst)
 
 /* ================================================== */
 
+static int
+can_switch_keys(NNC_Instance inst)
+{
+  /* Check whether there is an alternate set of keys available (exported with
+     the compliant context for AES-128-GCM-SIV) and the NAK was the only valid
+     response after the last NTS-KE session, indicating we use incorrect keys
+     and switching to the other set of keys for the following NTP requests
+     might work */
+  return inst->alt_context.algorithm != AEAD_SIV_INVALID &&
+         inst->alt_context.algorithm == inst->context.algorithm &&
+         inst->nke_attempts > 0 && inst->nak_response && !inst->ok_response;
+}
+
+/* ================================================== */
+
 static int
 check_cookies(NNC_Instance inst)
 {
@@ -168,14 +206,8 @@ check_cookies(NNC_Instance inst)
       ((inst->nak_response && !inst->ok_response) ||
        SCH_GetLastEventMonoTime() - inst->last_nke_success > CNF_GetNtsRefresh())) {
 
-    /* Before dropping the cookies, check whether there is an alternate set of
-       keys available (exported with the compliant context for AES-128-GCM-SIV)
-       and the NAK was the only valid response after the last NTS-KE session,
-       indicating we use incorrect keys and switching to the other set of keys
-       for the following NTP requests might work */
-    if (inst->alt_context.algorithm != AEAD_SIV_INVALID &&
-        inst->alt_context.algorithm == inst->context.algorithm &&
-        inst->nke_attempts > 0 && inst->nak_response && !inst->ok_response) {
+    /* Before dropping the cookies, try the alternate set of keys */
+    if (can_switch_keys(inst)) {
       inst->context = inst->alt_context;
       inst->alt_context.algorithm = AEAD_SIV_INVALID;
       DEBUG_LOG("Switched to compliant keys");
@@ -242,6 +274,58 @@ update_next_nke_attempt(NNC_Instance inst, int failed_start, double now)
 
 /* ================================================== */
 
+static int
+start_nke_session(NNC_Instance inst)
+{
+  assert(!inst->nke);
+
+  inst->nke = NKC_CreateInstance(&inst->nts_address, inst->name, inst->cert_set);
+
+  /* Try to resume the previous session to avoid a full handshake */
+  NKC_SetSessionData(inst->nke, inst->session_data, inst->session_data_length);
+
+  inst->nke_attempts++;
+
+  return NKC_Start(inst->nke);
+}
+
+/* ================================================== */
+
+static void
+start_background_nke(NNC_Instance inst)
+{
+  int failed_start;
+  double now;
+
+  now = SCH_GetLastEventMonoTime();
+
+  /* Don't start a session if one is already running, it would be limited
+     by the rate, or the alternate keys will be tried first */
+  if (inst->nke || now < inst->next_nke_attempt || can_switch_keys(inst))
+    return;
+
+  DEBUG_LOG("Starting NTS-KE in background");
+
+  failed_start = !start_nke_session(inst);
+  update_next_nke_attempt(inst, failed_start, now);
+}
+
+/* ================================================== */
+
+static void
+stop_background_nke(NNC_Instance inst)
+{
+  if (!inst->nke)
+    return;
+
+  DEBUG_LOG("Stopping NTS-KE in background");
+
+  NKC_DestroyInstance(inst->nke);
+  inst->nke = NULL;
+}
+
+/* ================================================== */
+
 static int
 get_cookies(NNC_Instance inst)
 {
@@ -253,7 +337,8 @@ get_cookies(NNC_Instance inst)
 
   now = SCH_GetLastEventMonoTime();
 
-  /* Create and start a new NTS-KE session if not already present */
+  /* Create and start a new NTS-KE session if not already present (e.g.
+     started in background after a NAK) */
   if (!inst->nke) {
     if (now < inst->next_nke_attempt) {
       DEBUG_LOG("Limiting NTS-KE request rate (%f seconds)",
@@ -261,12 +346,7 @@ get_cookies(NNC_Instance inst)
       return 0;
     }
 
-    inst->nke = NKC_CreateInstance(&inst->nts_address, inst->name, inst->cert_set);
-
-    inst->nke_attempts++;
-
-    if (!NKC_Start(inst->nke))
-      failed_start = 1;
+    failed_start = !start_nke_session(inst);
   }
 
   update_next_nke_attempt(inst, failed_start, now);
@@ -282,6 +362,14 @@ get_cookies(NNC_Instance inst)
                             inst->cookies, &inst->num_cookies, NTS_MAX_COOKIES,
                             &ntp_address);
 
+  /* Replace the used ticket with a new one if the server provided it */
+  if (got_data) {
+    const void *session_data;
+    int length = NKC_GetSessionData(inst->nke, &session_data);
+
+    set_session_data(inst, session_data, length);
+  }
+
   NKC_DestroyInstance(inst->nke);
   inst->nke = NULL;
 
@@ -319,10 +407,14 @@ NNC_PrepareForAuth(NNC_Instance inst)
   UTI_GetRandomBytes(inst->uniq_id, sizeof (inst->uniq_id));
   UTI_GetRandomBytes(inst->nonce, sizeof (inst->nonce));
 
-  /* Get new cookies if there are not any, or they are no longer usable */
+  /* Get new cookies if there are not any, or they are no longer usable.
+     Stop an NTS-KE session started after a NAK if the cookies turned out
+     to be still usable. */
   if (!check_cookies(inst)) {
     if (!get_cookies(inst))
       return 0;
+  } else {
+    stop_background_nke(inst);
   }
 
   inst->nak_response = 0;
@@ -521,6 +613,11 @@ NNC_CheckResponseAuth(NNC_Instance inst, NTP_Packet *packet,
         ntohl(packet->reference_id) == NTP_KOD_NTS_NAK) {
       DEBUG_LOG("NTS NAK");
       inst->nak_response = 1;
+
+      /* The cookies will be dropped on the next request unless a valid
+         response is received before that (the NAK is not authenticated).
+         Get new cookies in the meantime to not delay the next request. */
+      start_background_nke(inst);
       return 0;
     }
 
@@ -564,7 +661,7 @@ NNC_ChangeAddress(NNC_Instance inst, IPAddr *address)
 static void
 save_cookies(NNC_Instance inst)
 {
-  char buf[2 * NKE_MAX_COOKIE_LENGTH + 2], *dump_dir, *filename;
+  char buf[2 * NKE_MAX_SESSION_DATA_LENGTH + 2], *dump_dir, *filename;
   struct timespec now;
   double context_time;
   FILE *f;
@@ -597,6 +694,15 @@ save_cookies(NNC_Instance inst)
       fprintf(f, "%s\n", buf) < 0)
     goto error;
 
+  if (inst->session_data_length > 0) {
+    if (!UTI_BytesToHex(inst->session_data, inst->session_data_length, buf, sizeof (buf)) ||
+        fprintf(f, "%s\n", buf) < 0)
+      goto error;
+  } else {
+    if (fprintf(f, "-\n") < 0)
+      goto error;
+  }
+
   for (i = 0; i < inst->num_cookies; i++) {
     if (!UTI_BytesToHex(inst->cookies[i].cookie, inst->cookies[i].length, buf, sizeof (buf)) ||
         fprintf(f, "%s\n", buf) < 0)
@@ -624,9 +730,10 @@ error:
 static void
 load_cookies(NNC_Instance inst)
 {
-  char line[2 * NKE_MAX_COOKIE_LENGTH + 2], *dump_dir, *filename, *words[MAX_WORDS];
+  char line[2 * NKE_MAX_SESSION_DATA_LENGTH + 2], *dump_dir, *filename, *words[MAX_WORDS];
+  unsigned char session_data[NKE_MAX_SESSION_DATA_LENGTH];
+  int i, algorithm, port, old_ver, session_data_length;
   unsigned int context_id;
-  int i, algorithm, port;
   double context_time;
   struct timespec now;
   IPSockAddr ntp_addr;
@@ -650,8 +757,13 @@ load_cookies(NNC_Instance inst)
     SIV_DestroyInstance(inst->siv);
   inst->siv = NULL;
 
-  if (!fgets(line, sizeof (line), f) || strcmp(line, DUMP_IDENTIFIER) != 0 ||
-      !fgets(line, sizeof (line), f) || UTI_SplitString(line, words, MAX_WORDS) != 1 ||
+  if (!fgets(line, sizeof (line), f) ||
+      (strcmp(line, DUMP_IDENTIFIER) != 0 && strcmp(line, OLD_DUMP_IDENTIFIER) != 0))
+    goto error;
+
+  old_ver = strcmp(line, DUMP_IDENTIFIER) != 0;
+
+  if (!fgets(line, sizeof (line), f) || UTI_SplitString(line, words, MAX_WORDS) != 1 ||
         strcmp(words[0], inst->name) != 0 ||
       !fgets(line, sizeof (line), f) || UTI_SplitString(line, words, MAX_WORDS) != 1 ||
         sscanf(words[0], "%lf", &context_time) != 1 ||
@@ -673,6 +785,18 @@ load_cookies(NNC_Instance inst)
       inst->context.c2s.length != inst->context.s2c.length)
     goto error;
 
+  session_data_length = 0;
+
+  if (!old_ver) {
+    if (!fgets(line, sizeof (line), f) || UTI_SplitString(line, words, MAX_WORDS) != 1)
+      goto error;
+    if (strcmp(words[0], "-") != 0) {
+      session_data_length = UTI_HexToBytes(words[0], session_data, sizeof (session_data));
+      if (session_data_length == 0)
+        goto error;
+    }
+  }
+
   for (i = 0; i < NTS_MAX_COOKIES && fgets(line, sizeof (line), f); i++) {
     if (UTI_SplitString(line, words, MAX_WORDS) != 1)
       goto error;
@@ -695,6 +819,7 @@ load_cookies(NNC_Instance inst)
     context_time = 0;
   inst->last_nke_success = context_time + SCH_GetLastEventMonoTime();
   inst->context_id = context_id;
+  set_session_data(inst, session_data, session_data_length);
 
   fclose(f);
 
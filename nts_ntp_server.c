@@ -41,15 +41,28 @@
 #include "siv.h"
 #include "util.h"
 
-#define MAX_SERVER_SIVS 2
+/* Number of cached client contexts (must be a power of 2) */
+#define MAX_CACHED_CONTEXTS 256
+
+/* Client context decoded from a cookie, with the C2S and S2C keys set in
+   their SIV instances.  Clients reusing a cookie (e.g. retransmitting
+   a request) can be authenticated without decrypting the cookie and
+   expanding the keys again. */
+typedef struct {
+  NKE_Cookie cookie;
+  NKE_Context context;
+  SIV_Algorithm siv_algorithm;
+  SIV_Instance c2s_siv;
+  SIV_Instance s2c_siv;
+} CachedContext;
 
 struct NtsServer {
-  SIV_Instance sivs[MAX_SERVER_SIVS];
-  SIV_Algorithm siv_algorithms[MAX_SERVER_SIVS];
+  CachedContext contexts[MAX_CACHED_CONTEXTS];
+  uint32_t key_generation;
   unsigned char nonce[NTS_MIN_UNPADDED_NONCE_LENGTH];
   NKE_Cookie cookies[NTS_MAX_COOKIES];
   int num_cookies;
-  int siv_index;
+  SIV_Instance siv;
   NTP_int64 req_tx;
 };
 
@@ -62,7 +75,7 @@ void
 NNS_Initialise(void)
 {
   const char **certs, **keys;
-  int i;
+  SIV_Instance siv;
 
   /* Create an NTS-NTP server instance only if NTS-KE server is enabled */
   if (CNF_GetNtsServerCertAndKeyFiles(&certs, &keys) <= 0) {
@@ -70,18 +83,16 @@ NNS_Initialise(void)
     return;
   }
 
-  server = Malloc(sizeof (struct NtsServer));
-
-  server->siv_algorithms[0] = AEAD_AES_SIV_CMAC_256;
-  server->siv_algorithms[1] = AEAD_AES_128_GCM_SIV;
-  assert(MAX_SERVER_SIVS == 2);
-
-  for (i = 0; i < 2; i++)
-    server->sivs[i] = SIV_CreateInstance(server->siv_algorithms[i]);
-
   /* AES-SIV-CMAC-256 is required on servers */
-  if (!server->sivs[0])
+  siv = SIV_CreateInstance(AEAD_AES_SIV_CMAC_256);
+  if (!siv)
     LOG_FATAL("Missing AES-SIV-CMAC-256");
+  SIV_DestroyInstance(siv);
+
+  server = Malloc(sizeof (struct NtsServer));
+  memset(server->contexts, 0, sizeof (server->contexts));
+  server->key_generation = NKS_GetKeyGeneration();
+  server->siv = NULL;
 }
 
 /* ================================================== */
@@ -94,9 +105,11 @@ NNS_Finalise(void)
   if (!server)
     return;
 
-  for (i = 0; i < MAX_SERVER_SIVS; i++) {
-    if (server->sivs[i])
-      SIV_DestroyInstance(server->sivs[i]);
+  for (i = 0; i < MAX_CACHED_CONTEXTS; i++) {
+    if (server->contexts[i].c2s_siv)
+      SIV_DestroyInstance(server->contexts[i].c2s_siv);
+    if (server->contexts[i].s2c_siv)
+      SIV_DestroyInstance(server->contexts[i].s2c_siv);
   }
   Free(server);
   server = NULL;
@@ -104,15 +117,87 @@ NNS_Finalise(void)
 
 /* ================================================== */
 
+static CachedContext *
+get_cached_context(const unsigned char *cookie, int cookie_length)
+{
+  uint32_t hash, x;
+  int i;
+
+  /* Drop all contexts if a server key was replaced */
+  if (server->key_generation != NKS_GetKeyGeneration()) {
+    for (i = 0; i < MAX_CACHED_CONTEXTS; i++)
+      server->contexts[i].cookie.length = 0;
+    server->key_generation = NKS_GetKeyGeneration();
+  }
+
+  /* Hash the key ID and the beginning of the random nonce following it */
+  hash = 0;
+  if (cookie_length >= 2 * sizeof (x)) {
+    memcpy(&hash, cookie, sizeof (hash));
+    memcpy(&x, cookie + sizeof (hash), sizeof (x));
+    hash ^= x;
+  }
+
+  return &server->contexts[hash % MAX_CACHED_CONTEXTS];
+}
+
+/* ================================================== */
+
+static int
+is_cached_context(CachedContext *cached, const unsigned char *cookie, int cookie_length)
+{
+  return cached->cookie.length == cookie_length &&
+         memcmp(cached->cookie.cookie, cookie, cookie_length) == 0;
+}
+
+/* ================================================== */
+
+static int
+set_cached_context(CachedContext *cached)
+{
+  if (cached->context.algorithm != AEAD_AES_SIV_CMAC_256 &&
+      cached->context.algorithm != AEAD_AES_128_GCM_SIV) {
+    DEBUG_LOG("Unexpected SIV");
+    return 0;
+  }
+
+  if (!cached->c2s_siv || cached->siv_algorithm != cached->context.algorithm) {
+    if (cached->c2s_siv)
+      SIV_DestroyInstance(cached->c2s_siv);
+    if (cached->s2c_siv)
+      SIV_DestroyInstance(cached->s2c_siv);
+    cached->siv_algorithm = cached->context.algorithm;
+    cached->c2s_siv = SIV_CreateInstance(cached->siv_algorithm);
+    cached->s2c_siv = SIV_CreateInstance(cached->siv_algorithm);
+  }
+
+  if (!cached->c2s_siv || !cached->s2c_siv) {
+    DEBUG_LOG("Unexpected SIV");
+    return 0;
+  }
+
+  if (!SIV_SetKey(cached->c2s_siv, cached->context.c2s.key, cached->context.c2s.length)) {
+    DEBUG_LOG("Could not set C2S key");
+    return 0;
+  }
+
+  if (!SIV_SetKey(cached->s2c_siv, cached->context.s2c.key, cached->context.s2c.length)) {
+    DEBUG_LOG("Could not set S2C key");
+    return 0;
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
 int
 NNS_CheckRequestAuth(NTP_Packet *packet, NTP_PacketInfo *info, uint32_t *kod)
 {
   int ef_type, ef_body_length, ef_length, has_uniq_id = 0, has_auth = 0, has_cookie = 0;
-  int i, plaintext_length, parsed, requested_cookies, cookie_length = -1, auth_start = 0;
-  unsigned char plaintext[NTP_MAX_EXTENSIONS_LENGTH];
-  NKE_Context context;
-  NKE_Cookie cookie;
-  SIV_Instance siv;
+  int n, plaintext_length, parsed, requested_cookies, cookie_length = -1, auth_start = 0;
+  unsigned char plaintext[NTP_MAX_EXTENSIONS_LENGTH], *cookie = NULL;
+  CachedContext *cached;
   void *ef_body;
 
   *kod = 0;
@@ -121,7 +206,7 @@ NNS_CheckRequestAuth(NTP_Packet *packet, NTP_PacketInfo *info, uint32_t *kod)
     return 0;
 
   server->num_cookies = 0;
-  server->siv_index = -1;
+  server->siv = NULL;
   server->req_tx = packet->transmit_ts;
 
   if (info->ext_fields == 0 || info->mode != MODE_CLIENT)
@@ -140,12 +225,13 @@ NNS_CheckRequestAuth(NTP_Packet *packet, NTP_PacketInfo *info, uint32_t *kod)
         has_uniq_id = 1;
         break;
       case NTP_EF_NTS_COOKIE:
-        if (has_cookie || ef_body_length > sizeof (cookie.cookie)) {
+        if (has_cookie || ef_body_length > sizeof (cached->cookie.cookie)) {
           DEBUG_LOG("Unexpected cookie/length");
           return 0;
         }
-        cookie.length = ef_body_length;
-        memcpy(cookie.cookie, ef_body, ef_body_length);
+        /* Refer to the cookie in the packet, it is copied only
+           if it needs to be decoded */
+        cookie = ef_body;
         has_cookie = 1;
         /* Fall through */
       case NTP_EF_NTS_COOKIE_PLACEHOLDER:
@@ -176,27 +262,26 @@ NNS_CheckRequestAuth(NTP_Packet *packet, NTP_PacketInfo *info, uint32_t *kod)
     return 0;
   }
 
-  if (!NKS_DecodeCookie(&cookie, &context)) {
-    *kod = NTP_KOD_NTS_NAK;
-    return 0;
-  }
+  /* Decode the cookie and set the keys only if the context is not
+     already cached */
+  cached = get_cached_context(cookie, cookie_length);
+  if (!is_cached_context(cached, cookie, cookie_length)) {
+    cached->cookie.length = cookie_length;
+    memcpy(cached->cookie.cookie, cookie, cookie_length);
 
-  /* Find the SIV instance needed for authentication */
-  for (i = 0; i < MAX_SERVER_SIVS && context.algorithm != server->siv_algorithms[i]; i++)
-    ;
-  if (i == MAX_SERVER_SIVS || !server->sivs[i]) {
-    DEBUG_LOG("Unexpected SIV");
-    return 0;
-  }
-  server->siv_index = i;
-  siv = server->sivs[i];
+    if (!NKS_DecodeCookie(&cached->cookie, &cached->context)) {
+      cached->cookie.length = 0;
+      *kod = NTP_KOD_NTS_NAK;
+      return 0;
+    }
 
-  if (!SIV_SetKey(siv, context.c2s.key, context.c2s.length)) {
-    DEBUG_LOG("Could not set C2S key");
-    return 0;
+    if (!set_cached_context(cached)) {
+      cached->cookie.length = 0;
+      return 0;
+    }
   }
 
-  if (!NNA_DecryptAuthEF(packet, info, siv, auth_start,
+  if (!NNA_DecryptAuthEF(packet, info, cached->c2s_siv, auth_start,
                          plaintext, sizeof (plaintext), &plaintext_length)) {
     *kod = NTP_KOD_NTS_NAK;
     return 0;
@@ -222,10 +307,7 @@ NNS_CheckRequestAuth(NTP_Packet *packet, NTP_PacketInfo *info, uint32_t *kod)
     }
   }
 
-  if (!SIV_SetKey(siv, context.s2c.key, context.s2c.length)) {
-    DEBUG_LOG("Could not set S2C key");
-    return 0;
-  }
+  server->siv = cached->s2c_siv;
 
   /* Prepare data for NNS_GenerateResponseAuth() to minimise the time spent
      there (when the TX timestamp is already set) */
@@ -233,11 +315,11 @@ NNS_CheckRequestAuth(NTP_Packet *packet, NTP_PacketInfo *info, uint32_t *kod)
   UTI_GetRandomBytes(server->nonce, sizeof (server->nonce));
 
   assert(sizeof (server->cookies) / sizeof (server->cookies[0]) == NTS_MAX_COOKIES);
-  for (i = 0; i < NTS_MAX_COOKIES && i < requested_cookies; i++)
-    if (!NKS_GenerateCookie(&context, &server->cookies[i]))
-      return 0;
+  n = MIN(requested_cookies, NTS_MAX_COOKIES);
+  if (!NKS_GenerateCookies(&cached->context, server->cookies, n))
+    return 0;
 
-  server->num_cookies = i;
+  server->num_cookies = n;
 
   return 1;
 }
@@ -249,10 +331,9 @@ NNS_GenerateResponseAuth(NTP_Packet *request, NTP_PacketInfo *req_info,
                          NTP_Packet *response, NTP_PacketInfo *res_info,
                          uint32_t kod)
 {
-  int i, ef_type, ef_body_length, ef_length, parsed;
+  int i, ef_type, ef_body_length, ef_length, parsed, plaintext_length, auth_start;
+  unsigned char *plaintext;
   void *ef_body;
-  unsigned char plaintext[NTP_MAX_EXTENSIONS_LENGTH];
-  int plaintext_length;
 
   if (!server || req_info->mode != MODE_CLIENT || res_info->mode != MODE_SERVER)
     return 0;
@@ -281,28 +362,35 @@ NNS_GenerateResponseAuth(NTP_Packet *request, NTP_PacketInfo *req_info,
   if (kod == NTP_KOD_NTS_NAK)
     return 1;
 
-  for (i = 0, plaintext_length = 0; i < server->num_cookies; i++) {
-    if (!NEF_SetField(plaintext, sizeof (plaintext), plaintext_length,
+  if (!server->siv)
+    return 0;
+
+  for (i = 0, plaintext_length = 0; i < server->num_cookies; i++)
+    plaintext_length += 4 + server->cookies[i].length;
+
+  /* Add an authenticator field which will make the length of the response
+     equal to the length of the request, write the cookies directly to its
+     plaintext buffer in the response, and encrypt them there */
+  if (!NNA_AddAuthEF(response, res_info, server->siv,
+                     server->nonce, sizeof (server->nonce), plaintext_length,
+                     req_info->length - res_info->length, &auth_start, &plaintext))
+    return 0;
+
+  for (i = 0, parsed = 0; i < server->num_cookies; i++) {
+    if (!NEF_SetField(plaintext, plaintext_length, parsed,
                       NTP_EF_NTS_COOKIE, server->cookies[i].cookie,
                       server->cookies[i].length, &ef_length))
-      return 0;
-
-    plaintext_length += ef_length;
-    assert(plaintext_length <= sizeof (plaintext));
+      break;
+    parsed += ef_length;
   }
 
   server->num_cookies = 0;
 
-  if (server->siv_index < 0)
-    return 0;
-
-  /* Generate an authenticator field which will make the length
-     of the response equal to the length of the request */
-  if (!NNA_GenerateAuthEF(response, res_info, server->sivs[server->siv_index],
-                          server->nonce, sizeof (server->nonce),
-                          plaintext, plaintext_length,
-                          req_info->length - res_info->length))
+  if (parsed != plaintext_length) {
+    res_info->length = auth_start;
+    res_info->ext_fields--;
     return 0;
+  }
 
-  return 1;
+  return NNA_EncryptAuthEF(response, res_info, server->siv, auth_start);
 }
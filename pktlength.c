@@ -160,8 +160,9 @@ static const uint16_t reply_lengths[] = {
   0,                                            /* SERVER_STATS2 - not supported */
   RPY_LENGTH_ENTRY(select_data),                /* SELECT_DATA */
   0,                                            /* SERVER_STATS3 - not supported */
-  RPY_LENGTH_ENTRY(server_stats),               /* SERVER_STATS4 */
+  0,                                            /* SERVER_STATS4 - not supported */
   RPY_LENGTH_ENTRY(ntp_data),                   /* NTP_DATA2 */
+  RPY_LENGTH_ENTRY(server_stats),               /* SERVER_STATS5 */
 };
 
 /* ================================================== */
@@ -107,6 +107,16 @@ static char *mail_change_user;
 /* Handler for mode ending */
 static REF_ModeEndHandler mode_end_handler = NULL;
 
+/* Snapshot of the server state protected by a sequence lock.  The main
+   thread is the only writer. */
+static uint32_t server_state_seq;
+static REF_ServerState server_state;
+
+/* Local time when the server state needs to be recomputed (zero if it
+   does not change with time) and timer triggering the update */
+static struct timespec server_state_expiry;
+static SCH_TimeoutID server_state_timeout_id;
+
 /* Filename of the drift file. */
 static char *drift_file=NULL;
 static double drift_file_age;
@@ -158,6 +168,7 @@ static int ref_adjustments;
 /* ================================================== */
 
 static void update_leap_status(NTP_Leap leap, time_t now, int reset);
+static void update_server_state(void);
 
 /* ================================================== */
 
@@ -186,6 +197,8 @@ handle_slew(struct timespec *raw,
     LCL_ReadRawTime(&now);
     update_leap_status(our_leap_status, now.tv_sec, 1);
   }
+
+  update_server_state();
 }
 
 /* ================================================== */
@@ -285,6 +298,9 @@ REF_Initialise(void)
   last_ref_adjustment = 0.0;
   ref_adjustments = 0;
 
+  UTI_ZeroTimespec(&server_state_expiry);
+  server_state_timeout_id = 0;
+
   LCL_AddParameterChangeHandler(handle_slew, NULL);
 
   /* Make first entry in tracking log */
@@ -304,6 +320,8 @@ REF_Finalise(void)
 
   LCL_RemoveParameterChangeHandler(handle_slew, NULL);
 
+  SCH_RemoveTimeout(server_state_timeout_id);
+
   Free(fb_drifts);
 
   initialised = 0;
@@ -602,6 +620,8 @@ leap_end_timeout(void *arg)
   if (our_leap_status == LEAP_InsertSecond ||
       our_leap_status == LEAP_DeleteSecond)
     our_leap_status = LEAP_Normal;
+
+  update_server_state();
 }
 
 /* ================================================== */
@@ -634,6 +654,8 @@ leap_start_timeout(void *arg)
 
   /* Wait until the leap second is over with some extra room to be safe */
   leap_timeout_id = SCH_AddTimeoutByDelay(2.0, leap_end_timeout, NULL);
+
+  update_server_state();
 }
 
 /* ================================================== */
@@ -1033,6 +1055,8 @@ REF_SetReference(int stratum, NTP_Leap leap, int combined_sources,
   }
 
   ref_adjustments = 0;
+
+  update_server_state();
 }
 
 /* ================================================== */
@@ -1110,6 +1134,8 @@ REF_SetUnsynchronised(void)
 
   write_log(&now, 0, LCL_ReadAbsoluteFrequency(), 0.0, 0.0, uncorrected_offset,
             our_root_delay / 2.0 + get_root_dispersion(&now));
+
+  update_server_state();
 }
 
 /* ================================================== */
@@ -1129,6 +1155,8 @@ REF_UpdateLeapStatus(NTP_Leap leap)
 
   /* Update also the synchronisation status */
   update_sync_status(&now);
+
+  update_server_state();
 }
 
 /* ================================================== */
@@ -1225,6 +1253,161 @@ REF_GetReferenceParams
 
 /* ================================================== */
 
+static void
+add_expiry(struct timespec *expiry, struct timespec *now, struct timespec *base, double delay)
+{
+  struct timespec ts;
+
+  UTI_AddDoubleToTimespec(base, delay, &ts);
+
+  /* Ignore times which already passed to avoid repeated updates */
+  if (UTI_CompareTimespecs(&ts, now) <= 0)
+    return;
+
+  if (UTI_IsZeroTimespec(expiry) || UTI_CompareTimespecs(&ts, expiry) < 0)
+    *expiry = ts;
+}
+
+/* ================================================== */
+
+static void
+get_server_state_expiry(struct timespec *now, REF_ServerState *state,
+                        struct timespec *expiry)
+{
+  double wait;
+
+  UTI_ZeroTimespec(expiry);
+
+  if (!enable_local_stratum)
+    return;
+
+  /* Find the earliest time when the local reference can be activated
+     (the root distance can only increase until the next update) */
+  if (are_we_synchronised) {
+    add_expiry(expiry, now, &our_ref_time, local_wait_synced);
+    if (state->root_dispersion_rate > 0.0)
+      add_expiry(expiry, now, &our_ref_time,
+                 (local_distance - our_root_delay / 2.0 - state->root_dispersion) /
+                 state->root_dispersion_rate);
+  } else {
+    wait = local_wait_unsynced - (SCH_GetLastEventMonoTime() - unsynchronised_since);
+    add_expiry(expiry, now, now, wait);
+  }
+
+  if (state->ref_id == NTP_REFID_LOCAL)
+    add_expiry(expiry, now, &local_ref_time, LOCAL_REF_UPDATE_INTERVAL);
+}
+
+/* ================================================== */
+
+static void
+server_state_timeout(void *arg)
+{
+  server_state_timeout_id = 0;
+  update_server_state();
+}
+
+/* ================================================== */
+
+static void
+publish_server_state(struct timespec *now)
+{
+  REF_ServerState state;
+  double root_delay, root_dispersion;
+  struct timespec ref_time;
+  int synchronised, stratum;
+  uint32_t ref_id, seq;
+  NTP_Leap leap;
+
+  REF_GetReferenceParams(now, &synchronised, &leap, &stratum, &ref_id, &ref_time,
+                         &root_delay, &root_dispersion);
+
+  memset(&state, 0, sizeof (state));
+  state.ref_time = ref_time;
+
+  /* Save the root dispersion at the reference time to allow the readers to
+     calculate it for any time */
+  if (synchronised && !UTI_IsZeroTimespec(&our_ref_time)) {
+    state.root_dispersion = our_root_dispersion;
+    state.root_dispersion_rate = our_skew + fabs(our_residual_freq) + LCL_GetMaxClockError();
+  } else {
+    state.root_dispersion = root_dispersion;
+    state.root_dispersion_rate = 0.0;
+  }
+
+  state.root_delay = root_delay;
+  state.ref_id = ref_id;
+  state.leap = leap;
+  state.stratum = stratum;
+  state.synchronised = synchronised;
+  state.precision = LCL_GetSysPrecisionAsLog();
+
+  get_server_state_expiry(now, &state, &server_state_expiry);
+
+  seq = server_state_seq;
+  __atomic_store_n(&server_state_seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  server_state = state;
+  __atomic_store_n(&server_state_seq, seq + 2, __ATOMIC_RELEASE);
+
+  /* Make sure the state is updated even if there are no calls
+     of REF_GetServerState() in the main thread */
+  SCH_RemoveTimeout(server_state_timeout_id);
+  server_state_timeout_id = 0;
+  if (!UTI_IsZeroTimespec(&server_state_expiry))
+    server_state_timeout_id = SCH_AddTimeout(&server_state_expiry, server_state_timeout,
+                                             NULL);
+}
+
+/* ================================================== */
+
+static void
+update_server_state(void)
+{
+  struct timespec now;
+
+  LCL_ReadCookedTime(&now, NULL);
+  publish_server_state(&now);
+}
+
+/* ================================================== */
+
+void
+REF_GetServerState(struct timespec *local_time, REF_ServerState *state)
+{
+  if (!UTI_IsZeroTimespec(&server_state_expiry) &&
+      UTI_CompareTimespecs(local_time, &server_state_expiry) >= 0)
+    publish_server_state(local_time);
+
+  *state = server_state;
+}
+
+/* ================================================== */
+
+void
+REF_ReadServerState(REF_ServerState *state)
+{
+  uint32_t seq;
+
+  do {
+    seq = __atomic_load_n(&server_state_seq, __ATOMIC_ACQUIRE);
+    *state = server_state;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) || seq != __atomic_load_n(&server_state_seq, __ATOMIC_RELAXED));
+}
+
+/* ================================================== */
+
+double
+REF_GetServerRootDispersion(REF_ServerState *state, struct timespec *local_time)
+{
+  return state->root_dispersion +
+         fabs(UTI_DiffTimespecsToDouble(local_time, &state->ref_time)) *
+         state->root_dispersion_rate;
+}
+
+/* ================================================== */
+
 int
 REF_GetOurStratum(void)
 {
@@ -1292,6 +1475,8 @@ REF_EnableLocal(int stratum, double distance, int orphan, double activate,
   local_wait_synced = wait_synced;
   local_wait_unsynced = wait_unsynced;
   LOG(LOGS_INFO, "%s local reference mode", "Enabled");
+
+  update_server_state();
 }
 
 /* ================================================== */
@@ -1301,6 +1486,8 @@ REF_DisableLocal(void)
 {
   enable_local_stratum = 0;
   LOG(LOGS_INFO, "%s local reference mode", "Disabled");
+
+  update_server_state();
 }
 
 /* ================================================== */
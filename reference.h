@@ -109,6 +109,36 @@ extern void REF_GetReferenceParams
  double *root_dispersion
 );
 
+/* Snapshot of the reference parameters needed to form a server response
+   (fitting in one cache line).  It is recomputed only when the reference,
+   leap status, or local reference changes, or when the local reference
+   can be activated or needs to update its reference time. */
+typedef struct {
+  /* Reference time and root dispersion at the reference time, which
+     increases at the specified rate */
+  struct timespec ref_time;
+  double root_dispersion;
+  double root_dispersion_rate;
+  double root_delay;
+  uint32_t ref_id;
+  uint8_t leap;
+  uint8_t stratum;
+  uint8_t synchronised;
+  int8_t precision;
+} REF_ServerState;
+
+/* Get the server state valid at a local cooked time.  This function can be
+   called only from the main thread. */
+extern void REF_GetServerState(struct timespec *local_time, REF_ServerState *state);
+
+/* Get a consistent copy of the last published server state.  This function
+   can be called from other threads. */
+extern void REF_ReadServerState(REF_ServerState *state);
+
+/* Get the root dispersion of a server state at a local cooked time */
+extern double REF_GetServerRootDispersion(REF_ServerState *state,
+                                          struct timespec *local_time);
+
 /* Function called by the clock selection process to register a new
    reference source and its parameters
 
@@ -34,7 +34,15 @@
 #include "logging.h"
 #include "util.h"
 
-#define MAX_POINTS 64
+#define MAX_POINTS RGR_MAX_POINTS
+
+/* Maximum number of points in the robust regression */
+#define MAX_ROBUST_POINTS 64
+
+/* Maximum number of starting indices tested in RGR_FindBestRegression().
+   With more points, the oldest points are dropped in larger steps to keep
+   the complexity linear. */
+#define MAX_RUNS_TESTS 64
 
 void
 RGR_WeightedRegression
@@ -170,22 +178,37 @@ static char critical_runs[] = {
  52, 52, 52, 53, 53, 54, 54, 55, 55, 56
 };
 
+/* ================================================== */
+/* Return the critical number of runs for n residuals.  Outside the
+   table use the normal approximation of the distribution of runs
+   (mean (n + 1) / 2 and variance (n - 1) / 4), which gives the same
+   values as the end of the table. */
+
+static int
+get_critical_runs(int n)
+{
+  if (n < sizeof (critical_runs) / sizeof (critical_runs[0]))
+    return critical_runs[n];
+
+  return (n + 1) / 2.0 - 1.645 * sqrt(n - 1) / 2.0 + 0.5;
+}
+
 /* ================================================== */
 
 static int
 n_runs_from_residuals(double *resid, int n)
 {
-  int nruns;
+  int nruns, sign, prev_sign;
   int i;
-  
+
+  /* A zero residual doesn't continue a run.  Count the runs without
+     branches to allow the compiler to vectorise the loop. */
   nruns = 1;
+  prev_sign = (resid[0] > 0.0) - (resid[0] < 0.0);
   for (i=1; i<n; i++) {
-    if (((resid[i-1] < 0.0) && (resid[i] < 0.0)) ||
-        ((resid[i-1] > 0.0) && (resid[i] > 0.0))) {
-      /* Nothing to do */
-    } else {
-      nruns++;
-    }
+    sign = (resid[i] > 0.0) - (resid[i] < 0.0);
+    nruns += sign * prev_sign != 1;
+    prev_sign = sign;
   }
   
   return nruns;
@@ -231,42 +254,52 @@ RGR_FindBestRegression
 
 )
 {
-  double P, Q, U, V, W; /* total */
-  double resid[MAX_POINTS * REGRESS_RUNS_RATIO];
-  double ss;
-  double a, b, u, ui, aa;
+  /* The buffers are too large for the stack */
+  static double sW[MAX_POINTS], sux[MAX_POINTS], suy[MAX_POINTS], sV[MAX_POINTS];
+  static double sC[MAX_POINTS], resid[MAX_POINTS * REGRESS_RUNS_RATIO];
+
+  double ss, vi, dx, dy, ux, uy, V, C, W;
+  double a, b, u, aa;
 
-  int start, resid_start, nruns, npoints;
+  int start, resid_start, nruns, npoints, step, max_start;
   int i;
 
   assert(n <= MAX_POINTS && m >= 0);
-  assert(n * REGRESS_RUNS_RATIO < sizeof (critical_runs) / sizeof (critical_runs[0]));
 
   if (n < MIN_SAMPLES_FOR_REGRESS) {
     return 0;
   }
 
-  start = 0;
-  do {
-
-    W = U = 0;
-    for (i=start; i<n; i++) {
-      U += x[i]        / w[i];
-      W += 1.0         / w[i];
-    }
+  /* Fit the line for all possible starting indices in one pass over the
+     data.  The points are added from the end, updating the weighted means
+     and the sums of squared deviations and products incrementally to avoid
+     cancellation. */
+  W = ux = uy = V = C = 0.0;
+  for (i = n - 1; i >= 0; i--) {
+    vi = 1.0 / w[i];
+    W += vi;
+    dx = x[i] - ux;
+    dy = y[i] - uy;
+    ux += dx * vi / W;
+    uy += dy * vi / W;
+    V += vi * dx * (x[i] - ux);
+    C += vi * dx * (y[i] - uy);
+
+    sW[i] = W;
+    sux[i] = ux;
+    suy[i] = uy;
+    sV[i] = V;
+    sC[i] = C;
+  }
 
-    u = U / W;
+  step = (n + MAX_RUNS_TESTS - 1) / MAX_RUNS_TESTS;
+  max_start = n - MAX(MIN_SAMPLES_FOR_REGRESS, min_samples);
 
-    P = Q = V = 0.0;
-    for (i=start; i<n; i++) {
-      ui = x[i] - u;
-      P += y[i]        / w[i];
-      Q += y[i] * ui   / w[i];
-      V += ui   * ui   / w[i];
-    }
+  start = 0;
+  do {
 
-    b = Q / V;
-    a = (P / W) - (b * u);
+    b = sC[start] / sV[start];
+    a = suy[start] - b * sux[start];
 
     /* Get residuals also for the extra samples before start */
     resid_start = n - (n - start) * REGRESS_RUNS_RATIO;
@@ -280,21 +313,24 @@ RGR_FindBestRegression
     /* Count number of runs */
     nruns = n_runs_from_residuals(resid, n - resid_start); 
 
-    if (nruns > critical_runs[n - resid_start] ||
-        n - start <= MIN_SAMPLES_FOR_REGRESS ||
-        n - start <= min_samples) {
+    if (nruns > get_critical_runs(n - resid_start) || start >= max_start) {
       if (start != resid_start) {
         /* Ignore extra samples in returned nruns */
         nruns = n_runs_from_residuals(resid + (start - resid_start), n - start);
       }
       break;
     } else {
-      /* Try dropping one sample at a time until the runs test passes. */
-      ++start;
+      /* Try dropping one sample (or a larger group of samples if there
+         are many) at a time until the runs test passes. */
+      start = MIN(start + step, max_start);
     }
 
   } while (1);
 
+  W = sW[start];
+  u = sux[start];
+  V = sV[start];
+
   /* Work out statistics from full dataset */
   *b1 = b;
   *b0 = a;
@@ -325,90 +361,49 @@ RGR_FindBestRegression
 
 /* ================================================== */
 /* Find the index'th biggest element in the array x of n elements.
-   flags is an array where a 1 indicates that the corresponding entry
-   in x is known to be sorted into its correct position and a 0
-   indicates that the corresponding entry is not sorted.  However, if
-   flags[m] = flags[n] = 1 with m<n, then x[m] must be <= x[n] and for
-   all i with m<i<n, x[m] <= x[i] <= x[n].  In practice, this means
-   flags[] has to be the result of a previous call to this routine
-   with the same array x, and is used to remember which parts of the
-   x[] array we have already sorted.
-
-   The approach used is a cut-down quicksort, where we only bother to
-   keep sorting the partition that contains the index we are after.
-   The approach comes from Numerical Recipes in C (ISBN
-   0-521-43108-5). */
+   The array is partially sorted, all elements before the index are not
+   larger than the returned value and all elements after it are not
+   smaller.
+
+   The approach used is Hoare's FIND algorithm, a cut-down quicksort,
+   where we only keep partitioning the part that contains the index we
+   are after.  The inner loops have no bound checks as the pivot stops
+   them. */
 
 static double
-find_ordered_entry_with_flags(double *x, int n, int index, char *flags)
+find_ordered_entry(double *x, int n, int index)
 {
-  int u, v, l, r;
+  int l, r, i, j;
   double temp;
   double piv;
-  int pivind;
 
-  assert(index >= 0);
+  assert(index >= 0 && index < n);
 
-  /* If this bit of the array is already sorted, simple! */
-  if (flags[index]) {
-    return x[index];
-  }
-  
-  /* Find subrange to look at */
-  u = v = index;
-  while (u > 0 && !flags[u]) u--;
-  if (flags[u]) u++;
-
-  while (v < (n-1) && !flags[v]) v++;
-  if (flags[v]) v--;
+  l = 0;
+  r = n - 1;
 
-  do {
-    if (v - u < 2) {
-      if (x[v] < x[u]) {
-        EXCH(x[v], x[u]);
-      }
-      flags[v] = flags[u] = 1;
-      return x[index];
-    } else { 
-      pivind = (u + v) >> 1;
-      EXCH(x[u], x[pivind]);
-      piv = x[u]; /* New value */
-      l = u + 1;
-      r = v;
-      do {
-        while (l < v && x[l] < piv) l++;
-        while (r > 0 && x[r] > piv) r--;
-        if (r <= l) break;
-        EXCH(x[l], x[r]);
-        l++;
-        r--;
-      } while (1);
-      EXCH(x[u], x[r]);
-      flags[r] = 1; /* Pivot now in correct place */
-      if (index == r) {
-        return x[r];
-      } else if (index < r) {
-        v = r - 1;
-      } else if (index > r) {
-        u = l;
+  while (l < r) {
+    piv = x[index];
+    i = l;
+    j = r;
+    do {
+      while (x[i] < piv) i++;
+      while (piv < x[j]) j--;
+      if (i <= j) {
+        EXCH(x[i], x[j]);
+        i++;
+        j--;
       }
-    }
-  } while (1);
-}
-
-/* ================================================== */
+    } while (i <= j);
 
-#if 0
-/* Not used, but this is how it can be done */
-static double
-find_ordered_entry(double *x, int n, int index)
-{
-  char flags[MAX_POINTS];
+    if (j < index)
+      l = i;
+    if (index < i)
+      r = j;
+  }
 
-  memset(flags, 0, n * sizeof (flags[0]));
-  return find_ordered_entry_with_flags(x, n, index, flags);
+  return x[index];
 }
-#endif
 
 /* ================================================== */
 /* Find the median entry of an array x[] with n elements. */
@@ -416,16 +411,20 @@ find_ordered_entry(double *x, int n, int index)
 static double
 find_median(double *x, int n)
 {
-  int k;
-  char flags[MAX_POINTS];
+  double lower;
+  int i, k;
 
-  memset(flags, 0, n * sizeof (flags[0]));
   k = n>>1;
   if (n&1) {
-    return find_ordered_entry_with_flags(x, n, k, flags);
+    return find_ordered_entry(x, n, k);
   } else {
-    return 0.5 * (find_ordered_entry_with_flags(x, n, k, flags) +
-                  find_ordered_entry_with_flags(x, n, k-1, flags));
+    /* The other middle entry is the largest entry in the lower part */
+    find_ordered_entry(x, n, k);
+    for (i = 1, lower = x[0]; i < k; i++) {
+      if (lower < x[i])
+        lower = x[i];
+    }
+    return 0.5 * (x[k] + lower);
   }
 }
 
@@ -434,7 +433,7 @@ find_median(double *x, int n)
 double
 RGR_FindMedian(double *x, int n)
 {
-  double tmp[MAX_POINTS];
+  static double tmp[MAX_POINTS];
 
   assert(n > 0 && n <= MAX_POINTS);
   memcpy(tmp, x, n * sizeof (tmp[0]));
@@ -463,7 +462,7 @@ eval_robust_residual
 {
   int i;
   double a, res, del;
-  double d[MAX_POINTS];
+  double d[MAX_ROBUST_POINTS];
 
   for (i=0; i<n; i++) {
     d[i] = y[i] - b * x[i];
@@ -516,13 +515,13 @@ RGR_FindBestRobustRegression
   int n_points;
   double a, b;
   double P, U, V, W, X;
-  double resid, resids[MAX_POINTS];
+  double resid, resids[MAX_ROBUST_POINTS];
   double blo, bhi, bmid, rlo, rhi, rmid;
   double s2, sb, incr;
   double mx, dx, my, dy;
   int nruns = 0;
 
-  assert(n <= MAX_POINTS);
+  assert(n <= MAX_ROBUST_POINTS);
 
   if (n < 2) {
     return 0;
@@ -69,6 +69,10 @@ extern double RGR_GetChi2Coef(int dof);
 /* Minimum number of samples for regression */
 #define MIN_SAMPLES_FOR_REGRESS 3
 
+/* Maximum number of points in RGR_FindBestRegression() and
+   RGR_FindMedian() */
+#define RGR_MAX_POINTS 4096
+
 /* Return a status indicating whether there were enough points to
    carry out the regression */
 
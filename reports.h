@@ -108,6 +108,9 @@ typedef struct {
   uint32_t last_cmd_hit_ago;
 } RPT_ClientAccessByIndex_Report;
 
+/* Number of power-of-two buckets in the histogram of NTP receive batches */
+#define RPT_RX_BATCH_BUCKETS 9
+
 typedef struct {
   uint64_t ntp_hits;
   uint64_t nke_hits;
@@ -126,6 +129,7 @@ typedef struct {
   uint64_t ntp_kernel_tx_timestamps;
   uint64_t ntp_hw_rx_timestamps;
   uint64_t ntp_hw_tx_timestamps;
+  uint64_t ntp_rx_batches[RPT_RX_BATCH_BUCKETS];
 } RPT_ServerStatsReport;
 
 typedef struct {
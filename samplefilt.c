@@ -197,21 +197,43 @@ SPF_DropSamples(SPF_Instance filter)
 
 /* ================================================== */
 
-static const NTP_Sample *tmp_sort_samples;
+/* Reorder the array of n sample indices to have the sample with the k-th
+   smallest offset at index k, samples with smaller or equal offsets before
+   it, and samples with larger or equal offsets after it (Hoare's FIND
+   algorithm) */
 
-static int
-compare_samples(const void *a, const void *b)
+static void
+select_by_offset(const NTP_Sample *samples, int *indices, int n, int k)
 {
-  const NTP_Sample *s1, *s2;
-
-  s1 = &tmp_sort_samples[*(int *)a];
-  s2 = &tmp_sort_samples[*(int *)b];
-
-  if (s1->offset < s2->offset)
-    return -1;
-  else if (s1->offset > s2->offset)
-    return 1;
-  return 0;
+  int l, r, i, j, t;
+  double pivot;
+
+  l = 0;
+  r = n - 1;
+
+  while (l < r) {
+    pivot = samples[indices[k]].offset;
+    i = l;
+    j = r;
+    do {
+      while (samples[indices[i]].offset < pivot)
+        i++;
+      while (pivot < samples[indices[j]].offset)
+        j--;
+      if (i <= j) {
+        t = indices[i];
+        indices[i] = indices[j];
+        indices[j] = t;
+        i++;
+        j--;
+      }
+    } while (i <= j);
+
+    if (j < k)
+      l = i;
+    if (k < i)
+      r = j;
+  }
 }
 
 /* ================================================== */
@@ -250,10 +272,6 @@ select_samples(SPF_Instance filter)
       selected[j] = j;
   }
 
-  /* And sort their indices by offset */
-  tmp_sort_samples = filter->samples;
-  qsort(selected, j, sizeof (int), compare_samples);
-
   /* Select samples closest to the median */
   if (j > 2) {
     from = j * (1.0 - filter->combine_ratio) / 2.0;
@@ -264,6 +282,13 @@ select_samples(SPF_Instance filter)
 
   to = j - from;
 
+  /* Move the samples with the offsets ranked from "from" to "to - 1"
+     to the middle of the array.  Their order doesn't matter. */
+  if (from > 0) {
+    select_by_offset(filter->samples, selected, j, from);
+    select_by_offset(filter->samples, selected + from, j - from, to - 1 - from);
+  }
+
   /* Mark unused samples and sort the rest by their time */
 
   o = filter->used - filter->index - 1;
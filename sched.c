@@ -55,6 +55,18 @@ typedef struct {
 
 static ARR_Instance file_handlers;
 
+#ifdef HAVE_EPOLL
+/* Maximum number of events returned by one epoll_wait() call */
+#define MAX_EPOLL_EVENTS 64
+
+/* The epoll instance, which is created on start of the main loop to not
+   share it with processes forked before */
+static int epoll_fd;
+
+/* Number of descriptors waiting for input or output */
+static unsigned int n_polled_fds;
+#endif
+
 /* Timestamp when last select() returned */
 static struct timespec last_select_ts, last_select_ts_raw;
 static double last_select_ts_err;
@@ -71,8 +83,6 @@ static uint32_t last_select_ts_mono_ns;
 
 typedef struct _TimerQueueEntry
 {
-  struct _TimerQueueEntry *next; /* Forward and back links in the list */
-  struct _TimerQueueEntry *prev;
   struct timespec ts;           /* Local system time at which the
                                    timeout is to expire.  Clearly this
                                    must be in terms of what the
@@ -83,19 +93,36 @@ typedef struct _TimerQueueEntry
                                    driver module would apply to time
                                    that we pass to clients etc doesn't
                                    apply to this. */
+  uint64_t seq;                 /* Sequence number ordering timeouts
+                                   expiring at the same time */
   SCH_TimeoutID id;             /* ID to allow client to delete
                                    timeout */
   SCH_TimeoutClass class;       /* The class that the epoch is in */
   SCH_TimeoutHandler handler;   /* The handler routine to use */
   SCH_ArbitraryArgument arg;    /* The argument to pass to the handler */
+  unsigned int heap_index;      /* Position of the entry in the heap */
+  struct _TimerQueueEntry *next; /* Link in the free list */
 
 } TimerQueueEntry;
 
-/* The timer queue.  We only use the next and prev entries of this
-   record, these chain to the real entries. */
-static TimerQueueEntry timer_queue;
+/* The timer queue is a 4-ary min-heap of pointers to the entries, ordered
+   by their expiry time and sequence number */
+#define HEAP_ARITY 4
+
+static ARR_Instance timer_heap;
 static unsigned long n_timer_queue_entries;
 static SCH_TimeoutID next_tqe_id;
+static uint64_t next_tqe_seq;
+
+/* Hash table with linear probing indexing the entries by their ID */
+static TimerQueueEntry **tqe_index;
+static unsigned int tqe_index_size;
+
+#define MIN_TQE_INDEX_SIZE 64
+
+/* Entries of each class sorted by their expiry time to find the
+   separation of new timeouts */
+static ARR_Instance class_queues[SCH_NumberOfClasses];
 
 /* Pointer to head of free list */
 static TimerQueueEntry *tqe_free_list;
@@ -126,15 +153,27 @@ handle_slew(struct timespec *raw,
 void
 SCH_Initialise(void)
 {
+  int i;
+
   file_handlers = ARR_CreateInstance(sizeof (FileHandlerEntry));
 
+#ifdef HAVE_EPOLL
+  epoll_fd = -1;
+  n_polled_fds = 0;
+#endif
+
+  timer_heap = ARR_CreateInstance(sizeof (TimerQueueEntry *));
   n_timer_queue_entries = 0;
   next_tqe_id = 0;
+  next_tqe_seq = 0;
+  tqe_index_size = MIN_TQE_INDEX_SIZE;
+  tqe_index = MallocArray(TimerQueueEntry *, tqe_index_size);
+  memset(tqe_index, 0, sizeof (TimerQueueEntry *) * tqe_index_size);
   tqe_free_list = NULL;
   tqe_blocks = ARR_CreateInstance(sizeof (TimerQueueEntry *));
 
-  timer_queue.next = &timer_queue;
-  timer_queue.prev = &timer_queue;
+  for (i = 0; i < SCH_NumberOfClasses; i++)
+    class_queues[i] = ARR_CreateInstance(sizeof (TimerQueueEntry *));
 
   need_to_exit = 0;
 
@@ -157,8 +196,16 @@ SCH_Finalise(void) {
 
   ARR_DestroyInstance(file_handlers);
 
-  timer_queue.next = &timer_queue;
-  timer_queue.prev = &timer_queue;
+#ifdef HAVE_EPOLL
+  if (epoll_fd >= 0)
+    close(epoll_fd);
+  epoll_fd = -1;
+#endif
+
+  ARR_DestroyInstance(timer_heap);
+  Free(tqe_index);
+  for (i = 0; i < SCH_NumberOfClasses; i++)
+    ARR_DestroyInstance(class_queues[i]);
   for (i = 0; i < ARR_GetSize(tqe_blocks); i++)
     Free(*(TimerQueueEntry **)ARR_GetElement(tqe_blocks, i));
   ARR_DestroyInstance(tqe_blocks);
@@ -170,6 +217,74 @@ SCH_Finalise(void) {
 
 /* ================================================== */
 
+#ifdef HAVE_EPOLL
+
+static void
+control_epoll(int op, int fd, int events)
+{
+  struct epoll_event event;
+
+  memset(&event, 0, sizeof (event));
+  event.events = (events & SCH_FILE_INPUT ? EPOLLIN : 0) |
+                 (events & SCH_FILE_OUTPUT ? EPOLLOUT : 0) |
+                 (events & SCH_FILE_EXCEPTION ? EPOLLPRI : 0);
+  event.data.fd = fd;
+
+  if (epoll_ctl(epoll_fd, op, fd, &event) < 0)
+    LOG_FATAL("epoll_ctl() failed : %s", strerror(errno));
+}
+
+/* ================================================== */
+
+static void
+update_epoll(int fd, int old_events, int new_events)
+{
+  int old_polled, new_polled;
+
+  old_polled = (old_events & (SCH_FILE_INPUT | SCH_FILE_OUTPUT)) != 0;
+  new_polled = (new_events & (SCH_FILE_INPUT | SCH_FILE_OUTPUT)) != 0;
+  n_polled_fds += new_polled - old_polled;
+
+  if (epoll_fd < 0 || old_events == new_events)
+    return;
+
+  /* Errors and hangups are always reported by epoll, the descriptor needs to
+     be removed when not waiting for any events */
+  if (!new_events)
+    control_epoll(EPOLL_CTL_DEL, fd, 0);
+  else if (!old_events)
+    control_epoll(EPOLL_CTL_ADD, fd, new_events);
+  else
+    control_epoll(EPOLL_CTL_MOD, fd, new_events);
+}
+
+/* ================================================== */
+
+static void
+open_epoll(void)
+{
+  FileHandlerEntry *ptr;
+  int fd;
+
+  if (epoll_fd >= 0)
+    return;
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0)
+    LOG_FATAL("epoll_create1() failed : %s", strerror(errno));
+
+  /* Register descriptors added before the main loop */
+  for (fd = 0; fd < ARR_GetSize(file_handlers); fd++) {
+    ptr = ARR_GetElement(file_handlers, fd);
+    if (ptr->events)
+      control_epoll(EPOLL_CTL_ADD, fd, ptr->events);
+  }
+}
+
+#endif
+
+/* ================================================== */
+
 void
 SCH_AddFileHandler
 (int fd, int events, SCH_FileHandler handler, SCH_ArbitraryArgument arg)
@@ -179,9 +294,11 @@ SCH_AddFileHandler
   assert(initialised);
   assert(events);
   assert(fd >= 0);
-  
+
+#ifndef HAVE_EPOLL
   if (fd >= FD_SETSIZE)
     LOG_FATAL("Too many file descriptors");
+#endif
 
   /* Resize the array if the descriptor is highest so far */
   while (ARR_GetSize(file_handlers) <= fd) {
@@ -202,6 +319,10 @@ SCH_AddFileHandler
   ptr->arg = arg;
   ptr->events = events;
 
+#ifdef HAVE_EPOLL
+  update_epoll(fd, 0, events);
+#endif
+
   if (one_highest_fd < fd + 1)
     one_highest_fd = fd + 1;
 }
@@ -221,6 +342,10 @@ SCH_RemoveFileHandler(int fd)
   /* Check that a handler was registered for the fd in question */
   assert(ptr->handler);
 
+#ifdef HAVE_EPOLL
+  update_epoll(fd, ptr->events, 0);
+#endif
+
   ptr->handler = NULL;
   ptr->arg = NULL;
   ptr->events = 0;
@@ -240,13 +365,20 @@ void
 SCH_SetFileHandlerEvent(int fd, int event, int enable)
 {
   FileHandlerEntry *ptr;
+  int events;
 
   ptr = ARR_GetElement(file_handlers, fd);
 
   if (enable)
-    ptr->events |= event;
+    events = ptr->events | event;
   else
-    ptr->events &= ~event;
+    events = ptr->events & ~event;
+
+#ifdef HAVE_EPOLL
+  update_epoll(fd, ptr->events, events);
+#endif
+
+  ptr->events = events;
 }
 
 /* ================================================== */
@@ -307,33 +439,268 @@ release_tqe(TimerQueueEntry *node)
 
 /* ================================================== */
 
+static int
+is_tqe_earlier(TimerQueueEntry *tqe1, TimerQueueEntry *tqe2)
+{
+  int r;
+
+  r = UTI_CompareTimespecs(&tqe1->ts, &tqe2->ts);
+  return r < 0 || (r == 0 && tqe1->seq < tqe2->seq);
+}
+
+/* ================================================== */
+
+static int
+compare_tqes(const void *a, const void *b)
+{
+  TimerQueueEntry *tqe1 = *(TimerQueueEntry **)a, *tqe2 = *(TimerQueueEntry **)b;
+
+  return is_tqe_earlier(tqe1, tqe2) ? -1 : is_tqe_earlier(tqe2, tqe1);
+}
+
+/* ================================================== */
+
+static void
+set_heap_entry(TimerQueueEntry **heap, unsigned int index, TimerQueueEntry *tqe)
+{
+  heap[index] = tqe;
+  tqe->heap_index = index;
+}
+
+/* ================================================== */
+
+static void
+sift_heap_up(unsigned int index)
+{
+  TimerQueueEntry **heap, *tqe;
+  unsigned int parent;
+
+  heap = ARR_GetElements(timer_heap);
+  tqe = heap[index];
+
+  while (index > 0) {
+    parent = (index - 1) / HEAP_ARITY;
+    if (!is_tqe_earlier(tqe, heap[parent]))
+      break;
+    set_heap_entry(heap, index, heap[parent]);
+    index = parent;
+  }
+
+  set_heap_entry(heap, index, tqe);
+}
+
+/* ================================================== */
+
+static void
+sift_heap_down(unsigned int index)
+{
+  unsigned int i, n, child, first_child;
+  TimerQueueEntry **heap, *tqe;
+
+  heap = ARR_GetElements(timer_heap);
+  n = ARR_GetSize(timer_heap);
+  tqe = heap[index];
+
+  while (1) {
+    first_child = HEAP_ARITY * index + 1;
+    if (first_child >= n)
+      break;
+
+    for (i = first_child + 1, child = first_child;
+         i < first_child + HEAP_ARITY && i < n; i++) {
+      if (is_tqe_earlier(heap[i], heap[child]))
+        child = i;
+    }
+
+    if (!is_tqe_earlier(heap[child], tqe))
+      break;
+
+    set_heap_entry(heap, index, heap[child]);
+    index = child;
+  }
+
+  set_heap_entry(heap, index, tqe);
+}
+
+/* ================================================== */
+
+static void
+rebuild_heap(void)
+{
+  unsigned int i, n;
+
+  n = ARR_GetSize(timer_heap);
+  if (n < 2)
+    return;
+
+  /* Sift down all parents starting from the last one */
+  for (i = (n - 2) / HEAP_ARITY + 1; i > 0; i--)
+    sift_heap_down(i - 1);
+}
+
+/* ================================================== */
+
+static unsigned int
+get_tqe_index_slot(SCH_TimeoutID id)
+{
+  unsigned int slot;
+
+  /* The IDs are mostly sequential, no hashing is needed */
+  for (slot = id & (tqe_index_size - 1); tqe_index[slot];
+       slot = (slot + 1) & (tqe_index_size - 1)) {
+    if (tqe_index[slot]->id == id)
+      break;
+  }
+
+  return slot;
+}
+
+/* ================================================== */
+
+static void
+resize_tqe_index(unsigned int size)
+{
+  TimerQueueEntry **old_index;
+  unsigned int i, old_size;
+
+  old_index = tqe_index;
+  old_size = tqe_index_size;
+
+  tqe_index_size = size;
+  tqe_index = MallocArray(TimerQueueEntry *, tqe_index_size);
+  memset(tqe_index, 0, sizeof (TimerQueueEntry *) * tqe_index_size);
+
+  for (i = 0; i < old_size; i++) {
+    if (old_index[i])
+      tqe_index[get_tqe_index_slot(old_index[i]->id)] = old_index[i];
+  }
+
+  Free(old_index);
+}
+
+/* ================================================== */
+
+static TimerQueueEntry *
+find_tqe(SCH_TimeoutID id)
+{
+  return tqe_index[get_tqe_index_slot(id)];
+}
+
+/* ================================================== */
+
+static void
+add_tqe_to_index(TimerQueueEntry *tqe)
+{
+  /* Keep the load factor below 1/2 */
+  if (2 * (n_timer_queue_entries + 1) > tqe_index_size)
+    resize_tqe_index(2 * tqe_index_size);
+
+  tqe_index[get_tqe_index_slot(tqe->id)] = tqe;
+}
+
+/* ================================================== */
+
+static void
+remove_tqe_from_index(TimerQueueEntry *tqe)
+{
+  unsigned int slot, next_slot, home_slot, mask;
+
+  mask = tqe_index_size - 1;
+  slot = get_tqe_index_slot(tqe->id);
+  assert(tqe_index[slot] == tqe);
+
+  /* Shift following entries back to fill the hole without tombstones */
+  for (next_slot = (slot + 1) & mask; tqe_index[next_slot];
+       next_slot = (next_slot + 1) & mask) {
+    home_slot = tqe_index[next_slot]->id & mask;
+    if (((next_slot - home_slot) & mask) < ((next_slot - slot) & mask))
+      continue;
+    tqe_index[slot] = tqe_index[next_slot];
+    slot = next_slot;
+  }
+
+  tqe_index[slot] = NULL;
+}
+
+/* ================================================== */
+
+/* Get the position of the first entry in a sorted class queue which is not
+   earlier than the specified entry */
+
+static unsigned int
+find_class_position(ARR_Instance queue, TimerQueueEntry *tqe)
+{
+  TimerQueueEntry **tqes;
+  unsigned int lo, hi, mid;
+
+  tqes = ARR_GetElements(queue);
+
+  for (lo = 0, hi = ARR_GetSize(queue); lo < hi; ) {
+    mid = lo + (hi - lo) / 2;
+    if (is_tqe_earlier(tqes[mid], tqe))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* ================================================== */
+
+static void
+add_tqe_to_class(TimerQueueEntry *tqe)
+{
+  ARR_Instance queue = class_queues[tqe->class];
+  TimerQueueEntry **tqes;
+  unsigned int pos, n;
+
+  pos = find_class_position(queue, tqe);
+  ARR_GetNewElement(queue);
+
+  n = ARR_GetSize(queue);
+  tqes = ARR_GetElements(queue);
+  memmove(tqes + pos + 1, tqes + pos, sizeof (tqes[0]) * (n - pos - 1));
+  tqes[pos] = tqe;
+}
+
+/* ================================================== */
+
+static void
+remove_tqe_from_class(TimerQueueEntry *tqe)
+{
+  ARR_Instance queue = class_queues[tqe->class];
+  unsigned int pos;
+
+  pos = find_class_position(queue, tqe);
+  assert(*(TimerQueueEntry **)ARR_GetElement(queue, pos) == tqe);
+  ARR_RemoveElement(queue, pos);
+}
+
+/* ================================================== */
+
 static SCH_TimeoutID
 get_new_tqe_id(void)
 {
-  TimerQueueEntry *ptr;
-
 try_again:
   next_tqe_id++;
   if (!next_tqe_id)
     goto try_again;
 
   /* Make sure the ID isn't already used */
-  for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next)
-    if (ptr->id == next_tqe_id)
-      goto try_again;
+  if (find_tqe(next_tqe_id))
+    goto try_again;
 
   return next_tqe_id;
 }
 
 /* ================================================== */
 
-SCH_TimeoutID
-SCH_AddTimeout(struct timespec *ts, SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
+static SCH_TimeoutID
+add_tqe(struct timespec *ts, SCH_TimeoutClass class,
+        SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
 {
   TimerQueueEntry *new_tqe;
-  TimerQueueEntry *ptr;
-
-  assert(initialised);
 
   new_tqe = allocate_tqe();
 
@@ -341,30 +708,44 @@ SCH_AddTimeout(struct timespec *ts, SCH_TimeoutHandler handler, SCH_ArbitraryArg
   new_tqe->handler = handler;
   new_tqe->arg = arg;
   new_tqe->ts = *ts;
-  new_tqe->class = SCH_ReservedTimeoutValue;
+  new_tqe->class = class;
 
-  /* Now work out where to insert the new entry in the list */
-  for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
-    if (UTI_CompareTimespecs(&new_tqe->ts, &ptr->ts) == -1) {
-      /* If the new entry comes before the current pointer location in
-         the list, we want to insert the new entry just before ptr. */
-      break;
-    }
-  }
+  /* Timeouts expiring at the same time are dispatched in the order
+     in which they were added */
+  new_tqe->seq = next_tqe_seq++;
+
+  add_tqe_to_index(new_tqe);
 
-  /* At this stage, we want to insert the new entry immediately before
-     the entry identified by 'ptr' */
+  *(TimerQueueEntry **)ARR_GetNewElement(timer_heap) = new_tqe;
+  sift_heap_up(ARR_GetSize(timer_heap) - 1);
 
-  new_tqe->next = ptr;
-  new_tqe->prev = ptr->prev;
-  ptr->prev->next = new_tqe;
-  ptr->prev = new_tqe;
+  if (class != SCH_ReservedTimeoutValue)
+    add_tqe_to_class(new_tqe);
 
   n_timer_queue_entries++;
 
   return new_tqe->id;
 }
 
+/* ================================================== */
+
+static TimerQueueEntry *
+get_first_tqe(void)
+{
+  assert(n_timer_queue_entries > 0);
+  return *(TimerQueueEntry **)ARR_GetElement(timer_heap, 0);
+}
+
+/* ================================================== */
+
+SCH_TimeoutID
+SCH_AddTimeout(struct timespec *ts, SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
+{
+  assert(initialised);
+
+  return add_tqe(ts, SCH_ReservedTimeoutValue, handler, arg);
+}
+
 /* ================================================== */
 /* This queues a timeout to elapse at a given delta time relative to
    the current (raw) time */
@@ -389,16 +770,65 @@ SCH_AddTimeoutByDelay(double delay, SCH_TimeoutHandler handler, SCH_ArbitraryArg
 
 /* ================================================== */
 
+static double
+get_class_delay(struct timespec *now, double min_delay, double separation,
+                SCH_TimeoutClass class)
+{
+  TimerQueueEntry **tqes;
+  unsigned int i, n, lo, hi, mid;
+  double diff, new_min_delay;
+
+  new_min_delay = min_delay;
+
+  /* Check the separation from the last dispatched timeout */
+  diff = UTI_DiffTimespecsToDouble(now, &last_class_dispatch[class]);
+  if (diff < separation && diff >= 0.0 && diff + new_min_delay < separation) {
+    new_min_delay = separation - diff;
+  }
+
+  tqes = ARR_GetElements(class_queues[class]);
+  n = ARR_GetSize(class_queues[class]);
+
+  /* Skip entries in the same class which are already at least the separation
+     before the new timeout */
+  for (lo = 0, hi = n; lo < hi; ) {
+    mid = lo + (hi - lo) / 2;
+    if (new_min_delay - UTI_DiffTimespecsToDouble(&tqes[mid]->ts, now) >= separation)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  /* Scan through the remaining entries and increase min_delay if necessary
+     to keep at least the separation away */
+  for (i = lo; i < n; i++) {
+    diff = UTI_DiffTimespecsToDouble(&tqes[i]->ts, now);
+    if (new_min_delay > diff) {
+      if (new_min_delay - diff < separation) {
+        new_min_delay = diff + separation;
+      }
+    } else {
+      if (diff - new_min_delay < separation) {
+        new_min_delay = diff + separation;
+      } else {
+        /* Later entries cannot be closer */
+        break;
+      }
+    }
+  }
+
+  return new_min_delay;
+}
+
+/* ================================================== */
+
 SCH_TimeoutID
 SCH_AddTimeoutInClass(double min_delay, double separation, double randomness,
                       SCH_TimeoutClass class,
                       SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
 {
-  TimerQueueEntry *new_tqe;
-  TimerQueueEntry *ptr;
-  struct timespec now;
-  double diff, r;
-  double new_min_delay;
+  struct timespec now, ts;
+  double r;
 
   assert(initialised);
   assert(min_delay >= 0.0);
@@ -414,54 +844,10 @@ SCH_AddTimeoutInClass(double min_delay, double separation, double randomness,
   }
   
   LCL_ReadRawTime(&now);
-  new_min_delay = min_delay;
 
-  /* Check the separation from the last dispatched timeout */
-  diff = UTI_DiffTimespecsToDouble(&now, &last_class_dispatch[class]);
-  if (diff < separation && diff >= 0.0 && diff + new_min_delay < separation) {
-    new_min_delay = separation - diff;
-  }
+  UTI_AddDoubleToTimespec(&now, get_class_delay(&now, min_delay, separation, class), &ts);
 
-  /* Scan through list for entries in the same class and increase min_delay
-     if necessary to keep at least the separation away */
-  for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
-    if (ptr->class == class) {
-      diff = UTI_DiffTimespecsToDouble(&ptr->ts, &now);
-      if (new_min_delay > diff) {
-        if (new_min_delay - diff < separation) {
-          new_min_delay = diff + separation;
-        }
-      } else {
-        if (diff - new_min_delay < separation) {
-          new_min_delay = diff + separation;
-        }
-      }
-    }
-  }
-
-  for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
-    diff = UTI_DiffTimespecsToDouble(&ptr->ts, &now);
-    if (diff > new_min_delay) {
-      break;
-    }
-  }
-
-  /* We have located the insertion point */
-  new_tqe = allocate_tqe();
-
-  new_tqe->id = get_new_tqe_id();
-  new_tqe->handler = handler;
-  new_tqe->arg = arg;
-  UTI_AddDoubleToTimespec(&now, new_min_delay, &new_tqe->ts);
-  new_tqe->class = class;
-
-  new_tqe->next = ptr;
-  new_tqe->prev = ptr->prev;
-  ptr->prev->next = new_tqe;
-  ptr->prev = new_tqe;
-  n_timer_queue_entries++;
-
-  return new_tqe->id;
+  return add_tqe(&ts, class, handler, arg);
 }
 
 /* ================================================== */
@@ -469,34 +855,44 @@ SCH_AddTimeoutInClass(double min_delay, double separation, double randomness,
 void
 SCH_RemoveTimeout(SCH_TimeoutID id)
 {
-  TimerQueueEntry *ptr;
+  TimerQueueEntry *ptr, *last, **heap;
+  unsigned int index;
 
   assert(initialised);
 
   if (!id)
     return;
 
-  for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
-
-    if (ptr->id == id) {
-      /* Found the required entry */
-      
-      /* Unlink from the queue */
-      ptr->next->prev = ptr->prev;
-      ptr->prev->next = ptr->next;
-      
-      /* Decrement entry count */
-      --n_timer_queue_entries;
-      
-      /* Release memory back to the operating system */
-      release_tqe(ptr);
-
-      return;
-    }
-  }
+  ptr = find_tqe(id);
 
   /* Catch calls with invalid non-zero ID */
-  assert(0);
+  assert(ptr);
+
+  remove_tqe_from_index(ptr);
+
+  if (ptr->class != SCH_ReservedTimeoutValue)
+    remove_tqe_from_class(ptr);
+
+  /* Replace the entry in the heap with the last entry */
+  index = ptr->heap_index;
+  heap = ARR_GetElements(timer_heap);
+  last = heap[ARR_GetSize(timer_heap) - 1];
+  ARR_SetSize(timer_heap, ARR_GetSize(timer_heap) - 1);
+
+  if (last != ptr) {
+    heap = ARR_GetElements(timer_heap);
+    set_heap_entry(heap, index, last);
+    if (index > 0 && is_tqe_earlier(last, heap[(index - 1) / HEAP_ARITY]))
+      sift_heap_up(index);
+    else
+      sift_heap_down(index);
+  }
+
+  /* Decrement entry count */
+  --n_timer_queue_entries;
+
+  /* Release memory back to the operating system */
+  release_tqe(ptr);
 }
 
 /* ================================================== */
@@ -519,11 +915,11 @@ dispatch_timeouts(struct timespec *now) {
     LCL_ReadRawTime(now);
 
     if (!(n_timer_queue_entries > 0 &&
-          UTI_CompareTimespecs(now, &timer_queue.next->ts) >= 0)) {
+          UTI_CompareTimespecs(now, &get_first_tqe()->ts) >= 0)) {
       break;
     }
 
-    ptr = timer_queue.next;
+    ptr = get_first_tqe();
 
     last_class_dispatch[ptr->class] = *now;
 
@@ -557,6 +953,42 @@ dispatch_timeouts(struct timespec *now) {
 
 /* ================================================== */
 
+#ifdef HAVE_EPOLL
+
+static void
+dispatch_filehandlers(struct epoll_event *events, int n_events)
+{
+  FileHandlerEntry *ptr;
+  int i, fd, input, output;
+
+  for (i = 0; i < n_events; i++) {
+    fd = events[i].data.fd;
+
+    /* Follow the select() semantics, i.e. errors and hangups are reported
+       as input or output, and input is not dispatched after exception */
+    input = events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP);
+    output = events[i].events & (EPOLLOUT | EPOLLERR);
+
+    ptr = ARR_GetElement(file_handlers, fd);
+    if (events[i].events & EPOLLPRI && ptr->events & SCH_FILE_EXCEPTION) {
+      if (ptr->handler)
+        (ptr->handler)(fd, SCH_FILE_EXCEPTION, ptr->arg);
+      input = 0;
+    }
+
+    /* The handlers may remove the descriptor or modify its events */
+    ptr = ARR_GetElement(file_handlers, fd);
+    if (input && ptr->events & SCH_FILE_INPUT && ptr->handler)
+      (ptr->handler)(fd, SCH_FILE_INPUT, ptr->arg);
+
+    ptr = ARR_GetElement(file_handlers, fd);
+    if (output && ptr->events & SCH_FILE_OUTPUT && ptr->handler)
+      (ptr->handler)(fd, SCH_FILE_OUTPUT, ptr->arg);
+  }
+}
+
+#else
+
 /* nfd is the number of bits set in all fd_sets */
 
 static void
@@ -598,6 +1030,8 @@ dispatch_filehandlers(int nfd, fd_set *read_fds, fd_set *write_fds, fd_set *exce
   }
 }
 
+#endif
+
 /* ================================================== */
 
 static void
@@ -608,7 +1042,8 @@ handle_slew(struct timespec *raw,
             LCL_ChangeType change_type,
             void *anything)
 {
-  TimerQueueEntry *ptr;
+  TimerQueueEntry **heap;
+  unsigned int j;
   double delta;
   int i;
 
@@ -618,9 +1053,18 @@ handle_slew(struct timespec *raw,
     assert(LCL_IsFirstParameterChangeHandler(handle_slew));
 
     /* If a step change occurs, just shift all raw time stamps by the offset */
-    
-    for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
-      UTI_AddDoubleToTimespec(&ptr->ts, -doffset, &ptr->ts);
+
+    heap = ARR_GetElements(timer_heap);
+    for (j = 0; j < ARR_GetSize(timer_heap); j++) {
+      UTI_AddDoubleToTimespec(&heap[j]->ts, -doffset, &heap[j]->ts);
+    }
+
+    /* Rounding in the shift might have made some timestamps equal, which
+       could break the ordering by sequence number */
+    rebuild_heap();
+    for (i = 0; i < SCH_NumberOfClasses; i++) {
+      qsort(ARR_GetElements(class_queues[i]), ARR_GetSize(class_queues[i]),
+            sizeof (TimerQueueEntry *), compare_tqes);
     }
 
     for (i = 0; i < SCH_NumberOfClasses; i++) {
@@ -635,6 +1079,8 @@ handle_slew(struct timespec *raw,
 
 /* ================================================== */
 
+#ifndef HAVE_EPOLL
+
 static void
 fill_fd_sets(fd_set **read_fds, fd_set **write_fds, fd_set **except_fds)
 {
@@ -685,17 +1131,29 @@ fill_fd_sets(fd_set **read_fds, fd_set **write_fds, fd_set **except_fds)
     *except_fds = NULL;
 }
 
+#endif
+
 /* ================================================== */
 
 #define JUMP_DETECT_THRESHOLD 10
 
-static int
-check_current_time(struct timespec *prev_raw, struct timespec *raw, int timeout,
-                   struct timeval *orig_select_tv,
-                   struct timeval *rem_select_tv)
+#ifdef HAVE_EPOLL
+
+static void
+read_monotonic_time(struct timespec *ts)
 {
-  struct timespec elapsed_min, elapsed_max, orig_select_ts, rem_select_ts;
-  double step, elapsed;
+  if (clock_gettime(CLOCK_MONOTONIC, ts) < 0)
+    LOG_FATAL("clock_gettime() failed : %s", strerror(errno));
+}
+
+#else
+
+static void
+get_select_elapsed(struct timespec *prev_raw, struct timespec *raw, int timeout,
+                   struct timeval *orig_select_tv, struct timeval *rem_select_tv,
+                   struct timespec *elapsed_min, struct timespec *elapsed_max)
+{
+  struct timespec orig_select_ts, rem_select_ts;
 
   UTI_TimevalToTimespec(orig_select_tv, &orig_select_ts);
 
@@ -703,26 +1161,37 @@ check_current_time(struct timespec *prev_raw, struct timespec *raw, int timeout,
      systems (e.g. Linux) the timeout timeval is modified to return the
      remaining time, use that information. */
   if (timeout) {
-    elapsed_max = elapsed_min = orig_select_ts;
+    *elapsed_max = *elapsed_min = orig_select_ts;
   } else if (rem_select_tv && rem_select_tv->tv_sec >= 0 &&
              rem_select_tv->tv_sec <= orig_select_tv->tv_sec &&
              (rem_select_tv->tv_sec != orig_select_tv->tv_sec ||
               rem_select_tv->tv_usec != orig_select_tv->tv_usec)) {
     UTI_TimevalToTimespec(rem_select_tv, &rem_select_ts);
-    UTI_DiffTimespecs(&elapsed_min, &orig_select_ts, &rem_select_ts);
-    elapsed_max = elapsed_min;
+    UTI_DiffTimespecs(elapsed_min, &orig_select_ts, &rem_select_ts);
+    *elapsed_max = *elapsed_min;
   } else {
     if (rem_select_tv)
-      elapsed_max = orig_select_ts;
+      *elapsed_max = orig_select_ts;
     else
-      UTI_DiffTimespecs(&elapsed_max, raw, prev_raw);
-    UTI_ZeroTimespec(&elapsed_min);
+      UTI_DiffTimespecs(elapsed_max, raw, prev_raw);
+    UTI_ZeroTimespec(elapsed_min);
   }
+}
+
+#endif
+
+/* ================================================== */
 
-  if (last_select_ts_raw.tv_sec + elapsed_min.tv_sec >
+static int
+check_current_time(struct timespec *prev_raw, struct timespec *raw,
+                   struct timespec *elapsed_min, struct timespec *elapsed_max)
+{
+  double step, elapsed;
+
+  if (last_select_ts_raw.tv_sec + elapsed_min->tv_sec >
       raw->tv_sec + JUMP_DETECT_THRESHOLD) {
     LOG(LOGS_WARN, "Backward time jump detected!");
-  } else if (prev_raw->tv_sec + elapsed_max.tv_sec + JUMP_DETECT_THRESHOLD <
+  } else if (prev_raw->tv_sec + elapsed_max->tv_sec + JUMP_DETECT_THRESHOLD <
              raw->tv_sec) {
     LOG(LOGS_WARN, "Forward time jump detected!");
   } else {
@@ -730,7 +1199,7 @@ check_current_time(struct timespec *prev_raw, struct timespec *raw, int timeout,
   }
 
   step = UTI_DiffTimespecsToDouble(&last_select_ts_raw, raw);
-  elapsed = UTI_TimespecToDouble(&elapsed_min);
+  elapsed = UTI_TimespecToDouble(elapsed_min);
   step += elapsed;
 
   /* Cooked time may no longer be valid after dispatching the handlers */
@@ -769,15 +1238,25 @@ update_monotonic_time(struct timespec *now, struct timespec *before)
 void
 SCH_MainLoop(void)
 {
+#ifdef HAVE_EPOLL
+  struct epoll_event events[MAX_EPOLL_EVENTS];
+  struct timespec mono_before, mono_after;
+  int epoll_timeout;
+#else
   fd_set read_fds, write_fds, except_fds;
   fd_set *p_read_fds, *p_write_fds, *p_except_fds;
-  int status, errsv;
   struct timeval tv, saved_tv, *ptv;
-  struct timespec ts, now, saved_now, cooked;
+#endif
+  int status, errsv, has_timeout;
+  struct timespec ts, now, saved_now, cooked, elapsed_min, elapsed_max;
   double err;
 
   assert(initialised);
 
+#ifdef HAVE_EPOLL
+  open_epoll();
+#endif
+
   while (!need_to_exit) {
     /* Dispatch timeouts and fill now with current raw time */
     dispatch_timeouts(&now);
@@ -788,10 +1267,34 @@ SCH_MainLoop(void)
       break;
 
     /* Check whether there is a timeout and set it up */
-    if (n_timer_queue_entries > 0) {
-      UTI_DiffTimespecs(&ts, &timer_queue.next->ts, &now);
+    has_timeout = n_timer_queue_entries > 0;
+    if (has_timeout) {
+      UTI_DiffTimespecs(&ts, &get_first_tqe()->ts, &now);
       assert(ts.tv_sec > 0 || ts.tv_nsec > 0);
+    }
+
+#ifdef HAVE_EPOLL
+    /* if there are no file descriptors being waited on and no
+       timeout set, this is clearly ridiculous, so stop the run */
+    if (!has_timeout && n_polled_fds == 0)
+      LOG_FATAL("Nothing to do");
 
+    /* Round the timeout up to milliseconds to not wake up too early */
+    if (!has_timeout)
+      epoll_timeout = -1;
+    else if (ts.tv_sec >= INT_MAX / 1000 - 1)
+      epoll_timeout = INT_MAX;
+    else
+      epoll_timeout = ts.tv_sec * 1000 + (ts.tv_nsec + 999999) / 1000000;
+
+    /* There is no remaining timeout returned by epoll_wait().  Measure the
+       elapsed time with the monotonic clock for the jump detection. */
+    read_monotonic_time(&mono_before);
+    status = epoll_wait(epoll_fd, events, MAX_EPOLL_EVENTS, epoll_timeout);
+    errsv = errno;
+    read_monotonic_time(&mono_after);
+#else
+    if (has_timeout) {
       UTI_TimespecToTimeval(&ts, &tv);
       ptv = &tv;
       saved_tv = tv;
@@ -812,14 +1315,23 @@ SCH_MainLoop(void)
 
     status = select(one_highest_fd, p_read_fds, p_write_fds, p_except_fds, ptv);
     errsv = errno;
+#endif
 
     LCL_ReadRawTime(&now);
     LCL_CookTime(&now, &cooked, &err);
 
     update_monotonic_time(&now, &last_select_ts_raw);
 
+#ifdef HAVE_EPOLL
+    UTI_DiffTimespecs(&elapsed_min, &mono_after, &mono_before);
+    elapsed_max = elapsed_min;
+#else
+    get_select_elapsed(&saved_now, &now, status == 0, &saved_tv, ptv,
+                       &elapsed_min, &elapsed_max);
+#endif
+
     /* Check if the time didn't jump unexpectedly */
-    if (!check_current_time(&saved_now, &now, status == 0, &saved_tv, ptv)) {
+    if (!check_current_time(&saved_now, &now, &elapsed_min, &elapsed_max)) {
       /* Cook the time again after handling the step */
       LCL_CookTime(&now, &cooked, &err);
     }
@@ -830,15 +1342,22 @@ SCH_MainLoop(void)
 
     if (status < 0) {
       if (!need_to_exit && errsv != EINTR) {
+#ifdef HAVE_EPOLL
+        LOG_FATAL("epoll_wait() failed : %s", strerror(errsv));
+#else
         LOG_FATAL("select() failed : %s", strerror(errsv));
+#endif
       }
     } else if (status > 0) {
       /* A file descriptor is ready for input or output */
+#ifdef HAVE_EPOLL
+      dispatch_filehandlers(events, status);
+#else
       dispatch_filehandlers(status, p_read_fds, p_write_fds, p_except_fds);
+#endif
     } else {
-      /* No descriptors readable, timeout must have elapsed.
-       Therefore, tv must be non-null */
-      assert(ptv);
+      /* No descriptors readable, timeout must have elapsed */
+      assert(has_timeout);
 
       /* There's nothing to do here, since the timeouts
          will be dispatched at the top of the next loop
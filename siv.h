@@ -60,12 +60,27 @@ extern int SIV_GetMaxNonceLength(SIV_Instance instance);
 
 extern int SIV_GetTagLength(SIV_Instance instance);
 
+/* Get the offset of plaintext in the ciphertext buffer which allows the
+   plaintext to be encrypted in place (i.e. the plaintext pointer passed to
+   SIV_Encrypt() points into the ciphertext buffer), or -1 if in-place
+   encryption is not supported */
+extern int SIV_GetInPlaceOffset(SIV_Instance instance);
+
 extern int SIV_Encrypt(SIV_Instance instance,
                        const unsigned char *nonce, int nonce_length,
                        const void *assoc, int assoc_length,
                        const void *plaintext, int plaintext_length,
                        unsigned char *ciphertext, int ciphertext_length);
 
+/* Encrypt the same plaintext with multiple nonces (e.g. to generate
+   cookies).  The ciphertext buffers must not overlap with the plaintext.
+   Some implementations encrypt the messages in parallel. */
+extern int SIV_EncryptMultiple(SIV_Instance instance, int n,
+                               const unsigned char *const *nonces, int nonce_length,
+                               const void *assoc, int assoc_length,
+                               const void *plaintext, int plaintext_length,
+                               unsigned char *const *ciphertexts, int ciphertext_length);
+
 extern int SIV_Decrypt(SIV_Instance instance,
                        const unsigned char *nonce, int nonce_length,
                        const void *assoc, int assoc_length,
@@ -0,0 +1,525 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+
+  =======================================================================
+
+  AES-128-GCM-SIV (RFC 8452) using the x86 AES-NI, PCLMULQDQ, and SSSE3
+  instructions.  The functions are compiled for the instructions, but they
+  can be called only if SIVA_IsSupported() returned true, i.e. the CPU
+  was checked at run time.  The SIV backends use this implementation
+  instead of the crypto library if it is supported.
+  */
+
+#include "config.h"
+
+#include "sysincl.h"
+
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#include "siv_aesni.h"
+
+#define TARGET __attribute__((target("sse2,ssse3,aes,pclmul")))
+
+/* Number of messages encrypted with interleaved instructions */
+#define GROUP_SIZE 4
+
+/* Loops over interleaved blocks need to be fully unrolled to keep the blocks
+   in registers, which is not done at the default optimisation level */
+#define UNROLL _Pragma("GCC unroll 16")
+
+/* ================================================== */
+
+int
+SIVA_IsSupported(void)
+{
+  __builtin_cpu_init();
+
+  return __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("aes") &&
+         __builtin_cpu_supports("pclmul");
+}
+
+/* ================================================== */
+
+/* Round constants of the key expansion */
+static const int rcons[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+/* Get the next round key.  SubWord(RotWord()) of the last word is computed
+   by AESENCLAST (with the word copied to all columns, ShiftRows has no
+   effect), which is faster than AESKEYGENASSIST and doesn't need the round
+   constant to be an immediate value. */
+static inline TARGET __m128i
+expand_key_step(__m128i key, __m128i rcon)
+{
+  __m128i t;
+
+  t = _mm_aesenclast_si128(_mm_shuffle_epi8(key, _mm_set1_epi32(0x0c0f0e0d)), rcon);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, t);
+}
+
+static TARGET void
+expand_key(__m128i key, __m128i *rk)
+{
+  int i;
+
+  rk[0] = key;
+  for (i = 1; i < 11; i++)
+    rk[i] = expand_key_step(rk[i - 1], _mm_set1_epi32(rcons[i - 1]));
+}
+
+/* ================================================== */
+
+/* Expand independent keys with interleaved steps.  The first round key
+   of each key is the raw key. */
+static inline TARGET void
+expand_keys(__m128i (*rks)[11], int n)
+{
+  __m128i rcon;
+  int i, j;
+
+  UNROLL
+  for (i = 1; i < 11; i++) {
+    rcon = _mm_set1_epi32(rcons[i - 1]);
+    UNROLL
+    for (j = 0; j < n; j++)
+      rks[j][i] = expand_key_step(rks[j][i - 1], rcon);
+  }
+}
+
+/* ================================================== */
+
+static inline TARGET __m128i
+encrypt_block(const __m128i *rk, __m128i x)
+{
+  int i;
+
+  x = _mm_xor_si128(x, rk[0]);
+  for (i = 1; i < 10; i++)
+    x = _mm_aesenc_si128(x, rk[i]);
+  return _mm_aesenclast_si128(x, rk[10]);
+}
+
+/* ================================================== */
+
+/* Encrypt independent blocks with interleaved rounds */
+static inline TARGET void
+encrypt_blocks(const __m128i *rk, __m128i *x, int n)
+{
+  int i, j;
+
+  UNROLL
+  for (j = 0; j < n; j++)
+    x[j] = _mm_xor_si128(x[j], rk[0]);
+  UNROLL
+  for (i = 1; i < 10; i++) {
+    UNROLL
+    for (j = 0; j < n; j++)
+      x[j] = _mm_aesenc_si128(x[j], rk[i]);
+  }
+  UNROLL
+  for (j = 0; j < n; j++)
+    x[j] = _mm_aesenclast_si128(x[j], rk[10]);
+}
+
+/* ================================================== */
+
+/* Encrypt independent blocks, each with its own key, with interleaved
+   rounds */
+static inline TARGET void
+encrypt_blocks_keys(__m128i (*rks)[11], __m128i *x, int n)
+{
+  int i, j;
+
+  UNROLL
+  for (j = 0; j < n; j++)
+    x[j] = _mm_xor_si128(x[j], rks[j][0]);
+  UNROLL
+  for (i = 1; i < 10; i++) {
+    UNROLL
+    for (j = 0; j < n; j++)
+      x[j] = _mm_aesenc_si128(x[j], rks[j][i]);
+  }
+  UNROLL
+  for (j = 0; j < n; j++)
+    x[j] = _mm_aesenclast_si128(x[j], rks[j][10]);
+}
+
+/* ================================================== */
+
+/* Multiplication in the POLYVAL field, i.e. a * b * x^-128 modulo
+   x^128 + x^127 + x^126 + x^121 + 1 */
+static inline TARGET __m128i
+polyval_mul(__m128i a, __m128i b)
+{
+  const __m128i poly = _mm_setr_epi32(0x1, 0, 0, 0xc2000000);
+  __m128i lo, hi, mid, t;
+
+  lo = _mm_clmulepi64_si128(a, b, 0x00);
+  hi = _mm_clmulepi64_si128(a, b, 0x11);
+  mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+                      _mm_clmulepi64_si128(a, b, 0x01));
+  lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+  hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+  /* Two folding steps of the Montgomery reduction */
+  t = _mm_clmulepi64_si128(lo, poly, 0x10);
+  lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 0x4e), t);
+  t = _mm_clmulepi64_si128(lo, poly, 0x10);
+  lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 0x4e), t);
+
+  return _mm_xor_si128(hi, lo);
+}
+
+/* ================================================== */
+
+static TARGET __m128i
+polyval_update(__m128i h, __m128i s, const unsigned char *data, int length)
+{
+  unsigned char block[16];
+
+  for (; length >= 16; length -= 16, data += 16)
+    s = polyval_mul(_mm_xor_si128(s, _mm_loadu_si128((const __m128i *)data)), h);
+
+  /* The last partial block is padded with zeros */
+  if (length > 0) {
+    memset(block, 0, sizeof (block));
+    memcpy(block, data, length);
+    s = polyval_mul(_mm_xor_si128(s, _mm_loadu_si128((const __m128i *)block)), h);
+  }
+
+  return s;
+}
+
+/* ================================================== */
+
+/* Update independent POLYVAL states, each with its own key, with the same
+   data */
+static inline TARGET void
+polyval_update_keys(const __m128i *h, __m128i *s, int n, const unsigned char *data,
+                    int length)
+{
+  unsigned char block[16];
+  __m128i x;
+  int i;
+
+  for (; length > 0; length -= 16, data += 16) {
+    /* The last partial block is padded with zeros */
+    if (length < 16) {
+      memset(block, 0, sizeof (block));
+      memcpy(block, data, length);
+      x = _mm_loadu_si128((const __m128i *)block);
+    } else {
+      x = _mm_loadu_si128((const __m128i *)data);
+    }
+
+    UNROLL
+    for (i = 0; i < n; i++)
+      s[i] = polyval_mul(_mm_xor_si128(s[i], x), h[i]);
+  }
+}
+
+/* ================================================== */
+
+static TARGET __m128i
+load_nonce(const unsigned char *nonce)
+{
+  unsigned char block[16];
+
+  memcpy(block, nonce, SIVA_NONCE_LENGTH);
+  memset(block + SIVA_NONCE_LENGTH, 0, sizeof (block) - SIVA_NONCE_LENGTH);
+
+  return _mm_loadu_si128((const __m128i *)block);
+}
+
+/* ================================================== */
+
+/* Derive the message-authentication key and expanded message-encryption
+   key for a nonce */
+static TARGET void
+derive_keys(const SIVA_Key *key, __m128i n, __m128i *auth_key, __m128i *enc_rk)
+{
+  __m128i rk[11], x[4];
+  int i;
+
+  for (i = 0; i < 11; i++)
+    rk[i] = _mm_loadu_si128((const __m128i *)key->round_keys[i]);
+
+  /* Blocks with a little-endian 32-bit counter followed by the nonce */
+  n = _mm_slli_si128(n, 4);
+  for (i = 0; i < 4; i++)
+    x[i] = _mm_or_si128(n, _mm_cvtsi32_si128(i));
+
+  encrypt_blocks(rk, x, 4);
+
+  /* Only the first half of each encrypted block is used */
+  *auth_key = _mm_unpacklo_epi64(x[0], x[1]);
+  expand_key(_mm_unpacklo_epi64(x[2], x[3]), enc_rk);
+}
+
+/* ================================================== */
+
+static TARGET __m128i
+compute_tag(const __m128i *enc_rk, __m128i auth_key, __m128i n,
+            const void *assoc, int assoc_length, const void *plaintext, int plaintext_length)
+{
+  __m128i s;
+
+  s = _mm_setzero_si128();
+  s = polyval_update(auth_key, s, assoc, assoc_length);
+  s = polyval_update(auth_key, s, plaintext, plaintext_length);
+  s = polyval_mul(_mm_xor_si128(s, _mm_set_epi64x((uint64_t)plaintext_length * 8,
+                                                  (uint64_t)assoc_length * 8)), auth_key);
+
+  s = _mm_xor_si128(s, n);
+  s = _mm_and_si128(s, _mm_setr_epi32(-1, -1, -1, 0x7fffffff));
+
+  return encrypt_block(enc_rk, s);
+}
+
+/* ================================================== */
+
+static TARGET void
+crypt_ctr(const __m128i *enc_rk, __m128i tag, const unsigned char *in, int length,
+          unsigned char *out)
+{
+  __m128i ctr, one, x[4];
+  unsigned char block[16];
+  int i;
+
+  ctr = _mm_or_si128(tag, _mm_setr_epi32(0, 0, 0, 0x80000000));
+  one = _mm_cvtsi32_si128(1);
+
+  for (; length >= 64; length -= 64, in += 64, out += 64) {
+    for (i = 0; i < 4; i++) {
+      x[i] = ctr;
+      ctr = _mm_add_epi32(ctr, one);
+    }
+    encrypt_blocks(enc_rk, x, 4);
+    for (i = 0; i < 4; i++)
+      _mm_storeu_si128((__m128i *)out + i,
+                       _mm_xor_si128(x[i], _mm_loadu_si128((const __m128i *)in + i)));
+  }
+
+  for (; length >= 16; length -= 16, in += 16, out += 16) {
+    x[0] = encrypt_block(enc_rk, ctr);
+    ctr = _mm_add_epi32(ctr, one);
+    _mm_storeu_si128((__m128i *)out,
+                     _mm_xor_si128(x[0], _mm_loadu_si128((const __m128i *)in)));
+  }
+
+  if (length > 0) {
+    memcpy(block, in, length);
+    x[0] = encrypt_block(enc_rk, ctr);
+    _mm_storeu_si128((__m128i *)block,
+                     _mm_xor_si128(x[0], _mm_loadu_si128((const __m128i *)block)));
+    memcpy(out, block, length);
+  }
+}
+
+/* ================================================== */
+
+TARGET void
+SIVA_SetKey(SIVA_Key *key, const unsigned char *raw_key)
+{
+  __m128i rk[11];
+  int i;
+
+  expand_key(_mm_loadu_si128((const __m128i *)raw_key), rk);
+
+  for (i = 0; i < 11; i++)
+    _mm_storeu_si128((__m128i *)key->round_keys[i], rk[i]);
+}
+
+/* ================================================== */
+
+TARGET void
+SIVA_Encrypt(const SIVA_Key *key, const unsigned char *nonce,
+             const void *assoc, int assoc_length,
+             const void *plaintext, int plaintext_length,
+             unsigned char *ciphertext)
+{
+  __m128i auth_key, enc_rk[11], n, tag;
+
+  n = load_nonce(nonce);
+  derive_keys(key, n, &auth_key, enc_rk);
+
+  tag = compute_tag(enc_rk, auth_key, n, assoc, assoc_length, plaintext, plaintext_length);
+
+  /* The tag is written last to not overwrite the plaintext in case
+     of in-place encryption */
+  crypt_ctr(enc_rk, tag, plaintext, plaintext_length, ciphertext);
+  _mm_storeu_si128((__m128i *)(ciphertext + plaintext_length), tag);
+}
+
+/* ================================================== */
+
+/* Encrypt the same plaintext with GROUP_SIZE nonces.  All steps are
+   interleaved between the messages to hide the latency of the AES and
+   carry-less multiplication instructions, which otherwise limits the
+   encryption of short messages.  If fewer than GROUP_SIZE messages are
+   requested, the first nonce is used for the missing messages and their
+   ciphertexts are not saved. */
+static TARGET void
+encrypt_group(const SIVA_Key *key, int n, const unsigned char *const *nonces,
+              const void *assoc, int assoc_length,
+              const void *plaintext, int plaintext_length,
+              unsigned char *const *ciphertexts)
+{
+  __m128i rk[11], enc_rks[GROUP_SIZE][11], auth_keys[GROUP_SIZE], ns[GROUP_SIZE];
+  __m128i x[4 * GROUP_SIZE], tags[GROUP_SIZE], ctrs[GROUP_SIZE], lengths, one, p;
+  unsigned char block[16];
+  int i, j, offset, length;
+
+  for (i = 0; i < 11; i++)
+    rk[i] = _mm_loadu_si128((const __m128i *)key->round_keys[i]);
+
+  /* Derive the keys for all nonces (as in derive_keys()) */
+  UNROLL
+  for (j = 0; j < GROUP_SIZE; j++) {
+    ns[j] = load_nonce(nonces[j < n ? j : 0]);
+    UNROLL
+    for (i = 0; i < 4; i++)
+      x[4 * j + i] = _mm_or_si128(_mm_slli_si128(ns[j], 4), _mm_cvtsi32_si128(i));
+  }
+
+  encrypt_blocks(rk, x, 4 * GROUP_SIZE);
+
+  UNROLL
+  for (j = 0; j < GROUP_SIZE; j++) {
+    auth_keys[j] = _mm_unpacklo_epi64(x[4 * j], x[4 * j + 1]);
+    enc_rks[j][0] = _mm_unpacklo_epi64(x[4 * j + 2], x[4 * j + 3]);
+  }
+
+  expand_keys(enc_rks, GROUP_SIZE);
+
+  /* Compute the tags (as in compute_tag()) */
+  UNROLL
+  for (j = 0; j < GROUP_SIZE; j++)
+    tags[j] = _mm_setzero_si128();
+
+  polyval_update_keys(auth_keys, tags, GROUP_SIZE, assoc, assoc_length);
+  polyval_update_keys(auth_keys, tags, GROUP_SIZE, plaintext, plaintext_length);
+
+  lengths = _mm_set_epi64x((uint64_t)plaintext_length * 8, (uint64_t)assoc_length * 8);
+
+  UNROLL
+  for (j = 0; j < GROUP_SIZE; j++) {
+    tags[j] = polyval_mul(_mm_xor_si128(tags[j], lengths), auth_keys[j]);
+    tags[j] = _mm_xor_si128(tags[j], ns[j]);
+    tags[j] = _mm_and_si128(tags[j], _mm_setr_epi32(-1, -1, -1, 0x7fffffff));
+  }
+
+  encrypt_blocks_keys(enc_rks, tags, GROUP_SIZE);
+
+  /* Encrypt the plaintext in the CTR mode (as in crypt_ctr()) */
+  one = _mm_cvtsi32_si128(1);
+  UNROLL
+  for (j = 0; j < GROUP_SIZE; j++)
+    ctrs[j] = _mm_or_si128(tags[j], _mm_setr_epi32(0, 0, 0, 0x80000000));
+
+  for (offset = 0; offset < plaintext_length; offset += 16) {
+    length = plaintext_length - offset;
+    if (length >= 16) {
+      p = _mm_loadu_si128((const __m128i *)((const unsigned char *)plaintext + offset));
+    } else {
+      memset(block, 0, sizeof (block));
+      memcpy(block, (const unsigned char *)plaintext + offset, length);
+      p = _mm_loadu_si128((const __m128i *)block);
+    }
+
+    UNROLL
+    for (j = 0; j < GROUP_SIZE; j++) {
+      x[j] = ctrs[j];
+      ctrs[j] = _mm_add_epi32(ctrs[j], one);
+    }
+
+    encrypt_blocks_keys(enc_rks, x, GROUP_SIZE);
+
+    /* A partial block can be stored whole as the tag follows */
+    UNROLL
+    for (j = 0; j < GROUP_SIZE; j++) {
+      if (j < n)
+        _mm_storeu_si128((__m128i *)(ciphertexts[j] + offset), _mm_xor_si128(x[j], p));
+    }
+  }
+
+  UNROLL
+  for (j = 0; j < GROUP_SIZE; j++) {
+    if (j < n)
+      _mm_storeu_si128((__m128i *)(ciphertexts[j] + plaintext_length), tags[j]);
+  }
+}
+
+/* ================================================== */
+
+TARGET void
+SIVA_EncryptMultiple(const SIVA_Key *key, int n, const unsigned char *const *nonces,
+                     const void *assoc, int assoc_length,
+                     const void *plaintext, int plaintext_length,
+                     unsigned char *const *ciphertexts)
+{
+  int i;
+
+  for (i = 0; i < n; i += GROUP_SIZE) {
+    /* A single message is faster to encrypt alone */
+    if (n - i == 1)
+      SIVA_Encrypt(key, nonces[i], assoc, assoc_length, plaintext, plaintext_length,
+                   ciphertexts[i]);
+    else
+      encrypt_group(key, n - i, nonces + i, assoc, assoc_length,
+                    plaintext, plaintext_length, ciphertexts + i);
+  }
+}
+
+/* ================================================== */
+
+TARGET int
+SIVA_Decrypt(const SIVA_Key *key, const unsigned char *nonce,
+             const void *assoc, int assoc_length,
+             const unsigned char *ciphertext, int ciphertext_length,
+             void *plaintext)
+{
+  __m128i auth_key, enc_rk[11], n, tag, expected_tag;
+  int plaintext_length;
+
+  plaintext_length = ciphertext_length - SIVA_TAG_LENGTH;
+  if (plaintext_length < 0)
+    return 0;
+
+  n = load_nonce(nonce);
+  derive_keys(key, n, &auth_key, enc_rk);
+
+  tag = _mm_loadu_si128((const __m128i *)(ciphertext + plaintext_length));
+  crypt_ctr(enc_rk, tag, ciphertext, plaintext_length, plaintext);
+
+  expected_tag = compute_tag(enc_rk, auth_key, n, assoc, assoc_length,
+                             plaintext, plaintext_length);
+
+  /* Compare the tags in constant time */
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(tag, expected_tag)) != 0xffff) {
+    memset(plaintext, 0, plaintext_length);
+    return 0;
+  }
+
+  return 1;
+}
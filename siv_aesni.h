@@ -0,0 +1,66 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+
+  =======================================================================
+
+  Header file for the AES-128-GCM-SIV implementation using the x86 AES-NI,
+  PCLMULQDQ, and SSSE3 instructions
+  */
+
+#ifndef GOT_SIV_AESNI_H
+#define GOT_SIV_AESNI_H
+
+#define SIVA_KEY_LENGTH 16
+#define SIVA_NONCE_LENGTH 12
+#define SIVA_TAG_LENGTH 16
+
+/* Expanded key-generating key */
+typedef struct {
+  unsigned char round_keys[11][16];
+} SIVA_Key;
+
+/* Check if the CPU supports the instructions */
+extern int SIVA_IsSupported(void);
+
+extern void SIVA_SetKey(SIVA_Key *key, const unsigned char *raw_key);
+
+/* Encrypt plaintext and append the tag.  The plaintext may be at the
+   beginning of the ciphertext buffer (in-place encryption). */
+extern void SIVA_Encrypt(const SIVA_Key *key, const unsigned char *nonce,
+                         const void *assoc, int assoc_length,
+                         const void *plaintext, int plaintext_length,
+                         unsigned char *ciphertext);
+
+/* Encrypt the same plaintext with multiple nonces.  The ciphertexts
+   (with the tags) are written to separate buffers, which must not
+   overlap with the plaintext. */
+extern void SIVA_EncryptMultiple(const SIVA_Key *key, int n,
+                                 const unsigned char *const *nonces,
+                                 const void *assoc, int assoc_length,
+                                 const void *plaintext, int plaintext_length,
+                                 unsigned char *const *ciphertexts);
+
+/* Decrypt and authenticate ciphertext with the tag at the end */
+extern int SIVA_Decrypt(const SIVA_Key *key, const unsigned char *nonce,
+                        const void *assoc, int assoc_length,
+                        const unsigned char *ciphertext, int ciphertext_length,
+                        void *plaintext);
+
+#endif
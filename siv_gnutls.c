@@ -33,12 +33,20 @@
 #include "logging.h"
 #include "memory.h"
 #include "siv.h"
+#ifdef HAVE_SIV_AESNI
+#include "siv_aesni.h"
+#endif
 
 struct SIV_Instance_Record {
   gnutls_cipher_algorithm_t algorithm;
   gnutls_aead_cipher_hd_t cipher;
   int min_nonce_length;
   int max_nonce_length;
+#ifdef HAVE_SIV_AESNI
+  int aesni;
+  int aesni_key_set;
+  SIVA_Key aesni_key;
+#endif
 };
 
 /* ================================================== */
@@ -94,12 +102,40 @@ get_cipher_algorithm(SIV_Algorithm algorithm)
 
 /* ================================================== */
 
+/* Check if the algorithm can use the AES-NI implementation instead
+   of gnutls */
+static int
+use_aesni(SIV_Algorithm algorithm)
+{
+#ifdef HAVE_SIV_AESNI
+  return algorithm == AEAD_AES_128_GCM_SIV && SIVA_IsSupported();
+#else
+  return 0;
+#endif
+}
+
+/* ================================================== */
+
 SIV_Instance
 SIV_CreateInstance(SIV_Algorithm algorithm)
 {
   gnutls_cipher_algorithm_t calgo;
   SIV_Instance instance;
 
+#ifdef HAVE_SIV_AESNI
+  /* This implementation doesn't need gnutls to be initialised */
+  if (use_aesni(algorithm)) {
+    instance = MallocNew(struct SIV_Instance_Record);
+    instance->algorithm = 0;
+    instance->cipher = NULL;
+    instance->min_nonce_length = SIVA_NONCE_LENGTH;
+    instance->max_nonce_length = SIVA_NONCE_LENGTH;
+    instance->aesni = 1;
+    instance->aesni_key_set = 0;
+    return instance;
+  }
+#endif
+
   calgo = get_cipher_algorithm(algorithm);
   if (calgo == 0)
     return NULL;
@@ -117,6 +153,10 @@ SIV_CreateInstance(SIV_Algorithm algorithm)
   instance = MallocNew(struct SIV_Instance_Record);
   instance->algorithm = calgo;
   instance->cipher = NULL;
+#ifdef HAVE_SIV_AESNI
+  instance->aesni = 0;
+  instance->aesni_key_set = 0;
+#endif
 
   switch (algorithm) {
     case AEAD_AES_SIV_CMAC_256:
@@ -141,6 +181,13 @@ SIV_CreateInstance(SIV_Algorithm algorithm)
 void
 SIV_DestroyInstance(SIV_Instance instance)
 {
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    Free(instance);
+    return;
+  }
+#endif
+
   if (instance->cipher)
     gnutls_aead_cipher_deinit(instance->cipher);
   Free(instance);
@@ -158,6 +205,11 @@ SIV_GetKeyLength(SIV_Algorithm algorithm)
   gnutls_cipher_algorithm_t calgo = get_cipher_algorithm(algorithm);
   int len;
 
+#ifdef HAVE_SIV_AESNI
+  if (use_aesni(algorithm))
+    return SIVA_KEY_LENGTH;
+#endif
+
   if (calgo == 0)
     return 0;
 
@@ -180,6 +232,16 @@ SIV_SetKey(SIV_Instance instance, const unsigned char *key, int length)
   gnutls_datum_t datum;
   int r;
 
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    if (length != SIVA_KEY_LENGTH)
+      return 0;
+    SIVA_SetKey(&instance->aesni_key, key);
+    instance->aesni_key_set = 1;
+    return 1;
+  }
+#endif
+
   if (length <= 0 || length != gnutls_cipher_get_key_size(instance->algorithm))
     return 0;
 
@@ -237,6 +299,11 @@ SIV_GetTagLength(SIV_Instance instance)
 {
   int len;
 
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni)
+    return SIVA_TAG_LENGTH;
+#endif
+
   len = gnutls_cipher_get_tag_size(instance->algorithm);
 
   if (len < 1 || len > SIV_MAX_TAG_LENGTH)
@@ -247,6 +314,21 @@ SIV_GetTagLength(SIV_Instance instance)
 
 /* ================================================== */
 
+int
+SIV_GetInPlaceOffset(SIV_Instance instance)
+{
+#ifdef HAVE_SIV_AESNI
+  /* The tag is appended to the ciphertext */
+  if (instance->aesni)
+    return 0;
+#endif
+
+  /* Overlapping buffers are not supported by gnutls_aead_cipher_encrypt() */
+  return -1;
+}
+
+/* ================================================== */
+
 int
 SIV_Encrypt(SIV_Instance instance,
             const unsigned char *nonce, int nonce_length,
@@ -256,6 +338,21 @@ SIV_Encrypt(SIV_Instance instance,
 {
   size_t clen = ciphertext_length;
 
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    if (!instance->aesni_key_set || nonce_length != SIVA_NONCE_LENGTH ||
+        assoc_length < 0 || plaintext_length < 0 ||
+        plaintext_length + SIVA_TAG_LENGTH != ciphertext_length)
+      return 0;
+
+    assert(assoc && plaintext);
+
+    SIVA_Encrypt(&instance->aesni_key, nonce, assoc, assoc_length,
+                 plaintext, plaintext_length, ciphertext);
+    return 1;
+  }
+#endif
+
   if (!instance->cipher)
     return 0;
 
@@ -279,6 +376,41 @@ SIV_Encrypt(SIV_Instance instance,
 
 /* ================================================== */
 
+int
+SIV_EncryptMultiple(SIV_Instance instance, int n,
+                    const unsigned char *const *nonces, int nonce_length,
+                    const void *assoc, int assoc_length,
+                    const void *plaintext, int plaintext_length,
+                    unsigned char *const *ciphertexts, int ciphertext_length)
+{
+  int i;
+
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    if (!instance->aesni_key_set || n < 0 || nonce_length != SIVA_NONCE_LENGTH ||
+        assoc_length < 0 || plaintext_length < 0 ||
+        plaintext_length + SIVA_TAG_LENGTH != ciphertext_length)
+      return 0;
+
+    assert(assoc && plaintext);
+
+    SIVA_EncryptMultiple(&instance->aesni_key, n, nonces, assoc, assoc_length,
+                         plaintext, plaintext_length, ciphertexts);
+    return 1;
+  }
+#endif
+
+  for (i = 0; i < n; i++) {
+    if (!SIV_Encrypt(instance, nonces[i], nonce_length, assoc, assoc_length,
+                     plaintext, plaintext_length, ciphertexts[i], ciphertext_length))
+      return 0;
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
 int
 SIV_Decrypt(SIV_Instance instance,
             const unsigned char *nonce, int nonce_length,
@@ -288,6 +420,20 @@ SIV_Decrypt(SIV_Instance instance,
 {
   size_t plen = plaintext_length;
 
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    if (!instance->aesni_key_set || nonce_length != SIVA_NONCE_LENGTH ||
+        assoc_length < 0 || plaintext_length < 0 ||
+        plaintext_length + SIVA_TAG_LENGTH != ciphertext_length)
+      return 0;
+
+    assert(assoc && plaintext);
+
+    return SIVA_Decrypt(&instance->aesni_key, nonce, assoc, assoc_length,
+                        ciphertext, ciphertext_length, plaintext);
+  }
+#endif
+
   if (!instance->cipher)
     return 0;
 
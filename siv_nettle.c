@@ -35,11 +35,15 @@
 
 #include "memory.h"
 #include "siv.h"
+#ifdef HAVE_SIV_AESNI
+#include "siv_aesni.h"
+#endif
 #include "util.h"
 
 struct SIV_Instance_Record {
   SIV_Algorithm algorithm;
   int key_set;
+  int aesni;
   int min_nonce_length;
   int max_nonce_length;
   int tag_length;
@@ -47,12 +51,29 @@ struct SIV_Instance_Record {
     struct siv_cmac_aes128_ctx cmac_aes128;
 #ifdef HAVE_NETTLE_SIV_GCM
     struct aes128_ctx aes128;
+#endif
+#ifdef HAVE_SIV_AESNI
+    SIVA_Key aesni;
 #endif
   } ctx;
 };
 
 /* ================================================== */
 
+/* Check if the algorithm can use the AES-NI implementation instead
+   of nettle */
+static int
+use_aesni(SIV_Algorithm algorithm)
+{
+#ifdef HAVE_SIV_AESNI
+  return algorithm == AEAD_AES_128_GCM_SIV && SIVA_IsSupported();
+#else
+  return 0;
+#endif
+}
+
+/* ================================================== */
+
 SIV_Instance
 SIV_CreateInstance(SIV_Algorithm algorithm)
 {
@@ -64,6 +85,16 @@ SIV_CreateInstance(SIV_Algorithm algorithm)
   instance = MallocNew(struct SIV_Instance_Record);
   instance->algorithm = algorithm;
   instance->key_set = 0;
+  instance->aesni = use_aesni(algorithm);
+
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    instance->min_nonce_length = SIVA_NONCE_LENGTH;
+    instance->max_nonce_length = SIVA_NONCE_LENGTH;
+    instance->tag_length = SIVA_TAG_LENGTH;
+    return instance;
+  }
+#endif
 
   switch (algorithm) {
     case AEAD_AES_SIV_CMAC_256:
@@ -103,9 +134,11 @@ SIV_GetKeyLength(SIV_Algorithm algorithm)
   switch (algorithm) {
     case AEAD_AES_SIV_CMAC_256:
       return 2 * AES128_KEY_SIZE;
-#ifdef HAVE_NETTLE_SIV_GCM
     case AEAD_AES_128_GCM_SIV:
+#ifdef HAVE_NETTLE_SIV_GCM
       return AES128_KEY_SIZE;
+#else
+      return use_aesni(algorithm) ? AES128_KEY_SIZE : 0;
 #endif
     default:
       return 0;
@@ -120,6 +153,14 @@ SIV_SetKey(SIV_Instance instance, const unsigned char *key, int length)
   if (length != SIV_GetKeyLength(instance->algorithm))
     return 0;
 
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    SIVA_SetKey(&instance->ctx.aesni, key);
+    instance->key_set = 1;
+    return 1;
+  }
+#endif
+
   switch (instance->algorithm) {
     case AEAD_AES_SIV_CMAC_256:
       siv_cmac_aes128_set_key(&instance->ctx.cmac_aes128, key);
@@ -165,6 +206,24 @@ SIV_GetTagLength(SIV_Instance instance)
 
 /* ================================================== */
 
+int
+SIV_GetInPlaceOffset(SIV_Instance instance)
+{
+  /* The CTR encryption in nettle can be done in place.  The tag is before
+     the encrypted data in AES-SIV-CMAC and after it in AES-GCM-SIV, and it
+     is written after the plaintext was authenticated. */
+  switch (instance->algorithm) {
+    case AEAD_AES_SIV_CMAC_256:
+      return SIV_GetTagLength(instance);
+    case AEAD_AES_128_GCM_SIV:
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+/* ================================================== */
+
 int
 SIV_Encrypt(SIV_Instance instance,
             const unsigned char *nonce, int nonce_length,
@@ -183,6 +242,14 @@ SIV_Encrypt(SIV_Instance instance,
 
   assert(assoc && plaintext);
 
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    SIVA_Encrypt(&instance->ctx.aesni, nonce, assoc, assoc_length,
+                 plaintext, plaintext_length, ciphertext);
+    return 1;
+  }
+#endif
+
   switch (instance->algorithm) {
     case AEAD_AES_SIV_CMAC_256:
       siv_cmac_aes128_encrypt_message(&instance->ctx.cmac_aes128,
@@ -205,6 +272,41 @@ SIV_Encrypt(SIV_Instance instance,
 
 /* ================================================== */
 
+int
+SIV_EncryptMultiple(SIV_Instance instance, int n,
+                    const unsigned char *const *nonces, int nonce_length,
+                    const void *assoc, int assoc_length,
+                    const void *plaintext, int plaintext_length,
+                    unsigned char *const *ciphertexts, int ciphertext_length)
+{
+  int i;
+
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni) {
+    if (!instance->key_set || n < 0 || nonce_length != SIVA_NONCE_LENGTH ||
+        assoc_length < 0 || plaintext_length < 0 ||
+        plaintext_length + SIVA_TAG_LENGTH != ciphertext_length)
+      return 0;
+
+    assert(assoc && plaintext);
+
+    SIVA_EncryptMultiple(&instance->ctx.aesni, n, nonces, assoc, assoc_length,
+                         plaintext, plaintext_length, ciphertexts);
+    return 1;
+  }
+#endif
+
+  for (i = 0; i < n; i++) {
+    if (!SIV_Encrypt(instance, nonces[i], nonce_length, assoc, assoc_length,
+                     plaintext, plaintext_length, ciphertexts[i], ciphertext_length))
+      return 0;
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
 int
 SIV_Decrypt(SIV_Instance instance,
             const unsigned char *nonce, int nonce_length,
@@ -223,6 +325,12 @@ SIV_Decrypt(SIV_Instance instance,
 
   assert(assoc && plaintext);
 
+#ifdef HAVE_SIV_AESNI
+  if (instance->aesni)
+    return SIVA_Decrypt(&instance->ctx.aesni, nonce, assoc, assoc_length,
+                        ciphertext, ciphertext_length, plaintext);
+#endif
+
   switch (instance->algorithm) {
     case AEAD_AES_SIV_CMAC_256:
       if (!siv_cmac_aes128_decrypt_message(&instance->ctx.cmac_aes128,
@@ -76,7 +76,8 @@ struct Message {
 };
 
 #ifdef HAVE_RECVMMSG
-#define MAX_RECV_MESSAGES 16
+#define DEFAULT_RECV_MESSAGES 16
+#define MAX_RECV_MESSAGES 256
 #define MessageHeader mmsghdr
 #else
 /* Compatible with mmsghdr */
@@ -85,9 +86,20 @@ struct MessageHeader {
   unsigned int msg_len;
 };
 
+#define DEFAULT_RECV_MESSAGES 1
 #define MAX_RECV_MESSAGES 1
 #endif
 
+/* Maximum number of messages sent in one sendmmsg() call */
+#define MAX_SEND_MESSAGES 16
+
+/* Buffers for the name, data, and control messages of a sent message */
+struct SendBuffers {
+  union sockaddr_all name;
+  struct iovec iov;
+  struct cmsghdr cmsg_buf[CMSG_BUF_SIZE / sizeof (struct cmsghdr)];
+};
+
 static int initialised;
 
 static int first_reusable_fd;
@@ -138,6 +150,19 @@ prepare_buffers(unsigned int n)
 
 /* ================================================== */
 
+static void
+resize_buffers(unsigned int n)
+{
+  ARR_SetSize(recv_messages, n);
+  ARR_SetSize(recv_headers, n);
+  ARR_SetSize(recv_sck_messages, n);
+
+  /* The arrays may have been reallocated, prepare all buffers again */
+  received_messages = n;
+}
+
+/* ================================================== */
+
 static const char *
 domain_to_string(int domain)
 {
@@ -1152,24 +1177,21 @@ add_control_message(struct msghdr *msg, int level, int type, size_t length, size
 /* ================================================== */
 
 static int
-send_message(int sock_fd, SCK_Message *message, int flags)
+init_send_header(SCK_Message *message, int flags, struct SendBuffers *buf,
+                 struct msghdr *msg)
 {
-  struct cmsghdr cmsg_buf[CMSG_BUF_SIZE / sizeof (struct cmsghdr)];
-  union sockaddr_all saddr;
   socklen_t saddr_len;
-  struct msghdr msg;
-  struct iovec iov;
 
   switch (message->addr_type) {
     case SCK_ADDR_UNSPEC:
       saddr_len = 0;
       break;
     case SCK_ADDR_IP:
-      saddr_len = SCK_IPSockAddrToSockaddr(&message->remote_addr.ip,
-                                           (struct sockaddr *)&saddr, sizeof (saddr));
+      saddr_len = SCK_IPSockAddrToSockaddr(&message->remote_addr.ip, &buf->name.sa,
+                                           sizeof (buf->name));
       break;
     case SCK_ADDR_UNIX:
-      saddr_len = set_unix_sockaddr(&saddr.un, message->remote_addr.path);
+      saddr_len = set_unix_sockaddr(&buf->name.un, message->remote_addr.path);
       if (saddr_len == 0)
         return 0;
       break;
@@ -1178,11 +1200,11 @@ send_message(int sock_fd, SCK_Message *message, int flags)
   }
 
   if (saddr_len) {
-    msg.msg_name = &saddr.un;
-    msg.msg_namelen = saddr_len;
+    msg->msg_name = &buf->name.un;
+    msg->msg_namelen = saddr_len;
   } else {
-    msg.msg_name = NULL;
-    msg.msg_namelen = 0;
+    msg->msg_name = NULL;
+    msg->msg_namelen = 0;
   }
 
   if (message->length < 0) {
@@ -1190,21 +1212,21 @@ send_message(int sock_fd, SCK_Message *message, int flags)
     return 0;
   }
 
-  iov.iov_base = message->data;
-  iov.iov_len = message->length;
-  msg.msg_iov = &iov;
-  msg.msg_iovlen = 1;
-  msg.msg_control = cmsg_buf;
-  msg.msg_controllen = 0;
-  msg.msg_flags = 0;
+  buf->iov.iov_base = message->data;
+  buf->iov.iov_len = message->length;
+  msg->msg_iov = &buf->iov;
+  msg->msg_iovlen = 1;
+  msg->msg_control = buf->cmsg_buf;
+  msg->msg_controllen = 0;
+  msg->msg_flags = 0;
 
   if (message->addr_type == SCK_ADDR_IP) {
     if (message->local_addr.ip.family == IPADDR_INET4) {
 #ifdef HAVE_IN_PKTINFO
       struct in_pktinfo *ipi;
 
-      ipi = add_control_message(&msg, IPPROTO_IP, IP_PKTINFO, sizeof (*ipi),
-                                sizeof (cmsg_buf));
+      ipi = add_control_message(msg, IPPROTO_IP, IP_PKTINFO, sizeof (*ipi),
+                                sizeof (buf->cmsg_buf));
       if (!ipi)
         return 0;
 
@@ -1215,8 +1237,8 @@ send_message(int sock_fd, SCK_Message *message, int flags)
 #elif defined(IP_SENDSRCADDR)
       struct in_addr *addr;
 
-      addr = add_control_message(&msg, IPPROTO_IP, IP_SENDSRCADDR, sizeof (*addr),
-                                 sizeof (cmsg_buf));
+      addr = add_control_message(msg, IPPROTO_IP, IP_SENDSRCADDR, sizeof (*addr),
+                                 sizeof (buf->cmsg_buf));
       if (!addr)
         return 0;
 
@@ -1228,8 +1250,8 @@ send_message(int sock_fd, SCK_Message *message, int flags)
     if (message->local_addr.ip.family == IPADDR_INET6) {
       struct in6_pktinfo *ipi;
 
-      ipi = add_control_message(&msg, IPPROTO_IPV6, IPV6_PKTINFO, sizeof (*ipi),
-                                sizeof (cmsg_buf));
+      ipi = add_control_message(msg, IPPROTO_IPV6, IPV6_PKTINFO, sizeof (*ipi),
+                                sizeof (buf->cmsg_buf));
       if (!ipi)
         return 0;
 
@@ -1247,8 +1269,8 @@ send_message(int sock_fd, SCK_Message *message, int flags)
 
     /* Set timestamping flags for this message */
 
-    ts_tx_flags = add_control_message(&msg, SOL_SOCKET, SO_TIMESTAMPING,
-                                      sizeof (*ts_tx_flags), sizeof (cmsg_buf));
+    ts_tx_flags = add_control_message(msg, SOL_SOCKET, SO_TIMESTAMPING,
+                                      sizeof (*ts_tx_flags), sizeof (buf->cmsg_buf));
     if (!ts_tx_flags)
       return 0;
 
@@ -1259,8 +1281,8 @@ send_message(int sock_fd, SCK_Message *message, int flags)
   if (message->timestamp.tx_id != 0) {
     uint32_t *tx_id;
 
-    tx_id = add_control_message(&msg, SOL_SOCKET, SCM_TS_OPT_ID,
-                                sizeof (*tx_id), sizeof (cmsg_buf));
+    tx_id = add_control_message(msg, SOL_SOCKET, SCM_TS_OPT_ID,
+                                sizeof (*tx_id), sizeof (buf->cmsg_buf));
     if (!tx_id)
       return 0;
 
@@ -1272,7 +1294,7 @@ send_message(int sock_fd, SCK_Message *message, int flags)
   if (flags & SCK_FLAG_MSG_DESCRIPTOR) {
     int *fd;
 
-    fd = add_control_message(&msg, SOL_SOCKET, SCM_RIGHTS, sizeof (*fd), sizeof (cmsg_buf));
+    fd = add_control_message(msg, SOL_SOCKET, SCM_RIGHTS, sizeof (*fd), sizeof (buf->cmsg_buf));
     if (!fd)
       return 0;
 
@@ -1280,8 +1302,21 @@ send_message(int sock_fd, SCK_Message *message, int flags)
   }
 
   /* This is apparently required on some systems */
-  if (msg.msg_controllen == 0)
-    msg.msg_control = NULL;
+  if (msg->msg_controllen == 0)
+    msg->msg_control = NULL;
+
+  return 1;
+}
+
+
+static int
+send_message(int sock_fd, SCK_Message *message, int flags)
+{
+  struct SendBuffers buf;
+  struct msghdr msg;
+
+  if (!init_send_header(message, flags, &buf, &msg))
+    return 0;
 
   if (sendmsg(sock_fd, &msg, 0) < 0) {
     log_message(sock_fd, -1, message, "Could not send", strerror(errno));
@@ -1295,6 +1330,62 @@ send_message(int sock_fd, SCK_Message *message, int flags)
 
 /* ================================================== */
 
+static int
+send_messages(int sock_fd, SCK_Message *messages, int num_messages, int flags, int *sent)
+{
+#ifdef HAVE_RECVMMSG
+  struct SendBuffers bufs[MAX_SEND_MESSAGES];
+  struct mmsghdr hdrs[MAX_SEND_MESSAGES];
+  int i, j, k, n, r, total, indices[MAX_SEND_MESSAGES];
+
+  if (sent)
+    memset(sent, 0, sizeof (sent[0]) * num_messages);
+
+  for (i = total = 0; i < num_messages; ) {
+    for (n = 0; i < num_messages && n < MAX_SEND_MESSAGES; i++) {
+      if (!init_send_header(&messages[i], flags, &bufs[n], &hdrs[n].msg_hdr))
+        continue;
+      hdrs[n].msg_len = 0;
+      indices[n++] = i;
+    }
+
+    for (j = 0; j < n; j += r) {
+      r = sendmmsg(sock_fd, &hdrs[j], n - j, 0);
+
+      /* Skip the message which caused the error */
+      if (r <= 0) {
+        log_message(sock_fd, -1, &messages[indices[j]], "Could not send", strerror(errno));
+        r = 1;
+        continue;
+      }
+
+      for (k = j; k < j + r; k++) {
+        log_message(sock_fd, -1, &messages[indices[k]], "Sent", NULL);
+        if (sent)
+          sent[indices[k]] = 1;
+      }
+
+      total += r;
+    }
+  }
+
+  return total;
+#else
+  int i, r, total;
+
+  for (i = total = 0; i < num_messages; i++) {
+    r = send_message(sock_fd, &messages[i], flags);
+    if (sent)
+      sent[i] = r;
+    total += r;
+  }
+
+  return total;
+#endif
+}
+
+/* ================================================== */
+
 void
 SCK_PreInitialise(void)
 {
@@ -1341,13 +1432,10 @@ SCK_Initialise(int family)
 #endif
 
   recv_messages = ARR_CreateInstance(sizeof (struct Message));
-  ARR_SetSize(recv_messages, MAX_RECV_MESSAGES);
   recv_headers = ARR_CreateInstance(sizeof (struct MessageHeader));
-  ARR_SetSize(recv_headers, MAX_RECV_MESSAGES);
   recv_sck_messages = ARR_CreateInstance(sizeof (SCK_Message));
-  ARR_SetSize(recv_sck_messages, MAX_RECV_MESSAGES);
 
-  received_messages = MAX_RECV_MESSAGES;
+  resize_buffers(DEFAULT_RECV_MESSAGES);
 
   priv_bind_function = NULL;
 
@@ -1593,6 +1681,34 @@ SCK_EnableKernelRxTimestamping(int sock_fd)
 
 /* ================================================== */
 
+int
+SCK_EnableBusyPolling(int sock_fd, int timeout, int budget, int prefer)
+{
+#ifdef SO_BUSY_POLL
+  if (!SCK_SetIntOption(sock_fd, SOL_SOCKET, SO_BUSY_POLL, timeout))
+    return 0;
+#ifdef SO_BUSY_POLL_BUDGET
+  if (budget > 0 && !SCK_SetIntOption(sock_fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, budget))
+    return 0;
+#else
+  if (budget > 0)
+    return 0;
+#endif
+#ifdef SO_PREFER_BUSY_POLL
+  if (prefer && !SCK_SetIntOption(sock_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, 1))
+    return 0;
+#else
+  if (prefer)
+    return 0;
+#endif
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* ================================================== */
+
 int
 SCK_ListenOnSocket(int sock_fd, int backlog)
 {
@@ -1705,9 +1821,22 @@ SCK_ReceiveMessage(int sock_fd, int flags)
 /* ================================================== */
 
 SCK_Message *
-SCK_ReceiveMessages(int sock_fd, int flags, int *num_messages)
+SCK_ReceiveMessages(int sock_fd, int flags, int max_messages, int *num_messages)
 {
-  return receive_messages(sock_fd, flags, MAX_RECV_MESSAGES, num_messages);
+  return receive_messages(sock_fd, flags, max_messages, num_messages);
+}
+
+/* ================================================== */
+
+int
+SCK_SetMaxReceiveMessages(int max_messages)
+{
+  max_messages = CLAMP(1, max_messages, MAX_RECV_MESSAGES);
+
+  if (initialised)
+    resize_buffers(max_messages);
+
+  return max_messages;
 }
 
 /* ================================================== */
@@ -1729,6 +1858,15 @@ SCK_SendMessage(int sock_fd, SCK_Message *message, int flags)
 
 /* ================================================== */
 
+int
+SCK_SendMessages(int sock_fd, SCK_Message *messages, int num_messages, int flags,
+                 int *sent)
+{
+  return send_messages(sock_fd, messages, num_messages, flags, sent);
+}
+
+/* ================================================== */
+
 int
 SCK_RemoveSocket(int sock_fd)
 {
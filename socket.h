@@ -122,6 +122,11 @@ extern int SCK_GetIntOption(int sock_fd, int level, int name, int *value);
 /* Enable RX timestamping socket option */
 extern int SCK_EnableKernelRxTimestamping(int sock_fd);
 
+/* Enable busy polling of the device queue when receiving on the socket
+   (timeout in microseconds, optional budget in packets, and preference
+   of busy polling over interrupts) */
+extern int SCK_EnableBusyPolling(int sock_fd, int timeout, int budget, int prefer);
+
 /* Operate on a stream socket - listen()/accept()/shutdown() wrappers */
 extern int SCK_ListenOnSocket(int sock_fd, int backlog);
 extern int SCK_AcceptConnection(int sock_fd, IPSockAddr *remote_addr);
@@ -135,7 +140,12 @@ extern int SCK_Send(int sock_fd, const void *buffer, int length, int flags);
    a pointer to static buffers, or NULL on error.  The buffers are valid until
    another call of the functions and can be reused for sending messages. */
 extern SCK_Message *SCK_ReceiveMessage(int sock_fd, int flags);
-extern SCK_Message *SCK_ReceiveMessages(int sock_fd, int flags, int *num_messages);
+extern SCK_Message *SCK_ReceiveMessages(int sock_fd, int flags, int max_messages,
+                                        int *num_messages);
+
+/* Set the number of buffers available for receiving multiple messages.
+   The value is limited to the supported range and returned. */
+extern int SCK_SetMaxReceiveMessages(int max_messages);
 
 /* Initialise a new message (e.g. before sending) */
 extern void SCK_InitMessage(SCK_Message *message, SCK_AddressType addr_type);
@@ -143,6 +153,12 @@ extern void SCK_InitMessage(SCK_Message *message, SCK_AddressType addr_type);
 /* Send a message */
 extern int SCK_SendMessage(int sock_fd, SCK_Message *message, int flags);
 
+/* Send multiple messages (using a single system call if possible).  The
+   function returns the number of messages which were sent.  If sent is not
+   NULL, it is set for each message to 1 if it was sent, or 0 otherwise. */
+extern int SCK_SendMessages(int sock_fd, SCK_Message *messages, int num_messages, int flags,
+                            int *sent);
+
 /* Remove bound Unix socket */
 extern int SCK_RemoveSocket(int sock_fd);
 
@@ -154,6 +154,9 @@ struct SRC_Instance_Record {
   /* Flags indicating which status was already reported for
      the source since the last change of the system peer */
   char reported_status[SRC_SELECTED + 1];
+
+  /* Flag indicating the source has endpoints in the sort list */
+  int sorted;
 };
 
 /* ================================================== */
@@ -171,6 +174,8 @@ struct Sort_Element {
 /* Table of sources */
 static struct SRC_Instance_Record **sources;
 static struct Sort_Element *sort_list;
+static int n_sorted_endpoints; /* Number of sorted endpoints in sort_list
+                                  kept from the last selection */
 static int *sel_sources;
 static int n_sources; /* Number of sources currently in the table */
 static int max_n_sources; /* Capacity of the table */
@@ -196,6 +201,10 @@ static int forced_first_report;   /* Flag to allow one failed selection to be
 /* Number of updates needed to trigger handling of bad sources */
 #define BAD_HANDLE_THRESHOLD 4
 
+/* Maximum number of moves per endpoint in the insertion sort before
+   switching to qsort() */
+#define MAX_SORT_MOVES 4
+
 static double max_distance;
 static double max_jitter;
 static int max_stratum;
@@ -227,6 +236,7 @@ static char get_status_char(SRC_Status status);
 void SRC_Initialise(void) {
   sources = NULL;
   sort_list = NULL;
+  n_sorted_endpoints = 0;
   sel_sources = NULL;
   n_sources = 0;
   max_n_sources = 0;
@@ -346,6 +356,9 @@ void SRC_DestroyInstance(SRC_Instance instance)
   --n_sources;
   Free(instance);
 
+  /* The indices in the sort list are no longer valid */
+  n_sorted_endpoints = 0;
+
   update_sel_options();
 
   if (selected_source_index > dead_index)
@@ -714,6 +727,33 @@ compare_sort_elements(const void *a, const void *b)
   }
 }
 
+/* ================================================== */
+/* Sort the endpoint list.  The endpoints are expected to be mostly in the
+   order from the last selection (the intervals move only slightly between
+   updates), so insertion sort is used first.  If it needs too many moves,
+   qsort() sorts the rest. */
+
+static void
+sort_endpoints(int n_endpoints)
+{
+  struct Sort_Element e;
+  int i, j, moves;
+
+  for (i = 1, moves = 0; i < n_endpoints; i++) {
+    e = sort_list[i];
+    for (j = i; j > 0 && compare_sort_elements(&sort_list[j - 1], &e) > 0; j--)
+      sort_list[j] = sort_list[j - 1];
+    sort_list[j] = e;
+
+    moves += i - j;
+    if (moves > MAX_SORT_MOVES * n_endpoints) {
+      qsort((void *) sort_list, n_endpoints, sizeof(struct Sort_Element),
+            compare_sort_elements);
+      return;
+    }
+  }
+}
+
 /* ================================================== */
 
 static char *
@@ -1147,6 +1187,28 @@ SRC_SelectSource(SRC_Instance updated_inst)
     }
   }
 
+  /* Keep the endpoints of selectable sources in the order from the last
+     selection and update their offsets */
+  for (i = 0; i < n_sources; i++)
+    sources[i]->sorted = 0;
+
+  for (i = n_endpoints = 0; i < n_sorted_endpoints; i++) {
+    index = sort_list[i].index;
+    assert(index >= 0 && index < n_sources);
+    if (sources[index]->status != SRC_OK)
+      continue;
+
+    si = &sources[index]->sel_info;
+
+    sort_list[n_endpoints] = sort_list[i];
+    sort_list[n_endpoints].offset = sort_list[i].tag == LOW ? si->lo_limit : si->hi_limit;
+    sources[index]->sorted = 1;
+    n_endpoints++;
+  }
+
+  n_sorted_endpoints = 0;
+
+  /* Add endpoints of the other selectable sources */
   for (i = 0; i < n_sources; i++) {
     if (sources[i]->status != SRC_OK)
       continue;
@@ -1154,6 +1216,9 @@ SRC_SelectSource(SRC_Instance updated_inst)
     if (sources[i]->sel_options & SRC_SELECT_TRUST)
       n_sel_trust_sources++;
 
+    if (sources[i]->sorted)
+      continue;
+
     si = &sources[i]->sel_info;
 
     j1 = n_endpoints;
@@ -1202,7 +1267,8 @@ SRC_SelectSource(SRC_Instance updated_inst)
   }
 
   /* Now sort the endpoint list */
-  qsort((void *) sort_list, n_endpoints, sizeof(struct Sort_Element), compare_sort_elements);
+  sort_endpoints(n_endpoints);
+  n_sorted_endpoints = n_endpoints;
 
   /* Now search for the interval which is contained in the most
      individual source intervals.  Any source which overlaps this
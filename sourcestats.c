@@ -39,9 +39,10 @@
 #include "local.h"
 
 /* ================================================== */
-/* Define the maxumum number of samples that we want
-   to store per source */
-#define MAX_SAMPLES 64
+/* Define the default and maximum configurable number of samples that we
+   want to store per source */
+#define DEFAULT_MAX_SAMPLES 64
+#define MAX_SAMPLES RGR_MAX_POINTS
 
 /* This is the assumed worst case bound on an unknown frequency,
    2000ppm, which would be pretty bad */
@@ -84,7 +85,8 @@ struct SST_Stats_Record {
   uint32_t refid;
   IPAddr *ip_addr;
 
-  /* User defined minimum and maximum number of samples */
+  /* User defined minimum and maximum number of samples.  The maximum
+     is also the size of the buffers. */
   int min_samples;
   int max_samples;
 
@@ -146,39 +148,51 @@ struct SST_Stats_Record {
   double std_dev;
 
   /* This array contains the sample epochs, in terms of the local
-     clock. */
-  struct timespec sample_times[MAX_SAMPLES * REGRESS_RUNS_RATIO];
+     clock.  This and the other arrays used in the runs test have
+     max_samples * REGRESS_RUNS_RATIO entries, the others have
+     max_samples entries. */
+  struct timespec *sample_times;
 
   /* This is an array of offsets, in seconds, corresponding to the
      sample times.  In this module, we use the convention that
      positive means the local clock is FAST of the source and negative
      means it is SLOW.  This is contrary to the convention in the NTP
      stuff. */
-  double offsets[MAX_SAMPLES * REGRESS_RUNS_RATIO];
+  double *offsets;
 
   /* This is an array of the offsets as originally measured.  Local
      clock fast of real time is indicated by positive values.  This
      array is not slewed to adjust the readings when we apply
      adjustments to the local clock, as is done for the array
      'offset'. */
-  double orig_offsets[MAX_SAMPLES];
+  double *orig_offsets;
 
   /* This is an array of peer delays, in seconds, being the roundtrip
      measurement delay to the peer */
-  double peer_delays[MAX_SAMPLES * REGRESS_RUNS_RATIO];
+  double *peer_delays;
 
   /* This is an array of peer dispersions, being the skew and local
      precision dispersion terms from sampling the peer */
-  double peer_dispersions[MAX_SAMPLES];
+  double *peer_dispersions;
 
   /* This array contains the root delays of each sample, in seconds */
-  double root_delays[MAX_SAMPLES];
+  double *root_delays;
 
   /* This array contains the root dispersions of each sample at the
      time of the measurements */
-  double root_dispersions[MAX_SAMPLES];
+  double *root_dispersions;
 };
 
+/* ================================================== */
+/* Buffer used in the regression, large enough for the instance with
+   the largest number of samples */
+
+static double *work_buffer;
+static int work_buffer_samples;
+
+/* Number of doubles needed in the work buffer per sample */
+#define WORK_BUFFER_RATIO (3 * REGRESS_RUNS_RATIO + 3)
+
 /* ================================================== */
 
 static void find_min_delay_sample(SST_Stats inst);
@@ -189,6 +203,9 @@ static int get_buf_index(SST_Stats inst, int i);
 void
 SST_Initialise(void)
 {
+  work_buffer = NULL;
+  work_buffer_samples = 0;
+
   logfileid = CNF_GetLogStatistics() ? LOG_FileOpen("statistics",
       "   Date (UTC) Time     IP Address    Std dev'n Est offset  Offset sd  Diff freq   Est skew  Stress  Ns  Bs  Nr  Asym")
     : -1;
@@ -199,6 +216,9 @@ SST_Initialise(void)
 void
 SST_Finalise(void)
 {
+  Free(work_buffer);
+  work_buffer = NULL;
+  work_buffer_samples = 0;
 }
 
 /* ================================================== */
@@ -209,10 +229,27 @@ SST_CreateInstance(uint32_t refid, IPAddr *addr, int min_samples, int max_sample
                    double min_delay, double asymmetry)
 {
   SST_Stats inst;
+  int n;
+
   inst = MallocNew(struct SST_Stats_Record);
 
-  inst->max_samples = max_samples > 0 ? CLAMP(1, max_samples, MAX_SAMPLES) : MAX_SAMPLES;
+  inst->max_samples = max_samples > 0 ? CLAMP(1, max_samples, MAX_SAMPLES) :
+                      DEFAULT_MAX_SAMPLES;
   inst->min_samples = CLAMP(1, min_samples, inst->max_samples);
+
+  n = inst->max_samples;
+  inst->sample_times = MallocArray(struct timespec, n * REGRESS_RUNS_RATIO);
+  inst->offsets = MallocArray(double, n * REGRESS_RUNS_RATIO);
+  inst->orig_offsets = MallocArray(double, n);
+  inst->peer_delays = MallocArray(double, n * REGRESS_RUNS_RATIO);
+  inst->peer_dispersions = MallocArray(double, n);
+  inst->root_delays = MallocArray(double, n);
+  inst->root_dispersions = MallocArray(double, n);
+
+  if (n > work_buffer_samples) {
+    work_buffer = ReallocArray(double, n * WORK_BUFFER_RATIO, work_buffer);
+    work_buffer_samples = n;
+  }
   inst->fixed_min_delay = min_delay;
   inst->fixed_asymmetry = asymmetry;
 
@@ -228,6 +265,13 @@ SST_CreateInstance(uint32_t refid, IPAddr *addr, int min_samples, int max_sample
 void
 SST_DeleteInstance(SST_Stats inst)
 {
+  Free(inst->sample_times);
+  Free(inst->offsets);
+  Free(inst->orig_offsets);
+  Free(inst->peer_delays);
+  Free(inst->peer_dispersions);
+  Free(inst->root_delays);
+  Free(inst->root_dispersions);
   Free(inst);
 }
 
@@ -279,7 +323,7 @@ prune_register(SST_Stats inst, int new_oldest)
   if (inst->runs_samples > inst->n_samples * (REGRESS_RUNS_RATIO - 1))
     inst->runs_samples = inst->n_samples * (REGRESS_RUNS_RATIO - 1);
   
-  assert(inst->n_samples + inst->runs_samples <= MAX_SAMPLES * REGRESS_RUNS_RATIO);
+  assert(inst->n_samples + inst->runs_samples <= inst->max_samples * REGRESS_RUNS_RATIO);
 
   find_min_delay_sample(inst);
 }
@@ -292,8 +336,7 @@ SST_AccumulateSample(SST_Stats inst, NTP_Sample *sample)
   int n, m;
 
   /* Make room for the new sample */
-  if (inst->n_samples > 0 &&
-      (inst->n_samples == MAX_SAMPLES || inst->n_samples == inst->max_samples)) {
+  if (inst->n_samples > 0 && inst->n_samples == inst->max_samples) {
     prune_register(inst, 1);
   }
 
@@ -306,8 +349,8 @@ SST_AccumulateSample(SST_Stats inst, NTP_Sample *sample)
   }
 
   n = inst->last_sample = (inst->last_sample + 1) %
-    (MAX_SAMPLES * REGRESS_RUNS_RATIO);
-  m = n % MAX_SAMPLES;
+    (inst->max_samples * REGRESS_RUNS_RATIO);
+  m = n % inst->max_samples;
 
   /* WE HAVE TO NEGATE OFFSET IN THIS CALL, IT IS HERE THAT THE SENSE OF OFFSET
      IS FLIPPED */
@@ -335,8 +378,8 @@ SST_AccumulateSample(SST_Stats inst, NTP_Sample *sample)
 static int
 get_runsbuf_index(SST_Stats inst, int i)
 {
-  return (unsigned int)(inst->last_sample + 2 * MAX_SAMPLES * REGRESS_RUNS_RATIO -
-      inst->n_samples + i + 1) % (MAX_SAMPLES * REGRESS_RUNS_RATIO);
+  return (unsigned int)(inst->last_sample + 2 * inst->max_samples * REGRESS_RUNS_RATIO -
+      inst->n_samples + i + 1) % (inst->max_samples * REGRESS_RUNS_RATIO);
 }
 
 /* ================================================== */
@@ -345,8 +388,24 @@ get_runsbuf_index(SST_Stats inst, int i)
 static int
 get_buf_index(SST_Stats inst, int i)
 {
-  return (unsigned int)(inst->last_sample + MAX_SAMPLES * REGRESS_RUNS_RATIO -
-      inst->n_samples + i + 1) % MAX_SAMPLES;
+  return (unsigned int)(inst->last_sample + inst->max_samples * REGRESS_RUNS_RATIO -
+      inst->n_samples + i + 1) % inst->max_samples;
+}
+
+/* ================================================== */
+/* Copy n values from a circular buffer of the specified size, starting
+   at index first, to a linear array */
+
+static void
+copy_from_ring(double *dst, const double *ring, int size, int first, int n)
+{
+  int n1;
+
+  assert(first >= 0 && first < size && n <= size);
+
+  n1 = MIN(n, size - first);
+  memcpy(dst, ring + first, sizeof (dst[0]) * n1);
+  memcpy(dst + n1, ring, sizeof (dst[0]) * (n - n1));
 }
 
 /* ================================================== */
@@ -357,13 +416,21 @@ get_buf_index(SST_Stats inst, int i)
 static void
 convert_to_intervals(SST_Stats inst, double *times_back)
 {
-  struct timespec *ts;
-  int i;
+  struct timespec *ts, *ts2;
+  int i, j;
 
   ts = &inst->sample_times[inst->last_sample];
+  j = get_runsbuf_index(inst, -inst->runs_samples);
+
   for (i = -inst->runs_samples; i < inst->n_samples; i++) {
-    /* The entries in times_back[] should end up negative */
-    times_back[i] = UTI_DiffTimespecsToDouble(&inst->sample_times[get_runsbuf_index(inst, i)], ts);
+    /* The entries in times_back[] should end up negative.  The difference
+       is calculated as in UTI_DiffTimespecsToDouble(). */
+    ts2 = &inst->sample_times[j];
+    times_back[i] = ((double)ts2->tv_sec - (double)ts->tv_sec) +
+                    1.0e-9 * (ts2->tv_nsec - ts->tv_nsec);
+
+    if (++j >= inst->max_samples * REGRESS_RUNS_RATIO)
+      j = 0;
   }
 }
 
@@ -407,15 +474,19 @@ find_best_sample_index(SST_Stats inst, double *times_back)
 static void
 find_min_delay_sample(SST_Stats inst)
 {
-  int i, index;
+  int i, j, n, min_j;
 
-  inst->min_delay_sample = get_runsbuf_index(inst, -inst->runs_samples);
+  n = inst->runs_samples + inst->n_samples;
+  j = min_j = get_runsbuf_index(inst, -inst->runs_samples);
 
-  for (i = -inst->runs_samples + 1; i < inst->n_samples; i++) {
-    index = get_runsbuf_index(inst, i);
-    if (inst->peer_delays[index] < inst->peer_delays[inst->min_delay_sample])
-      inst->min_delay_sample = index;
+  for (i = 1; i < n; i++) {
+    if (++j >= inst->max_samples * REGRESS_RUNS_RATIO)
+      j = 0;
+    if (inst->peer_delays[j] < inst->peer_delays[min_j])
+      min_j = j;
   }
+
+  inst->min_delay_sample = min_j;
 }
 
 /* ================================================== */
@@ -457,9 +528,9 @@ estimate_asymmetry(double *times_back, double *offsets, double *delays, int n,
 /* ================================================== */
 
 static void
-correct_asymmetry(SST_Stats inst, double *times_back, double *offsets)
+correct_asymmetry(SST_Stats inst, double *times_back, double *offsets, double *delays)
 {
-  double min_delay, delays[MAX_SAMPLES * REGRESS_RUNS_RATIO];
+  double min_delay;
   int i, n;
 
   /* Check if the asymmetry was not specified to be zero */
@@ -469,9 +540,10 @@ correct_asymmetry(SST_Stats inst, double *times_back, double *offsets)
   min_delay = SST_MinRoundTripDelay(inst);
   n = inst->runs_samples + inst->n_samples;
 
+  copy_from_ring(delays, inst->peer_delays, inst->max_samples * REGRESS_RUNS_RATIO,
+                 get_runsbuf_index(inst, -inst->runs_samples), n);
   for (i = 0; i < n; i++)
-    delays[i] = inst->peer_delays[get_runsbuf_index(inst, i - inst->runs_samples)] -
-                min_delay;
+    delays[i] -= min_delay;
 
   if (fabs(inst->fixed_asymmetry) <= MAX_ASYMMETRY) {
     inst->asymmetry = inst->fixed_asymmetry;
@@ -504,35 +576,44 @@ correct_asymmetry(SST_Stats inst, double *times_back, double *offsets)
 void
 SST_DoNewRegression(SST_Stats inst)
 {
-  double times_back[MAX_SAMPLES * REGRESS_RUNS_RATIO];
-  double offsets[MAX_SAMPLES * REGRESS_RUNS_RATIO];
-  double peer_distances[MAX_SAMPLES];
-  double weights[MAX_SAMPLES];
+  double *times_back, *offsets, *delays;
+  double *peer_distances, *peer_dispersions, *weights;
 
   int degrees_of_freedom;
   int best_start, times_back_start;
   double est_intercept, est_slope, est_var, est_intercept_sd, est_slope_sd;
-  int i, j, nruns;
+  int i, nruns;
   double min_distance, median_distance;
   double sd_weight, sd;
   double old_skew, old_freq, stress;
   double precision;
 
+  /* Split the work buffer */
+  assert(inst->max_samples <= work_buffer_samples);
+  times_back = work_buffer;
+  offsets = times_back + inst->max_samples * REGRESS_RUNS_RATIO;
+  delays = offsets + inst->max_samples * REGRESS_RUNS_RATIO;
+  peer_distances = delays + inst->max_samples * REGRESS_RUNS_RATIO;
+  peer_dispersions = peer_distances + inst->max_samples;
+  weights = peer_dispersions + inst->max_samples;
+
   convert_to_intervals(inst, times_back + inst->runs_samples);
 
   if (inst->n_samples > 0) {
-    for (i = -inst->runs_samples; i < inst->n_samples; i++) {
-      offsets[i + inst->runs_samples] = inst->offsets[get_runsbuf_index(inst, i)];
-    }
-  
-    for (i = 0, min_distance = DBL_MAX; i < inst->n_samples; i++) {
-      j = get_buf_index(inst, i);
-      peer_distances[i] = 0.5 * inst->peer_delays[get_runsbuf_index(inst, i)] +
-                          inst->peer_dispersions[j];
-      if (peer_distances[i] < min_distance) {
-        min_distance = peer_distances[i];
-      }
-    }
+    /* Linearise the circular buffers */
+    copy_from_ring(offsets, inst->offsets, inst->max_samples * REGRESS_RUNS_RATIO,
+                   get_runsbuf_index(inst, -inst->runs_samples),
+                   inst->runs_samples + inst->n_samples);
+    copy_from_ring(peer_distances, inst->peer_delays, inst->max_samples * REGRESS_RUNS_RATIO,
+                   get_runsbuf_index(inst, 0), inst->n_samples);
+    copy_from_ring(peer_dispersions, inst->peer_dispersions, inst->max_samples,
+                   get_buf_index(inst, 0), inst->n_samples);
+
+    for (i = 0; i < inst->n_samples; i++)
+      peer_distances[i] = 0.5 * peer_distances[i] + peer_dispersions[i];
+
+    for (i = 0, min_distance = DBL_MAX; i < inst->n_samples; i++)
+      min_distance = MIN(min_distance, peer_distances[i]);
 
     /* And now, work out the weight vector */
 
@@ -550,7 +631,7 @@ SST_DoNewRegression(SST_Stats inst)
       weights[i] = SQUARE(sd_weight);
     }
 
-    correct_asymmetry(inst, times_back, offsets);
+    correct_asymmetry(inst, times_back, offsets, delays);
   }
 
   inst->regression_ok = RGR_FindBestRegression(times_back + inst->runs_samples,
@@ -896,6 +977,12 @@ SST_LoadFromFile(SST_Stats inst, FILE *in)
 
   LCL_ReadCookedTime(&now, NULL);
 
+  /* Skip the oldest samples which don't fit in the buffers */
+  for (; n_samples > inst->max_samples; n_samples--) {
+    if (!fgets(line, sizeof (line), in))
+      return 0;
+  }
+
   for (i = 0; i < n_samples; i++) {
     if (!fgets(line, sizeof (line), in) ||
         sscanf(line, "%lf %lf %lf %lf %lf %lf %lf",
@@ -425,9 +425,14 @@ SYS_Linux_EnableSystemCallFilter(int level, SYS_ProcessContext context)
     SCMP_SYS(clock_gettime),
 #ifdef __NR_clock_gettime64
     SCMP_SYS(clock_gettime64),
+#endif
+    SCMP_SYS(clock_nanosleep),
+#ifdef __NR_clock_nanosleep_time64
+    SCMP_SYS(clock_nanosleep_time64),
 #endif
     SCMP_SYS(gettimeofday),
     SCMP_SYS(clock_settime),
+    SCMP_SYS(nanosleep),
     SCMP_SYS(time),
 
     /* Process */
@@ -524,6 +529,10 @@ SYS_Linux_EnableSystemCallFilter(int level, SYS_ProcessContext context)
     /* General I/O */
     SCMP_SYS(_newselect),
     SCMP_SYS(close),
+    SCMP_SYS(epoll_create1),
+    SCMP_SYS(epoll_ctl),
+    SCMP_SYS(epoll_pwait),
+    SCMP_SYS(epoll_wait),
     SCMP_SYS(open),
     SCMP_SYS(openat),
     SCMP_SYS(pipe),
@@ -589,6 +598,15 @@ SYS_Linux_EnableSystemCallFilter(int level, SYS_ProcessContext context)
     { SOL_SOCKET, SO_BINDTODEVICE },
 #endif
     { SOL_SOCKET, SO_BROADCAST }, { SOL_SOCKET, SO_REUSEADDR },
+#ifdef SO_BUSY_POLL
+    { SOL_SOCKET, SO_BUSY_POLL },
+#endif
+#ifdef SO_BUSY_POLL_BUDGET
+    { SOL_SOCKET, SO_BUSY_POLL_BUDGET },
+#endif
+#ifdef SO_PREFER_BUSY_POLL
+    { SOL_SOCKET, SO_PREFER_BUSY_POLL },
+#endif
 #ifdef SO_REUSEPORT
     { SOL_SOCKET, SO_REUSEPORT },
 #endif
@@ -62,6 +62,10 @@
 #include <sys/timex.h>
 #endif
 
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef HAVE_GETRANDOM
 #include <sys/random.h>
 #endif
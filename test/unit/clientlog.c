@@ -29,12 +29,277 @@ get_random64(void)
   return ((uint64_t)random() << 40) ^ ((uint64_t)random() << 20) ^ random();
 }
 
+static void
+check_slots(Shard *shard)
+{
+  unsigned int i, j, k, mask, index, slots;
+  uint32_t fingerprint, last_hit;
+  Counters *counters;
+  OldTable *table;
+  Record *record;
+  Slot *slot;
+
+  TEST_CHECK((uintptr_t)shard->slot_table % CACHE_LINE_SIZE == 0);
+
+  for (i = 0; i < ARR_GetSize(shard->records); i++) {
+    record = ARR_GetElement(shard->records, i);
+    slot = get_slot(shard, i);
+
+    if (i % SLOT_SIZE == 0) {
+      for (j = 0; j <= SLOT_SIZE; j++) {
+        fingerprint = j < SLOT_SIZE ? slot->fingerprints[j] : random();
+        mask = find_fingerprint(slot, fingerprint);
+        TEST_CHECK(j == SLOT_SIZE || mask & 1U << j);
+        TEST_CHECK(!mask || mask & 1U << get_first_bit(mask));
+        for (k = 0; k < SLOT_SIZE; k++)
+          TEST_CHECK(!(mask & 1U << k) == (slot->fingerprints[k] != fingerprint));
+      }
+    }
+
+    if (slot->fingerprints[i % SLOT_SIZE] == 0) {
+      TEST_CHECK(!get_shard_record_by_index(shard, i, &counters));
+      continue;
+    }
+
+    fingerprint = get_fingerprint(UTI_IPToHash(&record->ip_addr));
+    TEST_CHECK(get_shard(fingerprint) == shard);
+    TEST_CHECK(fingerprint % shard->slots == i / SLOT_SIZE);
+    TEST_CHECK(slot->fingerprints[i % SLOT_SIZE] == fingerprint);
+    TEST_CHECK(get_shard_record_by_index(shard, i, &counters) == record);
+    TEST_CHECK(counters == get_counters(shard, record));
+
+    for (j = 1, last_hit = record->last_hit[0]; j < MAX_SERVICES; j++) {
+      if (compare_ts(last_hit, record->last_hit[j]) < 0)
+        last_hit = record->last_hit[j];
+    }
+    TEST_CHECK(slot->last_hits[i % SLOT_SIZE] == last_hit);
+  }
+
+  TEST_CHECK(shard->n_old_tables <= MAX_OLD_TABLES);
+  TEST_CHECK(shard->n_old_tables > 0 || shard->migrated_slots == 0);
+
+  for (i = 0, index = ARR_GetSize(shard->records); i < shard->n_old_tables; i++) {
+    table = &shard->old_tables[i];
+    slots = i + 1 < shard->n_old_tables ? shard->old_tables[i + 1].slots : shard->slots;
+    TEST_CHECK(table->slots * 2 == slots);
+    TEST_CHECK(i > 0 || shard->migrated_slots < table->slots);
+
+    for (j = 0; j < table->slots * SLOT_SIZE; j++, index++) {
+      fingerprint = table->slot_table[j / SLOT_SIZE].fingerprints[j % SLOT_SIZE];
+      TEST_CHECK(fingerprint == 0 || i > 0 || j / SLOT_SIZE >= shard->migrated_slots);
+      TEST_CHECK(fingerprint == 0 || fingerprint % table->slots == j / SLOT_SIZE);
+      TEST_CHECK(!fingerprint == !get_shard_record_by_index(shard, index, &counters));
+    }
+  }
+
+  TEST_CHECK(index <= 2 * ARR_GetSize(shard->records));
+}
+
+static void
+test_growth(void)
+{
+  unsigned int i, j, prev_slots, expansions, old_tables, max_old_tables;
+  char conf[] = "clientloglimit 100000000";
+  uint64_t prev_slot_migrations;
+  struct timespec ts;
+  Shard *shard;
+  IPAddr ip;
+
+  CLG_Finalise();
+  CNF_ParseLine(NULL, 1, conf);
+  CLG_Initialise();
+
+  TEST_CHECK(n_shards == 1);
+  shard = &shards[0];
+
+  TEST_CHECK(max_slots >= 1U << 16);
+  UTI_ZeroTimespec(&ts);
+
+  for (i = max_old_tables = 0;
+       i < 2000000 && (shard->slots * 2 <= max_slots || shard->n_old_tables > 0); i++) {
+    prev_slots = shard->slots;
+    prev_slot_migrations = shard->slot_migrations;
+
+    TST_GetRandomAddress(&ip, IPADDR_UNSPEC, -1);
+    TEST_CHECK(CLG_LogServiceAccess(CLG_NTP, &ip, &ts) >= 0);
+    UTI_AddDoubleToTimespec(&ts, 1.0e-3, &ts);
+
+    for (expansions = 0; prev_slots << expansions < shard->slots; expansions++)
+      ;
+    old_tables = shard->n_old_tables + 1;
+    max_old_tables = MAX(max_old_tables, shard->n_old_tables);
+
+    /* Each lookup can migrate only a small number of slots, in order and
+       the slots of the address in each old table (again after expansion) */
+    TEST_CHECK(shard->slot_migrations - prev_slot_migrations <=
+               MIGRATION_SLOTS + (expansions + 1) * old_tables);
+
+    /* The table can be expanded before the previous migration was
+       finished, but no records can be dropped until the table has the
+       maximum size */
+    if (shard->slots != prev_slots) {
+      TEST_CHECK(shard->slots >= prev_slots * 2);
+      DEBUG_LOG("lookups %u shard->slots %u old tables %u",
+                i, shard->slots, shard->n_old_tables);
+      check_slots(shard);
+    }
+    if (shard->slots * 2 <= max_slots)
+      TEST_CHECK(shard->record_drops == 0);
+
+    if (i % 100000 == 0)
+      check_slots(shard);
+  }
+
+  DEBUG_LOG("max old tables %u", max_old_tables);
+  TEST_CHECK(shard->slots * 2 > max_slots);
+  TEST_CHECK(shard->n_old_tables == 0);
+  check_slots(shard);
+
+  CLG_Finalise();
+  CLG_Initialise();
+  shard = &shards[0];
+
+  /* Fill a slot of the new table before the migration is finished,
+     and repeat it with the expanded table */
+  while (shard->n_old_tables == 0 || shard->old_tables[0].slots < 32 * MIGRATION_SLOTS) {
+    TST_GetRandomAddress(&ip, IPADDR_UNSPEC, -1);
+    TEST_CHECK(CLG_LogServiceAccess(CLG_NTP, &ip, &ts) >= 0);
+  }
+
+  for (j = 1; j <= 2; j++) {
+    prev_slots = shard->slots;
+
+    for (i = 0; i <= SLOT_SIZE; ) {
+      TST_GetRandomAddress(&ip, IPADDR_UNSPEC, -1);
+      if (get_fingerprint(UTI_IPToHash(&ip)) % prev_slots != 0)
+        continue;
+      TEST_CHECK(shard->n_old_tables >= j);
+      prev_slot_migrations = shard->slot_migrations;
+      TEST_CHECK(CLG_LogServiceAccess(CLG_NTP, &ip, &ts) >= 0);
+      for (expansions = 0; prev_slots << expansions < shard->slots; expansions++)
+        ;
+      TEST_CHECK(shard->slot_migrations - prev_slot_migrations <=
+                 MIGRATION_SLOTS + (expansions + 1) * (shard->n_old_tables + 1));
+      i++;
+    }
+
+    TEST_CHECK(shard->slots >= prev_slots * 2);
+    TEST_CHECK(shard->n_old_tables >= j + 1);
+    TEST_CHECK(shard->record_drops == 0);
+    check_slots(shard);
+  }
+}
+
+static void
+test_shards(void)
+{
+  uint64_t prev_ntp_drops, prev_ntp_hits;
+  RPT_ClientAccessByIndex_Report report;
+  int i, j, k, n, index, hits, drops, report_drops;
+  RPT_ServerStatsReport stats;
+  char conf[] = "serverthreads 3";
+  struct timespec ts, ts2;
+  NTP_Timestamp_Source ts_src;
+  IPAddr ips[1000];
+  NTP_int64 ntp_ts;
+  Shard *shard;
+
+  CLG_Finalise();
+  CNF_ParseLine(NULL, 1, conf);
+  CLG_Initialise();
+
+  TEST_CHECK(n_shards == 4);
+
+  CLG_GetServerStatsReport(&stats);
+  prev_ntp_hits = stats.ntp_hits;
+  prev_ntp_drops = stats.ntp_drops;
+
+  UTI_ZeroTimespec(&ts);
+
+  for (i = hits = drops = 0; i < 1000; i++) {
+    TST_GetRandomAddress(&ips[i], IPADDR_UNSPEC, -1);
+    shard = get_shard(get_fingerprint(UTI_IPToHash(&ips[i])));
+
+    /* All requests of a client are limited in the same shard */
+    for (j = 0; j < i % 10 + 1; j++, hits++) {
+      index = CLG_LogServiceAccess(CLG_NTP, &ips[i], &ts);
+      TEST_CHECK(index >= 0);
+      TEST_CHECK(&shards[index % n_shards] == shard);
+      TEST_CHECK(index == CLG_GetClientIndex(&ips[i]));
+      if (CLG_LimitServiceRate(CLG_NTP, index) == CLG_DROP)
+        drops++;
+    }
+
+    UTI_AddDoubleToTimespec(&ts, 1.0e-3, &ts);
+
+    int64_to_ntp64(i + 1, &ntp_ts);
+    CLG_SaveNtpTimestamps(&ips[i], &ntp_ts, &ts, NTP_TS_DAEMON);
+  }
+
+  for (i = 0; i < n_shards; i++) {
+    check_slots(&shards[i]);
+    TEST_CHECK(shards[i].ntp_ts_map.size > 0);
+  }
+
+  /* The reports need to include all clients of all shards */
+  n = CLG_GetNumberOfIndices();
+  TEST_CHECK(n % n_shards == 0);
+
+  for (i = k = report_drops = 0; i < n; i++) {
+    if (!CLG_GetClientAccessReportByIndex(i, 0, 0, &report, &ts))
+      continue;
+
+    for (j = 0; j < 1000; j++) {
+      if (UTI_CompareIPs(&report.ip_addr, &ips[j], NULL) == 0)
+        break;
+    }
+    TEST_CHECK(j < 1000);
+    TEST_CHECK(report.ntp_hits == j % 10 + 1);
+    k++;
+    report_drops += report.ntp_drops;
+  }
+
+  TEST_CHECK(k == 1000);
+  TEST_CHECK(report_drops == drops);
+  TEST_CHECK(drops > 0);
+
+  CLG_GetServerStatsReport(&stats);
+  TEST_CHECK(stats.ntp_hits - prev_ntp_hits == hits);
+  TEST_CHECK(stats.ntp_drops - prev_ntp_drops == drops);
+  TEST_CHECK(stats.ntp_timestamps == 1000);
+  TEST_CHECK(stats.log_drops == 0);
+
+  /* Timestamps are saved in the shard of the client */
+  for (i = 0; i < 1000; i++) {
+    int64_to_ntp64(i + 1, &ntp_ts);
+    TEST_CHECK(CLG_GetNtpTxTimestamp(&ips[i], &ntp_ts, &ts2, &ts_src));
+    j = (i + 1) % 1000;
+    TEST_CHECK(!CLG_GetNtpTxTimestamp(&ips[j], &ntp_ts, &ts2, &ts_src) ||
+               get_shard(get_fingerprint(UTI_IPToHash(&ips[i]))) ==
+               get_shard(get_fingerprint(UTI_IPToHash(&ips[j]))));
+  }
+
+  /* A shard can use more than its equal part of the limit */
+  for (i = 0; i < 1000000 && shards[0].slots <= max_slots / n_shards; i++) {
+    TST_GetRandomAddress(&ips[0], IPADDR_UNSPEC, -1);
+    if (get_shard(get_fingerprint(UTI_IPToHash(&ips[0]))) != &shards[0])
+      continue;
+    if (CLG_LogAndLimitServiceAccess(CLG_NTP, &ips[0], &ts, &k) != CLG_DROP)
+      TEST_CHECK(k);
+  }
+
+  TEST_CHECK(shards[0].slots > max_slots / n_shards);
+  TEST_CHECK(total_slots <= max_slots);
+  CLG_GetServerStatsReport(&stats);
+  TEST_CHECK(stats.log_drops == 0);
+}
+
 static int bench(char *opts)
 {
   struct timespec ts, ts_start, ts_end;
   int i, index, iters, bits;
+  char *s, limit[64];
   IPAddr ip;
-  char *s;
 
   s = strchr(opts, ':');
   if (!s)
@@ -44,6 +309,14 @@ static int bench(char *opts)
   iters = atoi(opts);
   bits = atoi(s + 1);
 
+  s = strchr(s + 1, ':');
+  if (s) {
+    snprintf(limit, sizeof (limit), "clientloglimit %s", s + 1);
+    CLG_Finalise();
+    CNF_ParseLine(NULL, 1, limit);
+    CLG_Initialise();
+  }
+
   UTI_ZeroTimespec(&ts);
 
   clock_gettime(CLOCK_MONOTONIC, &ts_start);
@@ -70,6 +343,7 @@ test_unit(void)
   int i, j, k, kod, passes, kods, drops, index, shift;
   uint32_t index2, prev_first, prev_size;
   NTP_Timestamp_Source ts_src, ts_src2;
+  NtpTimestampMap *map;
   struct timespec ts, ts2;
   CLG_Service s;
   NTP_int64 ntp_ts;
@@ -88,7 +362,7 @@ test_unit(void)
   LCL_Initialise();
   CLG_Initialise();
 
-  TEST_CHECK(ARR_GetSize(records) == 8);
+  TEST_CHECK(ARR_GetSize(shards[0].records) == 8);
 
   TST_GetRandomAddress(&ip, IPADDR_INET4, 8);
   while (UTI_CompareIPs(&ip, &ip2, NULL) == 0)
@@ -102,7 +376,7 @@ test_unit(void)
   TEST_CHECK(is_ip_equal(&ip, &ip));
   TEST_CHECK(!is_ip_equal(&ip, &ip2));
 
-  /* Expected format of the variable: ITERS:BITS */
+  /* Expected format of the variable: ITERS:BITS[:CLIENTLOGLIMIT] */
   if ((env = getenv("BENCH_CLIENTLOG"))) {
     exit(!bench(env));
   }
@@ -124,10 +398,13 @@ test_unit(void)
 
       UTI_AddDoubleToTimespec(&ts, (1 << random() % 14) / 100.0, &ts);
     }
+
+    check_slots(&shards[0]);
   }
 
-  DEBUG_LOG("records %u", ARR_GetSize(records));
-  TEST_CHECK(ARR_GetSize(records) == 128);
+  DEBUG_LOG("records %u", ARR_GetSize(shards[0].records));
+  TEST_CHECK(ARR_GetSize(shards[0].records) == 128);
+  TEST_CHECK(shards[0].n_old_tables == 0);
 
   for (kod = 0; kod <= 2; kod += 2) {
     for (s = CLG_NTP; s <= CLG_CMDMON; s++) {
@@ -174,17 +451,19 @@ test_unit(void)
     }
   }
 
-  TEST_CHECK(!ntp_ts_map.timestamps);
+  TEST_CHECK(n_shards == 1);
+  map = &shards[0].ntp_ts_map;
+  TEST_CHECK(!map->timestamps);
 
   UTI_ZeroNtp64(&ntp_ts);
-  CLG_SaveNtpTimestamps(&ntp_ts, NULL, 0);
-  TEST_CHECK(ntp_ts_map.timestamps);
-  TEST_CHECK(ntp_ts_map.first == 0);
-  TEST_CHECK(ntp_ts_map.size == 0);
-  TEST_CHECK(ntp_ts_map.max_size == 128);
-  TEST_CHECK(ARR_GetSize(ntp_ts_map.timestamps) == ntp_ts_map.max_size);
+  CLG_SaveNtpTimestamps(&ip, &ntp_ts, NULL, 0);
+  TEST_CHECK(map->timestamps);
+  TEST_CHECK(map->first == 0);
+  TEST_CHECK(map->size == 0);
+  TEST_CHECK(map->max_size == 128);
+  TEST_CHECK(ARR_GetSize(map->timestamps) == map->max_size);
 
-  TEST_CHECK(ntp_ts_map.max_size > NTPTS_INSERT_LIMIT);
+  TEST_CHECK(map->max_size > NTPTS_INSERT_LIMIT);
 
   for (i = 0; i < 200; i++) {
     DEBUG_LOG("iteration %d", i);
@@ -193,12 +472,12 @@ test_unit(void)
     ts64 = 0ULL - 100 * max_step;
 
     if (i > 150)
-      ntp_ts_map.max_size = 1U << (i % 8);
-    assert(ntp_ts_map.max_size <= 128);
-    ntp_ts_map.first = i % ntp_ts_map.max_size;
-    ntp_ts_map.size = 0;
-    ntp_ts_map.cached_rx_ts = 0ULL;
-    ntp_ts_map.slew_epoch = i * 400;
+      map->max_size = 1U << (i % 8);
+    assert(map->max_size <= 128);
+    map->first = i % map->max_size;
+    map->size = 0;
+    map->cached_rx_ts = 0ULL;
+    map->slew_epoch = i * 400;
 
     for (j = 0; j < 500; j++) {
       do {
@@ -215,74 +494,74 @@ test_unit(void)
       }
 
       ts_src = random() % (MAX_NTP_TS + 1);
-      CLG_SaveNtpTimestamps(&ntp_ts,
+      CLG_SaveNtpTimestamps(&ip, &ntp_ts,
                             UTI_IsZeroTimespec(&ts) ? (random() % 2 ? &ts : NULL) : &ts,
                             ts_src);
 
-      if (j < ntp_ts_map.max_size) {
-        TEST_CHECK(ntp_ts_map.size == j + 1);
-        TEST_CHECK(ntp_ts_map.first == i % ntp_ts_map.max_size);
+      if (j < map->max_size) {
+        TEST_CHECK(map->size == j + 1);
+        TEST_CHECK(map->first == i % map->max_size);
       } else {
-        TEST_CHECK(ntp_ts_map.size == ntp_ts_map.max_size);
-        TEST_CHECK(ntp_ts_map.first == (i + j + ntp_ts_map.size + 1) % ntp_ts_map.max_size);
+        TEST_CHECK(map->size == map->max_size);
+        TEST_CHECK(map->first == (i + j + map->size + 1) % map->max_size);
       }
-      TEST_CHECK(ntp_ts_map.cached_index == ntp_ts_map.size - 1);
-      TEST_CHECK(get_ntp_tss(ntp_ts_map.size - 1)->slew_epoch == ntp_ts_map.slew_epoch);
-      TEST_CHECK(CLG_GetNtpTxTimestamp(&ntp_ts, &ts2, &ts_src2));
+      TEST_CHECK(map->cached_index == map->size - 1);
+      TEST_CHECK(get_ntp_tss(map, map->size - 1)->slew_epoch == map->slew_epoch);
+      TEST_CHECK(CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts2, &ts_src2));
       TEST_CHECK(UTI_CompareTimespecs(&ts, &ts2) == 0);
       TEST_CHECK(UTI_IsZeroTimespec(&ts) || ts_src == ts_src2);
 
       for (k = random() % 4; k > 0; k--) {
-        index2 = random() % ntp_ts_map.size;
-        int64_to_ntp64(get_ntp_tss(index2)->rx_ts, &ntp_ts);
+        index2 = random() % map->size;
+        int64_to_ntp64(get_ntp_tss(map, index2)->rx_ts, &ntp_ts);
         if (random() % 2)
-          TEST_CHECK(CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2));
+          TEST_CHECK(CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2));
 
         UTI_Ntp64ToTimespec(&ntp_ts, &ts);
         UTI_AddDoubleToTimespec(&ts, TST_GetRandomDouble(-1.999, 1.999), &ts);
 
         ts2 = ts;
-        CLG_UndoNtpTxTimestampSlew(&ntp_ts, &ts);
-        if ((get_ntp_tss(index2)->slew_epoch + 1) % (1U << 16) != ntp_ts_map.slew_epoch) {
+        CLG_UndoNtpTxTimestampSlew(&ip, &ntp_ts, &ts);
+        if ((get_ntp_tss(map, index2)->slew_epoch + 1) % (1U << 16) != map->slew_epoch) {
           TEST_CHECK(UTI_CompareTimespecs(&ts, &ts2) == 0);
         } else {
-          TEST_CHECK(fabs(UTI_DiffTimespecsToDouble(&ts, &ts2) - ntp_ts_map.slew_offset) <
+          TEST_CHECK(fabs(UTI_DiffTimespecsToDouble(&ts, &ts2) - map->slew_offset) <
                      1.0e-9);
         }
 
         ts_src = random() % (MAX_NTP_TS + 1);
-        CLG_UpdateNtpTxTimestamp(&ntp_ts, &ts, ts_src);
+        CLG_UpdateNtpTxTimestamp(&ip, &ntp_ts, &ts, ts_src);
 
-        TEST_CHECK(CLG_GetNtpTxTimestamp(&ntp_ts, &ts2, &ts_src2));
+        TEST_CHECK(CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts2, &ts_src2));
         TEST_CHECK(UTI_CompareTimespecs(&ts, &ts2) == 0);
         TEST_CHECK(ts_src == ts_src2);
 
         if (random() % 2) {
-          uint16_t prev_epoch = ntp_ts_map.slew_epoch;
+          uint16_t prev_epoch = map->slew_epoch;
           handle_slew(NULL, NULL, 0.0, TST_GetRandomDouble(-1.0e-5, 1.0e-5),
                       LCL_ChangeAdjust, NULL);
-          TEST_CHECK((prev_epoch + 1) % (1U << 16) == ntp_ts_map.slew_epoch);
+          TEST_CHECK((prev_epoch + 1) % (1U << 16) == map->slew_epoch);
         }
 
-        if (ntp_ts_map.size > 1) {
-          index = random() % (ntp_ts_map.size - 1);
-          if (get_ntp_tss(index)->rx_ts + 1 != get_ntp_tss(index + 1)->rx_ts) {
-            int64_to_ntp64(get_ntp_tss(index)->rx_ts + 1, &ntp_ts);
-            TEST_CHECK(!CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2));
-            int64_to_ntp64(get_ntp_tss(index + 1)->rx_ts - 1, &ntp_ts);
-            TEST_CHECK(!CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2));
-            CLG_UpdateNtpTxTimestamp(&ntp_ts, &ts, ts_src);
-            CLG_UndoNtpTxTimestampSlew(&ntp_ts, &ts);
+        if (map->size > 1) {
+          index = random() % (map->size - 1);
+          if (get_ntp_tss(map, index)->rx_ts + 1 != get_ntp_tss(map, index + 1)->rx_ts) {
+            int64_to_ntp64(get_ntp_tss(map, index)->rx_ts + 1, &ntp_ts);
+            TEST_CHECK(!CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2));
+            int64_to_ntp64(get_ntp_tss(map, index + 1)->rx_ts - 1, &ntp_ts);
+            TEST_CHECK(!CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2));
+            CLG_UpdateNtpTxTimestamp(&ip, &ntp_ts, &ts, ts_src);
+            CLG_UndoNtpTxTimestampSlew(&ip, &ntp_ts, &ts);
           }
         }
 
         if (random() % 2) {
-          int64_to_ntp64(get_ntp_tss(0)->rx_ts - 1, &ntp_ts);
-          TEST_CHECK(!CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2));
-          int64_to_ntp64(get_ntp_tss(ntp_ts_map.size - 1)->rx_ts + 1, &ntp_ts);
-          TEST_CHECK(!CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2));
-          CLG_UpdateNtpTxTimestamp(&ntp_ts, &ts, ts_src);
-          CLG_UndoNtpTxTimestampSlew(&ntp_ts, &ts);
+          int64_to_ntp64(get_ntp_tss(map, 0)->rx_ts - 1, &ntp_ts);
+          TEST_CHECK(!CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2));
+          int64_to_ntp64(get_ntp_tss(map, map->size - 1)->rx_ts + 1, &ntp_ts);
+          TEST_CHECK(!CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2));
+          CLG_UpdateNtpTxTimestamp(&ip, &ntp_ts, &ts, ts_src);
+          CLG_UndoNtpTxTimestampSlew(&ip, &ntp_ts, &ts);
         }
       }
     }
@@ -291,19 +570,19 @@ test_unit(void)
       shift = (i % 3) * 26;
 
       if (i % 7 == 0) {
-        while (ntp_ts_map.size < ntp_ts_map.max_size) {
+        while (map->size < map->max_size) {
           ts64 += get_random64() >> (shift + 8);
           int64_to_ntp64(ts64, &ntp_ts);
-          CLG_SaveNtpTimestamps(&ntp_ts, NULL, 0);
-          if (ntp_ts_map.cached_index + NTPTS_INSERT_LIMIT < ntp_ts_map.size)
-            ts64 = get_ntp_tss(ntp_ts_map.size - 1)->rx_ts;
+          CLG_SaveNtpTimestamps(&ip, &ntp_ts, NULL, 0);
+          if (map->cached_index + NTPTS_INSERT_LIMIT < map->size)
+            ts64 = get_ntp_tss(map, map->size - 1)->rx_ts;
         }
       }
       do {
-        if (ntp_ts_map.size > 1 && random() % 2) {
-          k = random() % (ntp_ts_map.size - 1);
-          ts64 = get_ntp_tss(k)->rx_ts +
-                 (get_ntp_tss(k + 1)->rx_ts - get_ntp_tss(k)->rx_ts) / 2;
+        if (map->size > 1 && random() % 2) {
+          k = random() % (map->size - 1);
+          ts64 = get_ntp_tss(map, k)->rx_ts +
+                 (get_ntp_tss(map, k + 1)->rx_ts - get_ntp_tss(map, k)->rx_ts) / 2;
         } else {
           ts64 = get_random64() >> shift;
         }
@@ -311,61 +590,65 @@ test_unit(void)
 
       int64_to_ntp64(ts64, &ntp_ts);
 
-      prev_first = ntp_ts_map.first;
-      prev_size = ntp_ts_map.size;
-      prev_first_ts64 = get_ntp_tss(0)->rx_ts;
-      prev_last_ts64 = get_ntp_tss(prev_size - 1)->rx_ts;
-      CLG_SaveNtpTimestamps(&ntp_ts, NULL, 0);
+      prev_first = map->first;
+      prev_size = map->size;
+      prev_first_ts64 = get_ntp_tss(map, 0)->rx_ts;
+      prev_last_ts64 = get_ntp_tss(map, prev_size - 1)->rx_ts;
+      CLG_SaveNtpTimestamps(&ip, &ntp_ts, NULL, 0);
 
-      TEST_CHECK(find_ntp_rx_ts(ts64, &index2));
+      TEST_CHECK(find_ntp_rx_ts(map, ts64, &index2));
 
-      if (ntp_ts_map.size > 1) {
-        TEST_CHECK(ntp_ts_map.size > 0 && ntp_ts_map.size <= ntp_ts_map.max_size);
-        if (get_ntp_tss(index2)->flags & NTPTS_DISABLED)
+      if (map->size > 1) {
+        TEST_CHECK(map->size > 0 && map->size <= map->max_size);
+        if (get_ntp_tss(map, index2)->flags & NTPTS_DISABLED)
           continue;
 
-        TEST_CHECK(get_ntp_tss(ntp_ts_map.size - 1)->rx_ts - ts64 <= NTPTS_FUTURE_LIMIT);
+        TEST_CHECK(get_ntp_tss(map, map->size - 1)->rx_ts - ts64 <= NTPTS_FUTURE_LIMIT);
 
         if ((int64_t)(prev_last_ts64 - ts64) <= NTPTS_FUTURE_LIMIT) {
-          TEST_CHECK(prev_size + 1 >= ntp_ts_map.size);
-          if (index2 + NTPTS_INSERT_LIMIT + 1 >= ntp_ts_map.size &&
-              !(index2 == 0 && NTPTS_INSERT_LIMIT < ntp_ts_map.max_size &&
+          TEST_CHECK(prev_size + 1 >= map->size);
+          if (index2 + NTPTS_INSERT_LIMIT + 1 >= map->size &&
+              !(index2 == 0 && NTPTS_INSERT_LIMIT < map->max_size &&
                 ((NTPTS_INSERT_LIMIT == prev_size && (int64_t)(ts64 - prev_first_ts64) > 0) ||
                  (NTPTS_INSERT_LIMIT + 1 == prev_size && (int64_t)(ts64 - prev_first_ts64) < 0))))
-            TEST_CHECK((prev_first + prev_size + 1) % ntp_ts_map.max_size ==
-                       (ntp_ts_map.first + ntp_ts_map.size) % ntp_ts_map.max_size);
+            TEST_CHECK((prev_first + prev_size + 1) % map->max_size ==
+                       (map->first + map->size) % map->max_size);
           else
-            TEST_CHECK(prev_first + prev_size == ntp_ts_map.first + ntp_ts_map.size);
+            TEST_CHECK(prev_first + prev_size == map->first + map->size);
         }
 
-        TEST_CHECK((int64_t)(get_ntp_tss(ntp_ts_map.size - 1)->rx_ts -
-                             get_ntp_tss(0)->rx_ts) > 0);
-        for (k = 0; k + 1 < ntp_ts_map.size; k++)
-          TEST_CHECK((int64_t)(get_ntp_tss(k + 1)->rx_ts - get_ntp_tss(k)->rx_ts) > 0);
+        TEST_CHECK((int64_t)(get_ntp_tss(map, map->size - 1)->rx_ts -
+                             get_ntp_tss(map, 0)->rx_ts) > 0);
+        for (k = 0; k + 1 < map->size; k++)
+          TEST_CHECK((int64_t)(get_ntp_tss(map, k + 1)->rx_ts -
+                               get_ntp_tss(map, k)->rx_ts) > 0);
       }
 
       if (random() % 10 == 0) {
-        CLG_DisableNtpTimestamps(&ntp_ts);
-        TEST_CHECK(!CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2));
+        CLG_DisableNtpTimestamps(&ip, &ntp_ts);
+        TEST_CHECK(!CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2));
       }
 
       for (k = random() % 10; k > 0; k--) {
         ts64 = get_random64() >> shift;
         int64_to_ntp64(ts64, &ntp_ts);
-        CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2);
+        CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2);
       }
     }
 
     if (random() % 2) {
       handle_slew(NULL, NULL, 0.0, TST_GetRandomDouble(-1.0e9, 1.0e9),
                   LCL_ChangeUnknownStep, NULL);
-      TEST_CHECK(ntp_ts_map.size == 0);
-      TEST_CHECK(ntp_ts_map.cached_rx_ts == 0ULL);
-      TEST_CHECK(!CLG_GetNtpTxTimestamp(&ntp_ts, &ts, &ts_src2));
-      CLG_UpdateNtpTxTimestamp(&ntp_ts, &ts, ts_src);
+      TEST_CHECK(map->size == 0);
+      TEST_CHECK(map->cached_rx_ts == 0ULL);
+      TEST_CHECK(!CLG_GetNtpTxTimestamp(&ip, &ntp_ts, &ts, &ts_src2));
+      CLG_UpdateNtpTxTimestamp(&ip, &ntp_ts, &ts, ts_src);
     }
   }
 
+  test_growth();
+  test_shards();
+
   CLG_Finalise();
   LCL_Finalise();
   CNF_Finalise();
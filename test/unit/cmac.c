@@ -36,6 +36,55 @@ struct cmac_test {
   int hash_length;
 };
 
+/* Lengths of NTP packets with no extension fields, and 100, 500, and 1000
+   bytes of extension fields */
+static int bench_lengths[] = { 48, 148, 548, 1048, 0 };
+
+static int
+bench(char *opts, struct cmac_test *tests)
+{
+  unsigned char data[1048], hash[MAX_HASH_LENGTH];
+  struct timespec ts_start, ts_end;
+  int i, j, k, iters, sum;
+  CMC_Instance inst;
+  double time;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  memset(data, 2, sizeof (data));
+  sum = 0;
+
+  printf("\n");
+
+  for (i = 0; tests[i].name[0] != '\0'; i++) {
+    inst = CMC_CreateInstance(UTI_CmacNameToAlgorithm(tests[i].name),
+                              tests[i].key, tests[i].key_length);
+    if (!inst)
+      return 0;
+
+    for (j = 0; bench_lengths[j] > 0; j++) {
+      clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+      for (k = 0; k < iters; k++) {
+        sum += CMC_Hash(inst, data, bench_lengths[j], hash, sizeof (hash));
+        data[0] = hash[0];
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+      time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+      printf("%-6s %4d bytes: %8.1f ns %10.0f ops/s\n",
+             tests[i].name, bench_lengths[j], time * 1.0e9, 1.0 / time);
+    }
+
+    CMC_DestroyInstance(inst);
+  }
+
+  return sum != 0;
+}
+
 void
 test_unit(void)
 {
@@ -53,11 +102,17 @@ test_unit(void)
   CMC_Algorithm algorithm;
   CMC_Instance inst;
   int i, j, length;
+  char *env;
 
 #ifndef HAVE_CMAC
   TEST_REQUIRE(0);
 #endif
 
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_CMAC"))) {
+    exit(!bench(env, tests));
+  }
+
   TEST_CHECK(CMC_INVALID == 0);
 
   for (i = 0; tests[i].name[0] != '\0'; i++) {
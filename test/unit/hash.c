@@ -31,12 +31,82 @@ struct hash_test {
   int length;
 };
 
+/* Lengths of NTP packets with no extension fields, and 100, 500, and 1000
+   bytes of extension fields */
+static int bench_lengths[] = { 48, 148, 548, 1048, 0 };
+
+static int
+bench(char *opts, struct hash_test *tests)
+{
+  unsigned char key[64], data[1048], out[MAX_HASH_LENGTH];
+  struct timespec ts_start, ts_end;
+  int i, j, k, iters, hash_id, sum;
+  HSH_Prefix prefix;
+  double time;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  memset(key, 1, sizeof (key));
+  memset(data, 2, sizeof (data));
+  sum = 0;
+
+  printf("\n");
+
+  for (i = 0; tests[i].name[0] != '\0'; i++) {
+    hash_id = HSH_GetHashId(UTI_HashNameToAlgorithm(tests[i].name));
+    if (hash_id < 0)
+      continue;
+
+    for (j = 0; bench_lengths[j] > 0; j++) {
+      clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+      /* Hash the key followed by the packet as for an NTP MAC */
+      for (k = 0; k < iters; k++) {
+        sum += HSH_Hash(hash_id, key, sizeof (key), data, bench_lengths[j], out, sizeof (out));
+        data[0] = out[0];
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+      time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+      printf("%-9s %4d bytes: %8.1f ns %10.0f ops/s\n",
+             tests[i].name, bench_lengths[j], time * 1.0e9, 1.0 / time);
+    }
+
+    /* Hash the packet with the key hashed in advance */
+    prefix = HSH_CreatePrefix(hash_id, key, sizeof (key));
+    if (!prefix)
+      continue;
+
+    for (j = 0; bench_lengths[j] > 0; j++) {
+      clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+      for (k = 0; k < iters; k++) {
+        sum += HSH_HashWithPrefix(prefix, data, bench_lengths[j], out, sizeof (out));
+        data[0] = out[0];
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+      time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+      printf("%-9s %4d bytes: %8.1f ns %10.0f ops/s (prefix)\n",
+             tests[i].name, bench_lengths[j], time * 1.0e9, 1.0 / time);
+    }
+
+    HSH_DestroyPrefix(prefix);
+  }
+
+  return sum != 0;
+}
+
 void
 test_unit(void)
 {
   unsigned char data1[] = "abcdefghijklmnopqrstuvwxyz";
   unsigned char data2[] = "12345678910";
-  unsigned char out[MAX_HASH_LENGTH];
+  unsigned char data3[300], out[MAX_HASH_LENGTH], out2[MAX_HASH_LENGTH];
   struct hash_test tests[] = {
     { "MD5-NC",    "\xfc\x24\x97\x1b\x52\x66\xdc\x46\xef\xe0\xe8\x08\x46\x89\xb6\x88", 16 },
     { "MD5",       "\xfc\x24\x97\x1b\x52\x66\xdc\x46\xef\xe0\xe8\x08\x46\x89\xb6\x88", 16 },
@@ -72,7 +142,14 @@ test_unit(void)
   };
 
   HSH_Algorithm algorithm;
-  int i, j, hash_id, length;
+  int i, j, k, hash_id, length;
+  HSH_Prefix prefix;
+  char *env;
+
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_HASH"))) {
+    exit(!bench(env, tests));
+  }
 
   TEST_CHECK(HSH_INVALID == 0);
 
@@ -125,6 +202,34 @@ test_unit(void)
                         out, sizeof (out));
       TEST_CHECK(length == tests[i].length);
     }
+
+    /* Prefixes hashed in advance (supported only if longer than the block) */
+    for (j = 0; j < sizeof (data3); j++)
+      data3[j] = random() % 256;
+
+    for (j = 0; j < 1000; j++) {
+      length = random() % sizeof (data3);
+      prefix = HSH_CreatePrefix(hash_id, data3, length);
+      if (!prefix)
+        continue;
+
+      TEST_CHECK(HSH_HashWithPrefix(prefix, data2, -1, out2, sizeof (out2)) == 0);
+      TEST_CHECK(HSH_HashWithPrefix(prefix, data2, sizeof (data2), out2, -1) == 0);
+
+      k = random() % sizeof (data2);
+      TEST_CHECK(HSH_Hash(hash_id, data3, length, data2, k, out, sizeof (out)) ==
+                 tests[i].length);
+      TEST_CHECK(HSH_HashWithPrefix(prefix, data2, k, out2, sizeof (out2)) ==
+                 tests[i].length);
+      TEST_CHECK(!memcmp(out, out2, tests[i].length));
+
+      length = random() % (sizeof (out2) + 1);
+      TEST_CHECK(HSH_HashWithPrefix(prefix, data2, k, out2, length) ==
+                 MIN(length, tests[i].length));
+      TEST_CHECK(!memcmp(out, out2, MIN(length, tests[i].length)));
+
+      HSH_DestroyPrefix(prefix);
+    }
   }
 
   HSH_Finalise();
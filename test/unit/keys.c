@@ -126,6 +126,11 @@ test_unit(void)
 
     UTI_GetRandomBytes(data, sizeof (data));
 
+    TEST_CHECK(ARR_GetSize(keys) == KEYS);
+    TEST_CHECK(ARR_GetSize(key_index) >= 2 * KEYS);
+    for (j = 0; j < KEYS; j++)
+      TEST_CHECK(get_key_by_id(get_key(keys, j)->id)->id == get_key(keys, j)->id);
+
     for (j = 0; j < KEYS; j++) {
       TEST_CHECK(KEY_KeyKnown(key_ids[j]));
       TEST_CHECK(KEY_GetAuthLength(key_ids[j]) >= 16);
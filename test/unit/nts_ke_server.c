@@ -137,14 +137,58 @@ process_response(NKSN_Instance session, int valid)
   }
 }
 
+static int
+bench(char *opts, NKSN_Instance session)
+{
+  SIV_Algorithm algorithms[] = { AEAD_AES_SIV_CMAC_256, AEAD_AES_128_GCM_SIV, 0 };
+  int numbers[] = { 1, 2, 4, NKE_MAX_COOKIES, 0 };
+  NKE_Cookie cookies[NKE_MAX_COOKIES];
+  struct timespec ts_start, ts_end;
+  NKE_Context context;
+  int i, j, k, iters;
+  double time;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  printf("\n");
+
+  for (i = 0; algorithms[i] != 0; i++) {
+    if (SIV_GetKeyLength(algorithms[i]) <= 0)
+      continue;
+
+    context.algorithm = algorithms[i];
+    get_keys(session, context.algorithm, 0, NKE_NEXT_PROTOCOL_NTPV4,
+             &context.c2s, &context.s2c);
+
+    for (j = 0; numbers[j] > 0; j++) {
+      clock_gettime(CLOCK_MONOTONIC, &ts_start);
+      for (k = 0; k < iters; k++) {
+        if (!NKS_GenerateCookies(&context, cookies, numbers[j]))
+          return 0;
+      }
+      clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+      time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+      printf("%2d keys=%2d cookies=%d: %8.1f ns %8.1f ns/cookie\n",
+             (int)context.algorithm, context.c2s.length, numbers[j],
+             time * 1.0e9, time * 1.0e9 / numbers[j]);
+    }
+  }
+
+  return 1;
+}
+
 void
 test_unit(void)
 {
   NKSN_Instance session;
   NKE_Context context, context2;
-  NKE_Cookie cookie;
-  int i, j, valid, l;
+  NKE_Cookie cookie, cookies[NKE_MAX_COOKIES];
+  int i, j, n, valid, l;
   uint32_t sum, sum2;
+  char *env;
 
   char conf[][100] = {
     "ntsdumpdir .",
@@ -168,6 +212,11 @@ test_unit(void)
 
   session = NKSN_CreateInstance(1, NULL, handle_message, NULL);
 
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_NTS_KE_SERVER"))) {
+    exit(!bench(env, session));
+  }
+
   for (i = 0; i < 10000; i++) {
     valid = random() % 2;
     prepare_request(session, valid);
@@ -180,14 +229,25 @@ test_unit(void)
     context.algorithm = AEAD_AES_SIV_CMAC_256;
     get_keys(session, context.algorithm, random() % 100, NKE_NEXT_PROTOCOL_NTPV4,
              &context.c2s, &context.s2c);
-    memset(&cookie, 0, sizeof (cookie));
-    TEST_CHECK(NKS_GenerateCookie(&context, &cookie));
-    TEST_CHECK(NKS_DecodeCookie(&cookie, &context2));
-    TEST_CHECK(context.algorithm == context2.algorithm);
-    TEST_CHECK(context.c2s.length == context2.c2s.length);
-    TEST_CHECK(context.s2c.length == context2.s2c.length);
-    TEST_CHECK(memcmp(context.c2s.key, context2.c2s.key, context.c2s.length) == 0);
-    TEST_CHECK(memcmp(context.s2c.key, context2.s2c.key, context.s2c.length) == 0);
+    memset(cookies, 0, sizeof (cookies));
+    n = random() % NKE_MAX_COOKIES + 1;
+    TEST_CHECK(NKS_GenerateCookies(&context, cookies, n));
+
+    for (j = 0; j < n; j++) {
+      TEST_CHECK(NKS_DecodeCookie(&cookies[j], &context2));
+      TEST_CHECK(context.algorithm == context2.algorithm);
+      TEST_CHECK(context.c2s.length == context2.c2s.length);
+      TEST_CHECK(context.s2c.length == context2.s2c.length);
+      TEST_CHECK(memcmp(context.c2s.key, context2.c2s.key, context.c2s.length) == 0);
+      TEST_CHECK(memcmp(context.s2c.key, context2.s2c.key, context.s2c.length) == 0);
+
+      /* Each cookie has a different nonce */
+      TEST_CHECK(cookies[j].length == cookies[0].length);
+      TEST_CHECK(j == 0 || memcmp(cookies[j].cookie, cookies[j - 1].cookie,
+                                  cookies[j].length) != 0);
+    }
+
+    cookie = cookies[random() % n];
 
     if (random() % 4) {
       cookie.cookie[random() % (cookie.length)]++;
@@ -201,6 +261,9 @@ test_unit(void)
     TEST_CHECK(!NKS_DecodeCookie(&cookie, &context2));
   }
 
+  TEST_CHECK(NKS_GenerateCookies(&context, cookies, 0));
+  TEST_CHECK(!NKS_GenerateCookies(&context, cookies, NKE_MAX_COOKIES + 1));
+
   unlink("ntskeys");
   save_keys();
 
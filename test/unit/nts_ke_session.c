@@ -34,6 +34,10 @@ static unsigned char record[NKE_MAX_MESSAGE_LENGTH];
 static int record_length, critical, type_start, records;
 static int request_received;
 static int response_received;
+static unsigned char session_data[NKE_MAX_SESSION_DATA_LENGTH];
+static int session_data_length;
+static int resumed;
+static int bench_mode;
 
 static void
 send_message(NKSN_Instance inst)
@@ -48,6 +52,12 @@ send_message(NKSN_Instance inst)
   assert(sizeof (struct RecordHeader) == 4);
   records = random() % ((NKE_MAX_MESSAGE_LENGTH - 4) / (4 + record_length) + 1);
 
+  /* Use a short message similar to a real request and response */
+  if (bench_mode) {
+    record_length = 64;
+    records = 4;
+  }
+
   DEBUG_LOG("critical=%d type_start=%d records=%d*%d",
             critical, type_start, records, record_length);
 
@@ -116,7 +126,7 @@ verify_message(NKSN_Instance inst)
 
   TEST_CHECK(!NKSN_GetRecord(inst, &critical, &t, &length, buffer, sizeof (buffer)));
 
-  for (i = 0; i < 10; i++) {
+  for (i = 0; i < (bench_mode ? 1 : 10); i++) {
     TEST_CHECK(NKSN_GetKeys(inst, AEAD_AES_SIV_CMAC_256, random(), random(), &c2s, &s2c));
     TEST_CHECK(c2s.length == SIV_GetKeyLength(AEAD_AES_SIV_CMAC_256));
     TEST_CHECK(s2c.length == SIV_GetKeyLength(AEAD_AES_SIV_CMAC_256));
@@ -157,6 +167,28 @@ handle_response(void *arg)
   return 1;
 }
 
+static void
+set_server_event(int fd)
+{
+  int event = NKSN_GetEvent(server);
+
+  if (!event) {
+    SCH_RemoveFileHandler(fd);
+    close(fd);
+    return;
+  }
+
+  SCH_SetFileHandlerEvent(fd, SCH_FILE_INPUT, event == SCH_FILE_INPUT);
+  SCH_SetFileHandlerEvent(fd, SCH_FILE_OUTPUT, event == SCH_FILE_OUTPUT);
+}
+
+static void
+handle_server_event(int fd, int event, void *arg)
+{
+  NKSN_HandleEvent(server, event);
+  set_server_event(fd);
+}
+
 static void
 check_finished(void *arg)
 {
@@ -169,14 +201,130 @@ check_finished(void *arg)
   SCH_QuitProgram();
 }
 
+static void
+run_session(NKSN_Credentials server_cred, NKSN_Credentials client_cred, int manual)
+{
+  int sock_fds[2], fd;
+  NKE_Key c2s, s2c;
+  const void *data;
+
+  server = NKSN_CreateInstance(1, NULL, handle_request, NULL);
+  client = NKSN_CreateInstance(0, "test", handle_response, NULL);
+
+  if (manual)
+    NKSN_DisableScheduling(server);
+
+  if (session_data_length > 0)
+    NKSN_SetSessionData(client, session_data, session_data_length);
+
+  TEST_CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_fds) == 0);
+  TEST_CHECK(fcntl(sock_fds[0], F_SETFL, O_NONBLOCK) == 0);
+  TEST_CHECK(fcntl(sock_fds[1], F_SETFL, O_NONBLOCK) == 0);
+
+  TEST_CHECK(NKSN_StartSession(server, sock_fds[0], "client", server_cred, 4.0));
+  TEST_CHECK(NKSN_StartSession(client, sock_fds[1], "server", client_cred, 4.0));
+
+  TEST_CHECK(NKSN_GetEvent(server) == SCH_FILE_INPUT);
+
+  if (manual) {
+    TEST_CHECK(server->timeout_id == 0);
+
+    /* Use a duplicated descriptor which stays open after the session
+       is stopped */
+    fd = dup(sock_fds[0]);
+    TEST_CHECK(fd >= 0);
+    SCH_AddFileHandler(fd, SCH_FILE_INPUT, handle_server_event, NULL);
+  }
+
+  TEST_CHECK(!NKSN_GetKeys(server, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
+  TEST_CHECK(!NKSN_GetKeys(client, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
+
+  send_message(client);
+
+  request_received = response_received = 0;
+
+  check_finished(NULL);
+
+  SCH_MainLoop();
+
+  TEST_CHECK(NKSN_IsStopped(server));
+  TEST_CHECK(NKSN_IsStopped(client));
+  TEST_CHECK(NKSN_GetEvent(server) == 0);
+
+  TEST_CHECK(!NKSN_GetKeys(server, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
+  TEST_CHECK(!NKSN_GetKeys(client, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
+
+  TEST_CHECK(request_received);
+  TEST_CHECK(response_received);
+
+  TEST_CHECK(NKSN_IsResumed(server) == NKSN_IsResumed(client));
+  resumed = NKSN_IsResumed(client);
+
+  /* Save the new ticket for the next session */
+  session_data_length = NKSN_GetSessionData(client, &data);
+  TEST_CHECK(session_data_length >= 0 && session_data_length <= sizeof (session_data));
+  memcpy(session_data, data, session_data_length);
+
+  NKSN_DestroyInstance(server);
+  NKSN_DestroyInstance(client);
+}
+
+static double
+get_cpu_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+  return UTI_TimespecToDouble(&ts);
+}
+
+static int
+bench(char *opts, NKSN_Credentials server_cred, NKSN_Credentials client_cred,
+      unsigned char *ticket_key)
+{
+  double start_time;
+  int i, j, iters, n;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  bench_mode = 1;
+
+  for (i = 0; i < 2; i++) {
+    NKSN_SetServerTickets(ticket_key, i ? 100 : 0);
+    session_data_length = 0;
+
+    for (j = n = 0, start_time = 0.0; j <= iters; j++) {
+      /* Don't include the first session getting the first ticket */
+      if (j == 1)
+        start_time = get_cpu_time();
+
+      SCH_Initialise();
+      run_session(server_cred, client_cred, 0);
+      SCH_Finalise();
+
+      if (j > 0)
+        n += resumed;
+    }
+
+    printf("%s session: %.1f us CPU time (%d resumed)\n", i ? "Resumed" : "Full",
+           (get_cpu_time() - start_time) / iters * 1.0e6, n);
+  }
+
+  return 1;
+}
+
 void
 test_unit(void)
 {
+  unsigned char ticket_key[NKSN_TICKET_KEY_LENGTH];
   NKSN_Credentials client_cred, server_cred;
   const char *cert, *key;
-  int sock_fds[2], i;
+  int i, tickets, prev_ticket;
   uint32_t cert_id;
-  NKE_Key c2s, s2c;
+  char *env;
 
   LCL_Initialise();
   TST_RegisterDummyDrivers();
@@ -185,46 +333,36 @@ test_unit(void)
   key = "nts_ke.key";
   cert_id = 0;
 
+  UTI_GetRandomBytes(ticket_key, sizeof (ticket_key));
+
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_NTS_KE_SESSION"))) {
+    server_cred = NKSN_CreateServerCertCredentials(&cert, &key, 1);
+    client_cred = NKSN_CreateClientCertCredentials(&cert, &cert_id, 1, 0);
+    exit(!bench(env, server_cred, client_cred, ticket_key));
+  }
+
+  session_data_length = 0;
+
   for (i = 0; i < 50; i++) {
     SCH_Initialise();
 
-    server = NKSN_CreateInstance(1, NULL, handle_request, NULL);
-    client = NKSN_CreateInstance(0, "test", handle_response, NULL);
+    /* Enable session tickets in some iterations */
+    tickets = i / 2 % 2;
+    NKSN_SetServerTickets(ticket_key, tickets ? 100 : 0);
+    prev_ticket = session_data_length > 0;
 
     server_cred = NKSN_CreateServerCertCredentials(&cert, &key, 1);
     client_cred = NKSN_CreateClientCertCredentials(&cert, &cert_id, 1, 0);
     TEST_CHECK(server_cred);
     TEST_CHECK(client_cred);
 
-    TEST_CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_fds) == 0);
-    TEST_CHECK(fcntl(sock_fds[0], F_SETFL, O_NONBLOCK) == 0);
-    TEST_CHECK(fcntl(sock_fds[1], F_SETFL, O_NONBLOCK) == 0);
-
-    TEST_CHECK(NKSN_StartSession(server, sock_fds[0], "client", server_cred, 4.0));
-    TEST_CHECK(NKSN_StartSession(client, sock_fds[1], "server", client_cred, 4.0));
-
-    TEST_CHECK(!NKSN_GetKeys(server, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
-    TEST_CHECK(!NKSN_GetKeys(client, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
-
-    send_message(client);
-
-    request_received = response_received = 0;
-
-    check_finished(NULL);
-
-    SCH_MainLoop();
-
-    TEST_CHECK(NKSN_IsStopped(server));
-    TEST_CHECK(NKSN_IsStopped(client));
-
-    TEST_CHECK(!NKSN_GetKeys(server, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
-    TEST_CHECK(!NKSN_GetKeys(client, AEAD_AES_SIV_CMAC_256, 0, 0, &c2s, &s2c));
-
-    TEST_CHECK(request_received);
-    TEST_CHECK(response_received);
+    /* Handle the server events outside of the session in some iterations */
+    run_session(server_cred, client_cred, i % 2);
 
-    NKSN_DestroyInstance(server);
-    NKSN_DestroyInstance(client);
+    /* A ticket is used only once and resumption needs the server key */
+    TEST_CHECK(resumed == (tickets && prev_ticket));
+    TEST_CHECK((session_data_length > 0) == tickets);
 
     NKSN_DestroyCertCredentials(server_cred);
     NKSN_DestroyCertCredentials(client_cred);
@@ -32,12 +32,13 @@ void
 test_unit(void)
 {
   unsigned char key[SIV_MAX_KEY_LENGTH], nonce[256], plaintext[256], plaintext2[256];
-  NTP_PacketInfo info;
-  NTP_Packet packet;
+  unsigned char *buffer;
+  NTP_PacketInfo info, info2;
+  NTP_Packet packet, packet2;
   SIV_Algorithm algo;
   SIV_Instance siv;
   int i, j, r, packet_length, nonce_length, key_length;
-  int plaintext_length, plaintext2_length, min_ef_length;
+  int plaintext_length, plaintext2_length, min_ef_length, ef_start;
 
   TEST_CHECK(get_padding_length(0) == 0);
   TEST_CHECK(get_padding_length(1) == 3);
@@ -85,6 +86,8 @@ test_unit(void)
       memset(&info, 0, sizeof (info));
       info.version = 4;
       info.length = packet_length;
+      packet2 = packet;
+      info2 = info;
 
       DEBUG_LOG("packet_length=%d nonce_length=%d plaintext_length=%d min_ef_length=%d",
                 packet_length, nonce_length, plaintext_length, min_ef_length);
@@ -121,6 +124,19 @@ test_unit(void)
                  get_padded_length(MAX(MIN(16, SIV_GetMaxNonceLength(siv)), nonce_length)) +
                  get_padded_length(plaintext_length) + SIV_GetTagLength(siv));
 
+      /* Plaintext written to the packet and encrypted in place */
+      r = NNA_AddAuthEF(&packet2, &info2, siv, nonce, nonce_length, plaintext_length,
+                        min_ef_length, &ef_start, &buffer);
+      TEST_CHECK(r);
+      TEST_CHECK(ef_start == packet_length);
+      TEST_CHECK(buffer > (unsigned char *)&packet2 + ef_start &&
+                 buffer + plaintext_length <= (unsigned char *)&packet2 + info2.length);
+      memcpy(buffer, plaintext, plaintext_length);
+      r = NNA_EncryptAuthEF(&packet2, &info2, siv, ef_start);
+      TEST_CHECK(r);
+      TEST_CHECK(info2.length == info.length && info2.ext_fields == info.ext_fields);
+      TEST_CHECK(memcmp(&packet, &packet2, sizeof (packet)) == 0);
+
       r = NNA_DecryptAuthEF(&packet, &info, siv, packet_length, plaintext2,
                             -1, &plaintext2_length);
       TEST_CHECK(!r);
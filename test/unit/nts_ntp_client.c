@@ -32,6 +32,10 @@
 #define NKC_Start(inst) (random() % 2)
 #define NKC_IsActive(inst) (random() % 2)
 #define NKC_GetRetryFactor(inst) (1)
+#define NKC_SetSessionData(inst, data, length)
+
+static int get_session_data(NKC_Instance inst, const void **data);
+#define NKC_GetSessionData get_session_data
 
 static int get_nts_data(NKC_Instance inst, NKE_Context *context, NKE_Context *alt_context,
                         NKE_Cookie *cookies, int *num_cookies, int max_cookies,
@@ -82,6 +86,17 @@ get_nts_data(NKC_Instance inst, NKE_Context *context, NKE_Context *alt_context,
   return 1;
 }
 
+static int
+get_session_data(NKC_Instance inst, const void **data)
+{
+  static unsigned char session_data[100];
+
+  memset(session_data, random(), sizeof (session_data));
+  *data = session_data;
+
+  return random() % (sizeof (session_data) + 1);
+}
+
 static int
 get_request(NNC_Instance inst)
 {
@@ -110,6 +125,7 @@ get_request(NNC_Instance inst)
 
   TEST_CHECK(inst->num_cookies > 0);
   TEST_CHECK(inst->siv);
+  TEST_CHECK(!inst->nke);
 
   switch (inst->context.algorithm) {
     case AEAD_AES_SIV_CMAC_256:
@@ -275,6 +291,8 @@ test_unit(void)
         TEST_CHECK(!NNC_CheckResponseAuth(inst, &packet, &info));
         TEST_CHECK(inst->nak_response);
         TEST_CHECK(!inst->ok_response);
+        TEST_CHECK(inst->nke || can_switch_keys(inst) ||
+                   SCH_GetLastEventMonoTime() < inst->next_nke_attempt);
       }
     }
 
@@ -46,7 +46,7 @@ prepare_request(NTP_Packet *packet, NTP_PacketInfo *info, int valid, int nak)
   assert(context.s2c.length <= sizeof (context.s2c.key));
   UTI_GetRandomBytes(&context.s2c.key, context.s2c.length);
 
-  TEST_CHECK(NKS_GenerateCookie(&context, &cookie));
+  TEST_CHECK(NKS_GenerateCookies(&context, &cookie, 1));
 
   UTI_GetRandomBytes(uniq_id, sizeof (uniq_id));
   UTI_GetRandomBytes(nonce, sizeof (nonce));
@@ -97,6 +97,26 @@ prepare_request(NTP_Packet *packet, NTP_PacketInfo *info, int valid, int nak)
                               4 + random() % 16]++;
 }
 
+static void
+get_cookie(NTP_Packet *packet, NTP_PacketInfo *info, NKE_Cookie *cookie)
+{
+  int parsed, ef_length, ef_type, ef_body_length;
+  void *ef_body;
+
+  for (parsed = NTP_HEADER_LENGTH; parsed < info->length; parsed += ef_length) {
+    TEST_CHECK(NEF_ParseField(packet, info->length, parsed,
+                              &ef_length, &ef_type, &ef_body, &ef_body_length));
+    if (ef_type != NTP_EF_NTS_COOKIE)
+      continue;
+    TEST_CHECK(ef_body_length <= sizeof (cookie->cookie));
+    memcpy(cookie->cookie, ef_body, ef_body_length);
+    cookie->length = ef_body_length;
+    return;
+  }
+
+  TEST_CHECK(0);
+}
+
 static void
 init_response(NTP_Packet *packet, NTP_PacketInfo *info)
 {
@@ -108,13 +128,70 @@ init_response(NTP_Packet *packet, NTP_PacketInfo *info)
   info->length = NTP_HEADER_LENGTH;
 }
 
+static void
+process_requests(NTP_Packet *requests, NTP_PacketInfo *infos, int n, int iters,
+                 const char *name)
+{
+  struct timespec ts_start, ts_end;
+  NTP_PacketInfo res_info;
+  NTP_Packet response;
+  double time;
+  uint32_t kod;
+  int i;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+  for (i = 0; i < iters; i++) {
+    TEST_CHECK(NNS_CheckRequestAuth(&requests[i % n], &infos[i % n], &kod));
+    init_response(&response, &res_info);
+    TEST_CHECK(NNS_GenerateResponseAuth(&requests[i % n], &infos[i % n],
+                                        &response, &res_info, kod));
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+  time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+  printf("%s: %.3f us (%.0f requests/s)\n", name, time * 1.0e6, 1.0 / time);
+}
+
+static int
+bench(char *opts)
+{
+  NTP_PacketInfo *infos;
+  NTP_Packet *requests;
+  int i, iters, n;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  /* Use more requests than cached contexts to not hit the cache */
+  n = 16 * MAX_CACHED_CONTEXTS;
+  requests = MallocArray(NTP_Packet, n);
+  infos = MallocArray(NTP_PacketInfo, n);
+
+  for (i = 0; i < n; i++)
+    prepare_request(&requests[i], &infos[i], 1, 0);
+
+  printf("\n");
+  process_requests(requests, infos, n, iters, "New cookies");
+  process_requests(requests, infos, 16, iters, "Reused cookies");
+
+  Free(requests);
+  Free(infos);
+
+  return 1;
+}
+
 void
 test_unit(void)
 {
-  NTP_PacketInfo req_info, res_info;
-  NTP_Packet request, response;
+  NTP_PacketInfo req_info, res_info, prev_req_info;
+  NTP_Packet request, response, prev_request;
+  NKE_Cookie cookie;
   int i, valid, nak;
   uint32_t kod;
+  char *env;
 
   char conf[][100] = {
     "ntsport 0",
@@ -134,10 +211,40 @@ test_unit(void)
   NKS_Initialise();
   NNS_Initialise();
 
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_NTS_NTP_SERVER"))) {
+    exit(!bench(env));
+  }
+
+  prev_req_info.length = 0;
+
   for (i = 0; i < 50000; i++) {
     valid = random() % 2;
     nak = random() % 2;
-    prepare_request(&request, &req_info, valid, nak);
+
+    /* Repeat some valid requests to use the cached contexts */
+    if (prev_req_info.length > 0 && random() % 2) {
+      valid = 1;
+      nak = 0;
+      request = prev_request;
+      req_info = prev_req_info;
+
+      get_cookie(&request, &req_info, &cookie);
+
+      /* The contexts are dropped when a server key changes */
+      if (random() % 10 == 0) {
+        server->key_generation--;
+        TEST_CHECK(!is_cached_context(get_cached_context(cookie.cookie, cookie.length),
+                                      cookie.cookie, cookie.length));
+      } else {
+        TEST_CHECK(is_cached_context(get_cached_context(cookie.cookie, cookie.length),
+                                   cookie.cookie, cookie.length));
+      }
+    } else {
+      prepare_request(&request, &req_info, valid, nak);
+    }
+
+    prev_req_info.length = 0;
 
     TEST_CHECK(NNS_CheckRequestAuth(&request, &req_info, &kod) == (valid && !nak));
 
@@ -150,6 +257,13 @@ test_unit(void)
 
       TEST_CHECK(res_info.ext_fields == 2);
       TEST_CHECK(server->num_cookies == 0);
+
+      get_cookie(&request, &req_info, &cookie);
+      TEST_CHECK(is_cached_context(get_cached_context(cookie.cookie, cookie.length),
+                                   cookie.cookie, cookie.length));
+
+      prev_request = request;
+      prev_req_info = req_info;
     } else if (valid && nak) {
       TEST_CHECK(kod == NTP_KOD_NTS_NAK);
       TEST_CHECK(server->num_cookies == 0);
@@ -0,0 +1,172 @@
+/*
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+ */
+
+#include <config.h>
+#include "test.h"
+
+#include <reference.c>
+
+static void
+set_random_state(struct timespec *now)
+{
+  are_we_synchronised = random() % 4 != 0;
+  UTI_AddDoubleToTimespec(now, -(random() % 10000) / 10.0, &our_ref_time);
+  if (random() % 10 == 0)
+    UTI_ZeroTimespec(&our_ref_time);
+  our_stratum = random() % 16 + 1;
+  our_ref_id = random();
+  our_leap_status = random() % 4;
+  our_root_delay = (random() % 1000) * 1.0e-4;
+  our_root_dispersion = (random() % 1000) * 1.0e-4;
+  our_skew = (random() % 1000) * 1.0e-8;
+  our_residual_freq = (random() % 1000 - 500) * 1.0e-8;
+
+  enable_local_stratum = random() % 2;
+  local_stratum = random() % 15 + 1;
+  local_distance = (random() % 100) * 1.0e-3;
+  local_activate = 0.0;
+  local_activate_ok = 0;
+  local_wait_synced = random() % 1000;
+  local_wait_unsynced = random() % 2 ? 0.0 : 1.0e9;
+  UTI_ZeroTimespec(&local_ref_time);
+}
+
+static int
+bench(char *opts)
+{
+  struct timespec ts, ts_start, ts_end;
+  double root_delay, root_dispersion, sum;
+  int i, iters, synchronised, stratum;
+  REF_ServerState state;
+  uint32_t ref_id;
+  NTP_Leap leap;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  LCL_ReadCookedTime(&ts, NULL);
+  are_we_synchronised = 1;
+  enable_local_stratum = 0;
+  our_ref_time = ts;
+  publish_server_state(&ts);
+
+  sum = 0.0;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+  for (i = 0; i < iters; i++) {
+    REF_GetReferenceParams(&ts, &synchronised, &leap, &stratum, &ref_id, &state.ref_time,
+                           &root_delay, &root_dispersion);
+    sum += root_dispersion + LCL_GetSysPrecisionAsLog();
+    UTI_AddDoubleToTimespec(&ts, 1.0e-6, &ts);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+  printf("\nREF_GetReferenceParams(): %.3f ns\n",
+         UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters * 1.0e9);
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+  for (i = 0; i < iters; i++) {
+    REF_GetServerState(&ts, &state);
+    sum += REF_GetServerRootDispersion(&state, &ts) + state.precision;
+    UTI_AddDoubleToTimespec(&ts, 1.0e-6, &ts);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+  printf("REF_GetServerState(): %.3f ns\n",
+         UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters * 1.0e9);
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+  for (i = 0; i < iters; i++) {
+    REF_ReadServerState(&state);
+    sum += REF_GetServerRootDispersion(&state, &ts) + state.precision;
+    UTI_AddDoubleToTimespec(&ts, 1.0e-6, &ts);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+  printf("REF_ReadServerState(): %.3f ns\n",
+         UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters * 1.0e9);
+
+  return sum != 0.0;
+}
+
+void
+test_unit(void)
+{
+  double root_delay, root_dispersion;
+  int i, j, synchronised, stratum;
+  REF_ServerState state, state2;
+  struct timespec now, ref_time;
+  uint32_t ref_id;
+  NTP_Leap leap;
+  char *env;
+
+  CNF_Initialise(0, 0);
+  LCL_Initialise();
+  TST_RegisterDummyDrivers();
+  SCH_Initialise();
+  REF_Initialise();
+
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_REFERENCE"))) {
+    exit(!bench(env));
+  }
+
+  for (i = 0; i < 1000; i++) {
+    DEBUG_LOG("iteration %d", i);
+
+    LCL_ReadCookedTime(&now, NULL);
+    UTI_AddDoubleToTimespec(&now, random() % 100000, &now);
+
+    set_random_state(&now);
+    publish_server_state(&now);
+
+    for (j = 0; j < 100; j++) {
+      UTI_AddDoubleToTimespec(&now, (random() % 100000) / 1000.0, &now);
+
+      REF_GetServerState(&now, &state);
+      REF_GetReferenceParams(&now, &synchronised, &leap, &stratum, &ref_id, &ref_time,
+                             &root_delay, &root_dispersion);
+
+      TEST_CHECK(state.synchronised == synchronised);
+      TEST_CHECK(state.leap == leap);
+      TEST_CHECK(state.stratum == stratum);
+      TEST_CHECK(state.ref_id == ref_id);
+      TEST_CHECK(UTI_CompareTimespecs(&state.ref_time, &ref_time) == 0);
+      TEST_CHECK(state.root_delay == root_delay);
+      TEST_CHECK(fabs(REF_GetServerRootDispersion(&state, &now) - root_dispersion) <
+                 1.0e-12 + root_dispersion * 1.0e-12);
+      TEST_CHECK(state.precision == LCL_GetSysPrecisionAsLog());
+
+      REF_ReadServerState(&state2);
+      TEST_CHECK(memcmp(&state, &state2, sizeof (state)) == 0);
+    }
+  }
+
+  REF_Finalise();
+  SCH_Finalise();
+  LCL_Finalise();
+  CNF_Finalise();
+}
@@ -22,13 +22,192 @@
 
 #define POINTS 64
 
+/* Original implementation of RGR_FindBestRegression() recomputing
+   the regression for each starting index */
+static int
+find_best_regression_ref(double *x, double *y, double *w, int n, int m, int min_samples,
+                         double *b0, double *b1, double *s2, double *sb0, double *sb1,
+                         int *new_start, int *n_runs, int *dof)
+{
+  double P, Q, U, V, W; /* total */
+  double resid[MAX_POINTS * REGRESS_RUNS_RATIO];
+  double ss;
+  double a, b, u, ui, aa;
+
+  int start, resid_start, nruns, npoints;
+  int i;
+
+  assert(n <= MAX_POINTS && m >= 0);
+  assert(n * REGRESS_RUNS_RATIO < sizeof (critical_runs) / sizeof (critical_runs[0]));
+
+  if (n < MIN_SAMPLES_FOR_REGRESS) {
+    return 0;
+  }
+
+  start = 0;
+  do {
+
+    W = U = 0;
+    for (i=start; i<n; i++) {
+      U += x[i]        / w[i];
+      W += 1.0         / w[i];
+    }
+
+    u = U / W;
+
+    P = Q = V = 0.0;
+    for (i=start; i<n; i++) {
+      ui = x[i] - u;
+      P += y[i]        / w[i];
+      Q += y[i] * ui   / w[i];
+      V += ui   * ui   / w[i];
+    }
+
+    b = Q / V;
+    a = (P / W) - (b * u);
+
+    /* Get residuals also for the extra samples before start */
+    resid_start = n - (n - start) * REGRESS_RUNS_RATIO;
+    if (resid_start < -m)
+      resid_start = -m;
+
+    for (i=resid_start; i<n; i++) {
+      resid[i - resid_start] = y[i] - a - b*x[i];
+    }
+
+    /* Count number of runs */
+    nruns = n_runs_from_residuals(resid, n - resid_start); 
+
+    if (nruns > critical_runs[n - resid_start] ||
+        n - start <= MIN_SAMPLES_FOR_REGRESS ||
+        n - start <= min_samples) {
+      if (start != resid_start) {
+        /* Ignore extra samples in returned nruns */
+        nruns = n_runs_from_residuals(resid + (start - resid_start), n - start);
+      }
+      break;
+    } else {
+      /* Try dropping one sample at a time until the runs test passes. */
+      ++start;
+    }
+
+  } while (1);
+
+  /* Work out statistics from full dataset */
+  *b1 = b;
+  *b0 = a;
+
+  ss = 0.0;
+  for (i=start; i<n; i++) {
+    ss += resid[i - resid_start]*resid[i - resid_start] / w[i];
+  }
+
+  npoints = n - start;
+  ss /= (double)(npoints - 2);
+  *sb1 = sqrt(ss / V);
+  aa = u * (*sb1);
+  *sb0 = sqrt((ss / W) + (aa * aa));
+  *s2 = ss * (double) npoints / W;
+
+  *new_start = start;
+  *dof = npoints - 2;
+  *n_runs = nruns;
+
+  return 1;
+
+}
+
+static int
+is_close(double v1, double v2, double tolerance)
+{
+  return fabs(v1 - v2) <= 1e-9 * fabs(v2) + tolerance;
+}
+
+static void
+check_best_regression(double *x, double *y, double *w, int n, int m, int min_samples)
+{
+  double r1[5], r2[5];
+  int i1[3], i2[3], ret1, ret2;
+
+  ret1 = RGR_FindBestRegression(x, y, w, n, m, min_samples, &r1[0], &r1[1], &r1[2],
+                                &r1[3], &r1[4], &i1[0], &i1[1], &i1[2]);
+  ret2 = find_best_regression_ref(x, y, w, n, m, min_samples, &r2[0], &r2[1], &r2[2],
+                                  &r2[3], &r2[4], &i2[0], &i2[1], &i2[2]);
+  TEST_CHECK(ret1 == ret2);
+  if (!ret1)
+    return;
+
+  DEBUG_LOG("start=%d/%d runs=%d/%d b1=%e/%e", i1[0], i2[0], i1[1], i2[1], r1[1], r2[1]);
+
+  TEST_CHECK(memcmp(i1, i2, sizeof (i1)) == 0);
+  /* The regression coefficients can differ more if the fit is poor */
+  TEST_CHECK(is_close(r1[0], r2[0], 1e-6 * r2[3]));
+  TEST_CHECK(is_close(r1[1], r2[1], 1e-6 * r2[4]));
+  TEST_CHECK(is_close(r1[2], r2[2], 0.0));
+  TEST_CHECK(is_close(r1[3], r2[3], 0.0));
+  TEST_CHECK(is_close(r1[4], r2[4], 0.0));
+}
+
+static int
+bench(char *opts)
+{
+  double x[MAX_POINTS], y[MAX_POINTS], w[MAX_POINTS];
+  double b0, b1, s2, sb0, sb1, sum, time;
+  struct timespec ts_start, ts_end;
+  int i, j, iters, best_start, runs, dof;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  for (i = 0; i < MAX_POINTS; i++) {
+    x[i] = i - MAX_POINTS;
+    y[i] = 0.0;
+    w[i] = TST_GetRandomDouble(1.0, 2.0);
+  }
+
+  printf("\n");
+
+  for (j = 0; j < 2; j++) {
+    sum = 0.0;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    for (i = 0; i < iters; i++) {
+      /* Noise with few sign changes to make the runs test fail */
+      y[i % MAX_POINTS] = (i / 8 % 2 ? 1.0 : -1.0) * TST_GetRandomDouble(0.5, 1.0);
+      if (j == 0)
+        RGR_FindBestRegression(x, y, w, MAX_POINTS, 0, 6, &b0, &b1, &s2, &sb0, &sb1,
+                               &best_start, &runs, &dof);
+      else
+        find_best_regression_ref(x, y, w, MAX_POINTS, 0, 6, &b0, &b1, &s2, &sb0, &sb1,
+                                 &best_start, &runs, &dof);
+      sum += b0 + best_start;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+    time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+    printf("%-24s %10.1f ns  %12.0f/s (%e)\n",
+           j == 0 ? "RGR_FindBestRegression" : "reference", time * 1.0e9, 1.0 / time, sum);
+  }
+
+  return 1;
+}
+
 void
 test_unit(void)
 {
   double x[POINTS], x2[POINTS], y[POINTS], w[POINTS];
   double b0, b1, b2, s2, sb0, sb1, slope, slope2, intercept, sd, median;
   double xrange, yrange, wrange, x2range;
-  int i, j, n, m, c1, c2, c3, runs, best_start, dof;
+  int i, j, k, n, m, c1, c2, c3, runs, best_start, dof;
+  char *env;
+
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_REGRESS"))) {
+    exit(!bench(env));
+  }
 
   for (n = 3; n <= POINTS; n++) {
     for (i = 0; i < 200; i++) {
@@ -61,6 +240,8 @@ test_unit(void)
         TEST_CHECK(fabs(b1 - slope) < sd);
       }
 
+      check_best_regression(x, y, w, n, 0, 3);
+
       if (RGR_MultipleRegress(x, x2, y, n, &b2)) {
         DEBUG_LOG("MR b2=%e", b2);
         TEST_CHECK(fabs(b2 - slope2) < 1e-6);
@@ -110,10 +291,41 @@ test_unit(void)
       if (RGR_FindBestRegression(x + m, y + m, w, n - m, m, 3, &b0, &b1, &s2, &sb0, &sb1,
                                  &best_start, &runs, &dof))
         ;
+      check_best_regression(x + m, y + m, w, n - m, m, random() % 8);
+
+      /* Make long runs to drop samples */
+      for (j = 0, k = random() % 8 + 1; j < n; j++)
+        y[j] = (j / k % 2 ? 1.0 : -1.0) * TST_GetRandomDouble(0.0, yrange);
+      check_best_regression(x + m, y + m, w, n - m, m, random() % 8);
       if (RGR_MultipleRegress(x, x2, y, n, &b2))
         ;
       if (RGR_FindBestRobustRegression(x, y, n, 1e-8, &b0, &b1, &runs, &best_start))
         ;
     }
   }
+
+  for (i = 0; i < 100; i++) {
+    static double lx[2 * RGR_MAX_POINTS], ly[2 * RGR_MAX_POINTS], lw[RGR_MAX_POINTS];
+
+    n = random() % (RGR_MAX_POINTS - POINTS) + POINTS + 1;
+    m = random() % n;
+
+    DEBUG_LOG("iteration %d n=%d m=%d", i, n, m);
+
+    for (j = 0, k = random() % 100 + 1; j < n + m; j++) {
+      lx[j] = j;
+      ly[j] = (j / k % 2 ? 1.0 : -1.0) * TST_GetRandomDouble(0.0, 1.0);
+      if (j < n)
+        lw[j] = TST_GetRandomDouble(1.0, 2.0);
+    }
+
+    TEST_CHECK(RGR_FindBestRegression(lx + m, ly + m, lw, n, m, 3, &b0, &b1, &s2, &sb0, &sb1,
+                                      &best_start, &runs, &dof));
+    DEBUG_LOG("BR runs=%d bs=%d dof=%d", runs, best_start, dof);
+
+    /* The oldest points are dropped in steps */
+    TEST_CHECK(best_start == n - 3 || best_start % ((n + 63) / 64) == 0);
+    TEST_CHECK(dof == n - best_start - 2);
+    TEST_CHECK(m > 0 || best_start == n - 3 || runs > get_critical_runs(n - best_start));
+  }
 }
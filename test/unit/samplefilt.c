@@ -25,6 +25,97 @@
 
 #include <samplefilt.c>
 
+static int
+compare_doubles(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* Compare the selected samples with a selection from sorted offsets */
+static void
+check_selection(SPF_Instance filter)
+{
+  double offsets[MAX_SAMPLES], selected_offsets[MAX_SAMPLES], min_dispersion;
+  int i, j, n, from;
+
+  n = select_samples(filter);
+
+  if (filter->used < filter->min_samples) {
+    TEST_CHECK(n == 0);
+    return;
+  }
+
+  for (i = 0; i < n; i++) {
+    selected_offsets[i] = filter->samples[filter->selected[i]].offset;
+    TEST_CHECK(i == 0 || UTI_CompareTimespecs(&filter->samples[filter->selected[i - 1]].time,
+                                              &filter->samples[filter->selected[i]].time) < 0);
+  }
+
+  for (i = 0, min_dispersion = DBL_MAX; i < filter->used; i++)
+    min_dispersion = MIN(min_dispersion, filter->samples[i].peer_dispersion);
+
+  for (i = j = 0; i < filter->used; i++) {
+    if (filter->used > 4 && filter->samples[i].peer_dispersion <= 1.5 * min_dispersion)
+      offsets[j++] = filter->samples[i].offset;
+  }
+
+  if (j < 4) {
+    for (j = 0; j < filter->used; j++)
+      offsets[j] = filter->samples[j].offset;
+  }
+
+  from = j > 2 ? CLAMP(1, (int)(j * (1.0 - filter->combine_ratio) / 2.0), (j - 1) / 2) : 0;
+
+  qsort(offsets, j, sizeof (offsets[0]), compare_doubles);
+  qsort(selected_offsets, n, sizeof (selected_offsets[0]), compare_doubles);
+
+  TEST_CHECK(n == j - 2 * from);
+  TEST_CHECK(!memcmp(selected_offsets, offsets + from, sizeof (offsets[0]) * n));
+}
+
+static int
+bench(char *opts)
+{
+  struct timespec ts_start, ts_end;
+  NTP_Sample sample_in, sample_out;
+  SPF_Instance filter;
+  int i, j, iters;
+  double time;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  /* A refclock polled at 64 Hz with a 256-sample filter */
+  filter = SPF_CreateInstance(256, 256, 0.0, 0.6);
+  memset(&sample_in, 0, sizeof (sample_in));
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+  for (i = 0; i < iters; i++) {
+    for (j = 0; j < 256; j++) {
+      UTI_AddDoubleToTimespec(&sample_in.time, 1.0 / 64, &sample_in.time);
+      sample_in.offset = TST_GetRandomDouble(-1.0e-6, 1.0e-6);
+      sample_in.peer_dispersion = TST_GetRandomDouble(1.0e-7, 1.2e-7);
+      SPF_AccumulateSample(filter, &sample_in);
+    }
+    if (!SPF_GetFilteredSample(filter, &sample_out))
+      return 0;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+  time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+  printf("\n%.1f ns per filtered sample, %.1f ns per accumulated sample\n",
+         time * 1.0e9, time / 256 * 1.0e9);
+
+  SPF_DestroyInstance(filter);
+
+  return 1;
+}
+
 void
 test_unit(void)
 {
@@ -32,9 +123,15 @@ test_unit(void)
   SPF_Instance filter;
   int i, j, k, sum_count, min_samples, max_samples;
   double mean, combine_ratio, sum_err;
+  char *env;
 
   LCL_Initialise();
 
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_SAMPLEFILT"))) {
+    exit(!bench(env));
+  }
+
   memset(&sample_in, 0, sizeof (sample_in));
   memset(&sample_out, 0, sizeof (sample_out));
 
@@ -77,6 +174,8 @@ test_unit(void)
         if (k + 1 < min_samples)
           TEST_CHECK(!SPF_GetFilteredSample(filter, &sample_out));
 
+        check_selection(filter);
+
         TEST_CHECK(SPF_GetNumberOfSamples(filter) == MIN(k + 1, max_samples));
       }
 
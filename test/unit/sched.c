@@ -0,0 +1,244 @@
+/*
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+ */
+
+#include <config.h>
+#include "test.h"
+
+#include <sched.c>
+
+#define MAX_REF_ENTRIES 1000
+
+/* Reference implementation of the timer queue as a sorted list */
+
+typedef struct {
+  struct timespec ts;
+  SCH_TimeoutClass class;
+  SCH_TimeoutID id;
+} RefEntry;
+
+static RefEntry ref_queue[MAX_REF_ENTRIES];
+static int ref_size;
+
+static int dispatched[MAX_REF_ENTRIES];
+static int n_dispatched;
+
+static void
+ref_insert(int pos, struct timespec *ts, SCH_TimeoutClass class, SCH_TimeoutID id)
+{
+  TEST_CHECK(ref_size < MAX_REF_ENTRIES);
+  memmove(&ref_queue[pos + 1], &ref_queue[pos], sizeof (RefEntry) * (ref_size - pos));
+  ref_queue[pos].ts = *ts;
+  ref_queue[pos].class = class;
+  ref_queue[pos].id = id;
+  ref_size++;
+}
+
+static void
+ref_add_timeout(struct timespec *ts, SCH_TimeoutID id)
+{
+  int i;
+
+  for (i = 0; i < ref_size; i++) {
+    if (UTI_CompareTimespecs(ts, &ref_queue[i].ts) == -1)
+      break;
+  }
+
+  ref_insert(i, ts, SCH_ReservedTimeoutValue, id);
+}
+
+static double
+ref_get_class_delay(struct timespec *now, double min_delay, double separation,
+                    SCH_TimeoutClass class)
+{
+  double diff, new_min_delay;
+  int i;
+
+  new_min_delay = min_delay;
+
+  diff = UTI_DiffTimespecsToDouble(now, &last_class_dispatch[class]);
+  if (diff < separation && diff >= 0.0 && diff + new_min_delay < separation) {
+    new_min_delay = separation - diff;
+  }
+
+  for (i = 0; i < ref_size; i++) {
+    if (ref_queue[i].class != class)
+      continue;
+    diff = UTI_DiffTimespecsToDouble(&ref_queue[i].ts, now);
+    if (new_min_delay > diff) {
+      if (new_min_delay - diff < separation) {
+        new_min_delay = diff + separation;
+      }
+    } else {
+      if (diff - new_min_delay < separation) {
+        new_min_delay = diff + separation;
+      }
+    }
+  }
+
+  return new_min_delay;
+}
+
+static void
+ref_add_timeout_in_class(struct timespec *now, double delay, SCH_TimeoutClass class,
+                         SCH_TimeoutID id)
+{
+  struct timespec ts;
+  int i;
+
+  for (i = 0; i < ref_size; i++) {
+    if (UTI_DiffTimespecsToDouble(&ref_queue[i].ts, now) > delay)
+      break;
+  }
+
+  UTI_AddDoubleToTimespec(now, delay, &ts);
+  ref_insert(i, &ts, class, id);
+}
+
+static void
+ref_remove_timeout(int pos)
+{
+  memmove(&ref_queue[pos], &ref_queue[pos + 1], sizeof (RefEntry) * (ref_size - pos - 1));
+  ref_size--;
+}
+
+static void
+check_queues(void)
+{
+  TimerQueueEntry **heap, **tqes;
+  unsigned int i, j, n;
+
+  heap = ARR_GetElements(timer_heap);
+  TEST_CHECK(ARR_GetSize(timer_heap) == ref_size);
+  TEST_CHECK(n_timer_queue_entries == ref_size);
+
+  for (i = 0; i < ARR_GetSize(timer_heap); i++) {
+    TEST_CHECK(heap[i]->heap_index == i);
+    TEST_CHECK(find_tqe(heap[i]->id) == heap[i]);
+    if (i > 0)
+      TEST_CHECK(!is_tqe_earlier(heap[i], heap[(i - 1) / HEAP_ARITY]));
+  }
+
+  for (i = 0; i < SCH_NumberOfClasses; i++) {
+    tqes = ARR_GetElements(class_queues[i]);
+    for (j = n = 0; j < ref_size; j++) {
+      if (ref_queue[j].class == i && i != SCH_ReservedTimeoutValue)
+        n++;
+    }
+
+    TEST_CHECK(ARR_GetSize(class_queues[i]) == n);
+    for (j = 1; j < n; j++)
+      TEST_CHECK(is_tqe_earlier(tqes[j - 1], tqes[j]));
+  }
+}
+
+static void
+handle_timeout(void *arg)
+{
+  TEST_CHECK(n_dispatched < MAX_REF_ENTRIES);
+  dispatched[n_dispatched++] = (uintptr_t)arg;
+}
+
+void
+test_unit(void)
+{
+  struct timespec now, ts;
+  double delay, separation, delay2;
+  SCH_TimeoutClass class;
+  SCH_TimeoutID id;
+  int i, j, k;
+
+  LCL_Initialise();
+  TST_RegisterDummyDrivers();
+
+  for (i = 0; i < 100; i++) {
+    SCH_Initialise();
+
+    /* Use whole seconds to get exact differences and many ties */
+    LCL_ReadRawTime(&now);
+    now.tv_sec -= 100000;
+    now.tv_nsec = 0;
+
+    for (j = 0; j < SCH_NumberOfClasses; j++) {
+      last_class_dispatch[j] = now;
+      last_class_dispatch[j].tv_sec -= random() % 10;
+    }
+
+    ref_size = 0;
+
+    for (j = 0; j < 500; j++) {
+      switch (random() % 4) {
+        case 0:
+          ts = now;
+          ts.tv_sec += random() % 100;
+          id = SCH_AddTimeout(&ts, handle_timeout, NULL);
+          TEST_CHECK(id > 0);
+          ref_add_timeout(&ts, id);
+          break;
+        case 1:
+        case 2:
+          class = random() % (SCH_NumberOfClasses - 1) + 1;
+          delay = random() % 100;
+          separation = random() % 10;
+          delay2 = get_class_delay(&now, delay, separation, class);
+          TEST_CHECK(delay2 == ref_get_class_delay(&now, delay, separation, class));
+          UTI_AddDoubleToTimespec(&now, delay2, &ts);
+          id = add_tqe(&ts, class, handle_timeout, NULL);
+          TEST_CHECK(id > 0);
+          ref_add_timeout_in_class(&now, delay2, class, id);
+          break;
+        case 3:
+          if (ref_size == 0)
+            break;
+          k = random() % ref_size;
+          SCH_RemoveTimeout(ref_queue[k].id);
+          ref_remove_timeout(k);
+          break;
+      }
+
+      if (random() % 100 == 0) {
+        delay = random() % 21 - 10;
+        handle_slew(&now, &now, 0.0, delay, LCL_ChangeStep, NULL);
+        for (k = 0; k < ref_size; k++)
+          UTI_AddDoubleToTimespec(&ref_queue[k].ts, -delay, &ref_queue[k].ts);
+      }
+
+      check_queues();
+    }
+
+    /* All timeouts are in the past and should be dispatched in the same
+       order as the reference list */
+    for (j = 0; j < ref_size; j++)
+      find_tqe(ref_queue[j].id)->arg = (void *)(uintptr_t)j;
+
+    n_dispatched = 0;
+    dispatch_timeouts(&ts);
+
+    TEST_CHECK(n_dispatched == ref_size);
+    for (j = 0; j < n_dispatched; j++)
+      TEST_CHECK(dispatched[j] == j);
+
+    TEST_CHECK(n_timer_queue_entries == 0);
+    for (j = 0; j < SCH_NumberOfClasses; j++)
+      TEST_CHECK(ARR_GetSize(class_queues[j]) == 0);
+
+    SCH_Finalise();
+  }
+
+  LCL_Finalise();
+}
@@ -22,6 +22,10 @@
 #include <sysincl.h>
 #include <logging.h>
 #include <siv.h>
+#ifdef HAVE_SIV_AESNI
+#include <siv_aesni.h>
+#endif
+#include <util.h>
 #include "test.h"
 
 #ifdef HAVE_SIV
@@ -40,6 +44,130 @@ struct siv_test {
   int ciphertext_length;
 };
 
+static double
+get_time_per_iter(struct timespec *ts_start, int iters)
+{
+  struct timespec ts_end;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+  return UTI_DiffTimespecsToDouble(&ts_end, ts_start) / iters;
+}
+
+static void
+print_bench(SIV_Algorithm algorithm, const char *operation, int assoc_length,
+            int plaintext_length, double time)
+{
+  printf("%2d %-8s assoc=%4d plaintext=%4d: %8.1f ns %10.0f ops/s\n",
+         (int)algorithm, operation, assoc_length, plaintext_length,
+         time * 1.0e9, 1.0 / time);
+}
+
+static int
+bench(char *opts)
+{
+  SIV_Algorithm algorithms[] = { AEAD_AES_SIV_CMAC_256, AEAD_AES_128_GCM_SIV, 0 };
+  /* Lengths of NTS extension fields (unique identifier and cookies) */
+  int ef_lengths[] = { 100, 500, 1000, 0 };
+  unsigned char key[SIV_MAX_KEY_LENGTH], nonce[16], assoc[1048];
+  unsigned char plaintext[1000], ciphertext[1000 + SIV_MAX_TAG_LENGTH];
+  unsigned char ciphertexts[8][2 * SIV_MAX_KEY_LENGTH + SIV_MAX_TAG_LENGTH];
+  unsigned char nonces[8][16], *ciphertext_ptrs[8];
+  const unsigned char *nonce_ptrs[8];
+  int i, j, k, iters, key_length, tag_length, nonce_length, sum;
+  struct timespec ts_start;
+  SIV_Instance siv;
+  double time;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  memset(key, 1, sizeof (key));
+  memset(nonce, 2, sizeof (nonce));
+  memset(assoc, 3, sizeof (assoc));
+  memset(plaintext, 4, sizeof (plaintext));
+  sum = 0;
+
+  printf("\n");
+
+  for (i = 0; algorithms[i] != 0; i++) {
+    key_length = SIV_GetKeyLength(algorithms[i]);
+    if (key_length <= 0)
+      continue;
+
+    siv = SIV_CreateInstance(algorithms[i]);
+    if (!siv)
+      return 0;
+
+    tag_length = SIV_GetTagLength(siv);
+    nonce_length = MIN(SIV_GetMaxNonceLength(siv), sizeof (nonce));
+
+    /* Server sets the key from the cookie for each request */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    for (k = 0; k < iters; k++) {
+      key[0] = k;
+      sum += SIV_SetKey(siv, key, key_length);
+    }
+    time = get_time_per_iter(&ts_start, iters);
+    print_bench(algorithms[i], "setkey", 0, 0, time);
+
+    /* Cookie with the client's C2S and S2C keys */
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    for (k = 0; k < iters; k++) {
+      sum += SIV_Encrypt(siv, nonce, nonce_length, "", 0, plaintext, 2 * key_length,
+                         ciphertext, 2 * key_length + tag_length);
+      nonce[0] = ciphertext[0];
+    }
+    time = get_time_per_iter(&ts_start, iters);
+    print_bench(algorithms[i], "cookie", 0, 2 * key_length, time);
+
+    /* Eight cookies encrypted together */
+    for (j = 0; j < 8; j++) {
+      memset(nonces[j], j, sizeof (nonces[j]));
+      nonce_ptrs[j] = nonces[j];
+      ciphertext_ptrs[j] = ciphertexts[j];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    for (k = 0; k < iters; k++) {
+      sum += SIV_EncryptMultiple(siv, 8, nonce_ptrs, nonce_length, "", 0,
+                                 plaintext, 2 * key_length,
+                                 ciphertext_ptrs, 2 * key_length + tag_length);
+      nonces[0][0] = ciphertexts[7][0];
+    }
+    time = get_time_per_iter(&ts_start, iters) / 8;
+    print_bench(algorithms[i], "cookie/8", 0, 2 * key_length, time);
+
+    for (j = 0; ef_lengths[j] > 0; j++) {
+      /* Request authenticating the header, unique identifier and cookie */
+      if (!SIV_Encrypt(siv, nonce, nonce_length, assoc, 48 + ef_lengths[j], "", 0,
+                       ciphertext, tag_length))
+        return 0;
+
+      clock_gettime(CLOCK_MONOTONIC, &ts_start);
+      for (k = 0; k < iters; k++)
+        sum += SIV_Decrypt(siv, nonce, nonce_length, assoc, 48 + ef_lengths[j],
+                           ciphertext, tag_length, plaintext, 0);
+      time = get_time_per_iter(&ts_start, iters);
+      print_bench(algorithms[i], "request", 48 + ef_lengths[j], 0, time);
+
+      /* Response with encrypted cookies */
+      clock_gettime(CLOCK_MONOTONIC, &ts_start);
+      for (k = 0; k < iters; k++) {
+        sum += SIV_Encrypt(siv, nonce, nonce_length, assoc, 48 + 36, plaintext, ef_lengths[j],
+                           ciphertext, ef_lengths[j] + tag_length);
+        nonce[0] = ciphertext[0];
+      }
+      time = get_time_per_iter(&ts_start, iters);
+      print_bench(algorithms[i], "response", 48 + 36, ef_lengths[j], time);
+    }
+
+    SIV_DestroyInstance(siv);
+  }
+
+  return sum != 0;
+}
+
 void
 test_unit(void)
 {
@@ -201,8 +329,18 @@ test_unit(void)
 
   unsigned char plaintext[sizeof (((struct siv_test *)NULL)->plaintext)];
   unsigned char ciphertext[sizeof (((struct siv_test *)NULL)->ciphertext)];
+  unsigned char ciphertexts[7][sizeof (((struct siv_test *)NULL)->ciphertext)];
+  unsigned char nonces[7][sizeof (((struct siv_test *)NULL)->nonce)];
+  unsigned char *ciphertext_ptrs[7];
+  const unsigned char *nonce_ptrs[7];
   SIV_Instance siv;
-  int i, j, r, fixed_nonce_length;
+  int i, j, r, fixed_nonce_length, offset;
+  char *env;
+
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_SIV"))) {
+    exit(!bench(env));
+  }
 
   for (i = 0; i < AEAD_AES_256_GCM_SIV + 10; i++) {
     switch (i) {
@@ -214,6 +352,12 @@ test_unit(void)
     TEST_CHECK(SIV_CreateInstance(i) == NULL);
   }
 
+#ifdef HAVE_SIV_AESNI
+  /* The test vectors need to be checked with the AES-NI implementation */
+  if (SIVA_IsSupported())
+    TEST_CHECK(SIV_GetKeyLength(AEAD_AES_128_GCM_SIV) == SIVA_KEY_LENGTH);
+#endif
+
   for (i = 0; tests[i].algorithm != 0; i++) {
     DEBUG_LOG("testing %d (%d)", (int)tests[i].algorithm, i);
 
@@ -285,6 +429,50 @@ test_unit(void)
 #endif
     TEST_CHECK(memcmp(ciphertext, tests[i].ciphertext, tests[i].ciphertext_length) == 0);
 
+    offset = SIV_GetInPlaceOffset(siv);
+    TEST_CHECK(offset == -1 || offset == 0 || offset == SIV_GetTagLength(siv));
+    if (offset >= 0) {
+      memset(ciphertext, 0, sizeof (ciphertext));
+      memcpy(ciphertext + offset, tests[i].plaintext, tests[i].plaintext_length);
+      r = SIV_Encrypt(siv, tests[i].nonce, tests[i].nonce_length,
+                      tests[i].assoc, tests[i].assoc_length,
+                      ciphertext + offset, tests[i].plaintext_length,
+                      ciphertext, tests[i].ciphertext_length);
+      TEST_CHECK(r);
+      TEST_CHECK(memcmp(ciphertext, tests[i].ciphertext, tests[i].ciphertext_length) == 0);
+    }
+
+    /* Multiple messages differing in the nonce are encrypted as separate
+       messages */
+    for (j = 0; j < 7; j++) {
+      memcpy(nonces[j], tests[i].nonce, tests[i].nonce_length);
+      nonces[j][0] ^= j;
+      nonce_ptrs[j] = nonces[j];
+      ciphertext_ptrs[j] = ciphertexts[j];
+    }
+
+    r = SIV_EncryptMultiple(siv, 7, nonce_ptrs, tests[i].nonce_length,
+                            tests[i].assoc, tests[i].assoc_length,
+                            tests[i].plaintext, tests[i].plaintext_length,
+                            ciphertext_ptrs, tests[i].ciphertext_length);
+    TEST_CHECK(r);
+    TEST_CHECK(memcmp(ciphertexts[0], tests[i].ciphertext, tests[i].ciphertext_length) == 0);
+
+    for (j = 0; j < 7; j++) {
+      r = SIV_Encrypt(siv, nonces[j], tests[i].nonce_length,
+                      tests[i].assoc, tests[i].assoc_length,
+                      tests[i].plaintext, tests[i].plaintext_length,
+                      ciphertext, tests[i].ciphertext_length);
+      TEST_CHECK(r);
+      TEST_CHECK(memcmp(ciphertext, ciphertexts[j], tests[i].ciphertext_length) == 0);
+    }
+
+    r = SIV_EncryptMultiple(siv, 7, nonce_ptrs, tests[i].nonce_length,
+                            tests[i].assoc, tests[i].assoc_length,
+                            tests[i].plaintext, tests[i].plaintext_length,
+                            ciphertext_ptrs, tests[i].ciphertext_length - 1);
+    TEST_CHECK(!r);
+
     for (j = -1; j < tests[i].nonce_length; j++) {
       r = SIV_Encrypt(siv, tests[i].nonce, j,
                       tests[i].assoc, tests[i].assoc_length,
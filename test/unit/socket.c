@@ -58,8 +58,10 @@ test_preinitialise(void)
 static void
 send_and_recv(int type, int is_stream, int is_client_bound, int server_fd, int client_fd)
 {
-  SCK_Message *msg1, msg2;
-  char buf1[16], buf2[16];
+  int i, j, n, max, batch, received, fail, sent[MAX_SEND_MESSAGES * 2];
+  SCK_Message *msg1, msg2, msgs[MAX_SEND_MESSAGES * 2];
+  char buf1[16], buf2[16], bufs[MAX_SEND_MESSAGES * 2][16];
+  static char big_buf[1 << 20];
 
   TEST_CHECK(!SCK_IsReusable(server_fd));
   TEST_CHECK(!SCK_IsReusable(client_fd));
@@ -96,6 +98,50 @@ send_and_recv(int type, int is_stream, int is_client_bound, int server_fd, int c
   TEST_CHECK(SCK_SendMessage(server_fd, &msg2, 0));
   TEST_CHECK(SCK_Receive(client_fd, buf1, sizeof (buf1), 0) == sizeof (buf1));
   TEST_CHECK(memcmp(buf1, buf2, sizeof (buf1)) == 0);
+
+  if (is_stream)
+    return;
+
+  n = random() % (MAX_SEND_MESSAGES * 2) + 1;
+
+  /* Make one of the messages too long to be sent */
+  fail = random() % 2 ? random() % n : -1;
+
+  for (i = 0; i < n; i++) {
+    msgs[i] = msg2;
+    msgs[i].data = bufs[i];
+    msgs[i].length = sizeof (bufs[i]);
+    UTI_GetRandomBytes(bufs[i], sizeof (bufs[i]));
+    if (i == fail) {
+      msgs[i].data = big_buf;
+      msgs[i].length = sizeof (big_buf);
+    }
+  }
+
+  TEST_CHECK(SCK_SendMessages(server_fd, msgs, n, 0, sent) == n - (fail >= 0));
+
+  for (i = j = 0; i < n; i++) {
+    TEST_CHECK(sent[i] == (i != fail));
+    if (sent[i])
+      memmove(bufs[j++], bufs[i], sizeof (bufs[i]));
+  }
+  n = j;
+
+  max = SCK_SetMaxReceiveMessages(random() % (MAX_RECV_MESSAGES + 10));
+  TEST_CHECK(max >= 1 && max <= MAX_RECV_MESSAGES);
+
+  for (i = 0; i < n; i += received) {
+    /* Don't request more messages than available to not block */
+    batch = MIN(max, n - i);
+    batch = random() % batch + 1;
+    msg1 = SCK_ReceiveMessages(client_fd, 0, batch, &received);
+    TEST_CHECK(msg1);
+    TEST_CHECK(received >= 1 && received <= batch);
+    for (j = 0; j < received; j++) {
+      TEST_CHECK(msg1[j].length == sizeof (bufs[i + j]));
+      TEST_CHECK(memcmp(msg1[j].data, bufs[i + j], sizeof (bufs[i + j])) == 0);
+    }
+  }
 }
 
 void
@@ -32,6 +32,25 @@ create_source(SRC_Type type, IPAddr *addr, int authenticated, int sel_options)
                                SRC_DEFAULT_MAXUNREACH);
 }
 
+/* Compare the incrementally sorted endpoints with qsort() */
+static void
+check_sort_list(void)
+{
+  struct Sort_Element list[3 * 16];
+  int i;
+
+  TEST_CHECK(n_sorted_endpoints <= sizeof (list) / sizeof (list[0]));
+  memcpy(list, sort_list, n_sorted_endpoints * sizeof (list[0]));
+  qsort(list, n_sorted_endpoints, sizeof (list[0]), compare_sort_elements);
+
+  for (i = 0; i < n_sorted_endpoints; i++) {
+    TEST_CHECK(list[i].offset == sort_list[i].offset);
+    TEST_CHECK(list[i].tag == sort_list[i].tag);
+    TEST_CHECK(sort_list[i].index >= 0 && sort_list[i].index < n_sources);
+    TEST_CHECK(sources[sort_list[i].index]->status >= SRC_UNTRUSTED);
+  }
+}
+
 void
 test_unit(void)
 {
@@ -97,6 +116,7 @@ test_unit(void)
 
         SRC_SelectSource(srcs[k]);
         DEBUG_LOG("source %d status %c", k, get_status_char(sources[k]->status));
+        check_sort_list();
 
         for (l = 0; l <= j; l++) {
           TEST_CHECK(sources[l]->status > SRC_OK && sources[l]->status <= SRC_SELECTED);
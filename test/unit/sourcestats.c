@@ -0,0 +1,152 @@
+/*
+ **********************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ **********************************************************************
+ */
+
+#include <sourcestats.c>
+#include "test.h"
+
+static void
+get_sample(NTP_Sample *sample, double offset, double freq, double jitter)
+{
+  double delay;
+
+  UTI_AddDoubleToTimespec(&sample->time, TST_GetRandomDouble(1.0, 16.0), &sample->time);
+  delay = TST_GetRandomDouble(1.0e-4, 1.0e-3);
+  sample->offset = offset + freq * UTI_TimespecToDouble(&sample->time) +
+                   TST_GetRandomDouble(-jitter, jitter);
+  sample->peer_delay = delay;
+  sample->peer_dispersion = TST_GetRandomDouble(1.0e-6, 1.0e-5);
+  sample->root_delay = delay + 1.0e-3;
+  sample->root_dispersion = 1.0e-4;
+}
+
+static void
+check_buffers(SST_Stats inst)
+{
+  double times_back[MAX_SAMPLES * REGRESS_RUNS_RATIO];
+  int i, j, min_j;
+
+  convert_to_intervals(inst, times_back + inst->runs_samples);
+
+  for (i = -inst->runs_samples, min_j = -1; i < inst->n_samples; i++) {
+    j = get_runsbuf_index(inst, i);
+    TEST_CHECK(times_back[i + inst->runs_samples] ==
+               UTI_DiffTimespecsToDouble(&inst->sample_times[j],
+                                         &inst->sample_times[inst->last_sample]));
+    if (min_j < 0 || inst->peer_delays[j] < inst->peer_delays[min_j])
+      min_j = j;
+  }
+
+  TEST_CHECK(inst->min_delay_sample == min_j);
+}
+
+static int bench_sizes[] = { 64, 512, 4096, 0 };
+
+static int
+bench(char *opts)
+{
+  struct timespec ts_start, ts_end;
+  NTP_Sample sample;
+  SST_Stats inst;
+  int i, j, iters;
+  double time;
+
+  iters = atoi(opts);
+  if (iters <= 0)
+    return 0;
+
+  printf("\n");
+
+  for (i = 0; bench_sizes[i] > 0; i++) {
+    inst = SST_CreateInstance(1, NULL, bench_sizes[i], bench_sizes[i], 0.0, 1.0);
+    memset(&sample, 0, sizeof (sample));
+    sample.time.tv_sec = 1000000;
+
+    /* Fill the history */
+    for (j = 0; j < bench_sizes[i]; j++) {
+      get_sample(&sample, 0.0, 0.0, 1.0e-4);
+      SST_AccumulateSample(inst, &sample);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    for (j = 0; j < iters; j++) {
+      get_sample(&sample, 0.0, 0.0, 1.0e-4);
+      SST_AccumulateSample(inst, &sample);
+      SST_DoNewRegression(inst);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+    time = UTI_DiffTimespecsToDouble(&ts_end, &ts_start) / iters;
+    printf("%4d samples: %10.1f ns (%d kept)\n", bench_sizes[i], time * 1.0e9,
+           SST_Samples(inst));
+
+    SST_DeleteInstance(inst);
+  }
+
+  return 1;
+}
+
+void
+test_unit(void)
+{
+  double offset, freq;
+  NTP_Sample sample;
+  SST_Stats inst;
+  int i, j, max_samples;
+  char *env;
+
+  CNF_Initialise(0, 0);
+  LCL_Initialise();
+  SST_Initialise();
+
+  /* Expected format of the variable: ITERS */
+  if ((env = getenv("BENCH_SOURCESTATS"))) {
+    exit(!bench(env));
+  }
+
+  for (i = 0; i < 100; i++) {
+    max_samples = random() % (i % 10 ? DEFAULT_MAX_SAMPLES : MAX_SAMPLES) + 1;
+    offset = TST_GetRandomDouble(-1.0, 1.0);
+    freq = TST_GetRandomDouble(-1.0e-4, 1.0e-4);
+
+    DEBUG_LOG("iteration %d max_samples=%d offset=%e freq=%e", i, max_samples, offset, freq);
+
+    inst = SST_CreateInstance(1, NULL, 3, max_samples, 0.0, 1.0);
+    memset(&sample, 0, sizeof (sample));
+    sample.time.tv_sec = random() % 1000000;
+
+    for (j = 0; j < 1000; j++) {
+      get_sample(&sample, offset, freq, 1.0e-6);
+      SST_AccumulateSample(inst, &sample);
+      SST_DoNewRegression(inst);
+      check_buffers(inst);
+    }
+
+    /* The sign of the offset is flipped in the stats */
+    if (max_samples >= 8)
+      TEST_CHECK(fabs(inst->estimated_frequency + freq) < 1.0e-6);
+
+    SST_DeleteInstance(inst);
+  }
+
+  SST_Finalise();
+  LCL_Finalise();
+  CNF_Finalise();
+}
@@ -33,6 +33,9 @@ typedef struct TLS_Instance_Record *TLS_Instance;
 
 typedef void *TLS_Credentials;
 
+/* Length of the key encrypting session tickets */
+#define TLS_TICKET_KEY_LENGTH 64
+
 typedef enum {
   /* TLS operation succeeded */
   TLS_SUCCESS,
@@ -85,6 +88,21 @@ extern int TLS_CheckPending(TLS_Instance inst);
 /* Perform TLS shutdown */
 extern TLS_Status TLS_Shutdown(TLS_Instance inst);
 
+/* Enable session tickets in a server instance using a key of
+   TLS_TICKET_KEY_LENGTH bytes and set their lifetime (in seconds) */
+extern int TLS_EnableServerTickets(TLS_Instance inst, const unsigned char *key, int lifetime);
+
+/* Set data of a previous session to be resumed by a client instance */
+extern int TLS_SetSessionData(TLS_Instance inst, const void *data, int length);
+
+/* Get data for resumption of the session by a client if a session ticket
+   was received.  The function returns the length of the data, or zero if
+   not available or longer than the buffer. */
+extern int TLS_GetSessionData(TLS_Instance inst, void *data, int length);
+
+/* Check if the session was resumed */
+extern int TLS_IsResumed(TLS_Instance inst);
+
 /* Export key from TLS instance */
 extern int TLS_ExportKey(TLS_Instance inst, int label_length, const char *label,
                          int context_length, const void *context, int key_length,
@@ -178,7 +178,10 @@ TLS_CreateInstance(int server_mode, int sock_fd, const char *server_name, const
   inst->label = Strdup(label);
   inst->alpn_name = Strdup(alpn_name);
 
-  r = gnutls_init(&inst->session, GNUTLS_NONBLOCK | GNUTLS_NO_TICKETS |
+  /* Session tickets are issued only if enabled by
+     TLS_EnableServerTickets() and used only if provided by
+     TLS_SetSessionData() */
+  r = gnutls_init(&inst->session, GNUTLS_NONBLOCK |
                                   (server_mode ? GNUTLS_SERVER : GNUTLS_CLIENT));
   if (r < 0) {
     LOG(LOGS_ERR, "Could not %s TLS session : %s", "create", gnutls_strerror(r));
@@ -405,6 +408,87 @@ TLS_Shutdown(TLS_Instance inst)
 
 /* ================================================== */
 
+int
+TLS_EnableServerTickets(TLS_Instance inst, const unsigned char *key, int lifetime)
+{
+  gnutls_datum_t datum;
+  int r;
+
+  assert(inst->server);
+
+  datum.data = (unsigned char *)key;
+  datum.size = TLS_TICKET_KEY_LENGTH;
+
+  r = gnutls_session_ticket_enable_server(inst->session, &datum);
+  if (r < 0) {
+    DEBUG_LOG("Could not enable session tickets : %s", gnutls_strerror(r));
+    return 0;
+  }
+
+  gnutls_db_set_cache_expiration(inst->session, lifetime);
+
+  return 1;
+}
+
+/* ================================================== */
+
+int
+TLS_SetSessionData(TLS_Instance inst, const void *data, int length)
+{
+  int r;
+
+  assert(!inst->server);
+
+  if (length <= 0)
+    return 0;
+
+  r = gnutls_session_set_data(inst->session, data, length);
+  if (r < 0) {
+    DEBUG_LOG("Could not set session data : %s", gnutls_strerror(r));
+    return 0;
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+int
+TLS_GetSessionData(TLS_Instance inst, void *data, int length)
+{
+  gnutls_datum_t datum;
+  int r;
+
+  if (inst->server || !(gnutls_session_get_flags(inst->session) & GNUTLS_SFLAGS_SESSION_TICKET))
+    return 0;
+
+  r = gnutls_session_get_data2(inst->session, &datum);
+  if (r < 0) {
+    DEBUG_LOG("Could not get session data : %s", gnutls_strerror(r));
+    return 0;
+  }
+
+  r = datum.size;
+  if (r > length || r <= 0)
+    r = 0;
+  else
+    memcpy(data, datum.data, r);
+
+  gnutls_free(datum.data);
+
+  return r;
+}
+
+/* ================================================== */
+
+int
+TLS_IsResumed(TLS_Instance inst)
+{
+  return gnutls_session_is_resumed(inst->session) != 0;
+}
+
+/* ================================================== */
+
 int
 TLS_ExportKey(TLS_Instance inst, int label_length, const char *label, int context_length,
               const void *context, int key_length, unsigned char *key)
@@ -613,8 +613,24 @@ UTI_AdjustTimespec(const struct timespec *old_ts, const struct timespec *when,
 
 /* ================================================== */
 
+static void
+get_random_bytes(void *buf, unsigned int len, void *arg)
+{
+  UTI_GetRandomBytes(buf, len);
+}
+
+/* ================================================== */
+
 void
 UTI_GetNtp64Fuzz(NTP_int64 *ts, int precision)
+{
+  UTI_GetNtp64FuzzFrom(ts, precision, get_random_bytes, NULL);
+}
+
+/* ================================================== */
+
+void
+UTI_GetNtp64FuzzFrom(NTP_int64 *ts, int precision, UTI_RandomFunction get_random, void *arg)
 {
   int start, bits;
 
@@ -624,7 +640,7 @@ UTI_GetNtp64Fuzz(NTP_int64 *ts, int precision)
   start = sizeof (*ts) - (precision + 32 + 7) / 8;
   ts->hi = ts->lo = 0;
 
-  UTI_GetRandomBytes((unsigned char *)ts + start, sizeof (*ts) - start);
+  get_random((unsigned char *)ts + start, sizeof (*ts) - start, arg);
 
   bits = (precision + 32) % 8;
   if (bits)
@@ -1580,6 +1596,22 @@ UTI_GetRandomBytes(void *buf, unsigned int len)
 
 /* ================================================== */
 
+void
+UTI_GetRandomBytesUnbuffered(void *buf, unsigned int len)
+{
+#ifdef HAVE_ARC4RANDOM
+  arc4random_buf(buf, len);
+#else
+#ifdef HAVE_GETRANDOM
+  if (getrandom(buf, len, GRND_NONBLOCK) == len)
+    return;
+#endif
+  UTI_GetRandomBytesUrandom(buf, len);
+#endif
+}
+
+/* ================================================== */
+
 void
 UTI_ResetGetRandomFunctions(void)
 {
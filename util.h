@@ -129,9 +129,17 @@ extern void UTI_AdjustTimespec(const struct timespec *old_ts, const struct times
                                struct timespec *new_ts, double *delta_time,
                                double dfreq, double doffset);
 
+/* Function providing random bytes */
+typedef void (*UTI_RandomFunction)(void *buf, unsigned int len, void *arg);
+
 /* Get zero NTP timestamp with random bits below precision */
 extern void UTI_GetNtp64Fuzz(NTP_int64 *ts, int precision);
 
+/* Same as UTI_GetNtp64Fuzz(), but the random bits are provided by the
+   specified function (e.g. a thread-safe one) */
+extern void UTI_GetNtp64FuzzFrom(NTP_int64 *ts, int precision,
+                                 UTI_RandomFunction get_random, void *arg);
+
 extern double UTI_Ntp32ToDouble(NTP_int32 x);
 extern NTP_int32 UTI_DoubleToNtp32(double x);
 
@@ -241,6 +249,12 @@ extern void UTI_GetRandomBytesUrandom(void *buf, unsigned int len);
    generating long-term keys */
 extern void UTI_GetRandomBytes(void *buf, unsigned int len);
 
+/* Fill buffer with random bytes from a source which doesn't keep any state
+   in this process (arc4random() or getrandom() if available), i.e. it can be
+   called from other threads than the main thread, as long as /dev/urandom
+   used as a fallback was already opened in the main thread */
+extern void UTI_GetRandomBytesUnbuffered(void *buf, unsigned int len);
+
 /* Close /dev/urandom and drop any cached data used by the GetRandom functions
    to prevent forked processes getting the same sequence of random numbers */
 extern void UTI_ResetGetRandomFunctions(void);